@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Decode.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Static analysis of a loaded ROM.
+ *
+ * Instructions are decoded with the same rules as the interpreter, starting at 0x200 and following
+ * jumps, calls and skips. This recovers which bytes are code and which are data, and splits the code
+ * into basic blocks linked by a control-flow graph.
+ *
+ * The index register is tracked inside each basic block only, so accesses through I are known when
+ * I was set by ANNN earlier in the same block.
+ */
+class Analysis {
+public:
+    /**
+     * What is known about a byte of memory, flags can be combined.
+     */
+    enum Flags : uint8_t {
+        CODE        = 1 << 0, // An instruction starts here
+        CODE_BYTE   = 1 << 1, // Part of a reachable instruction
+        DATA        = 1 << 2, // Read through I (sprites, FX65)
+        WRITTEN     = 1 << 3, // Written through I (FX33, FX55)
+        BLOCK_START = 1 << 4  // First instruction of a basic block
+    };
+
+    enum class EdgeKind : uint8_t {
+        Next,   // Falls through to the next instruction
+        Skip,   // Condition of a skip instruction is true
+        Jump,   // 1NNN
+        Call,   // 2NNN, to the subroutine
+        Return  // 2NNN, where the subroutine returns
+    };
+
+    struct Edge {
+        uint16_t target;
+        EdgeKind kind;
+    };
+
+    struct Block {
+        uint16_t start;
+        uint16_t end; // Address after the last instruction
+        std::vector<Edge> successors;
+    };
+
+    enum class FindingKind : uint8_t {
+        SelfModifyingWrite, // FX33 or FX55 writes over reachable code
+        ComputedJump,       // BNNN, the targets are unknown and not followed
+        UnreachableCode,    // ROM bytes never reached nor read, which decode as instructions
+        InvalidInstruction  // Reachable opcode that faults the core
+    };
+
+    struct Finding {
+        FindingKind kind;
+        uint16_t address; // Address of the instruction, or start of the region
+        uint16_t target;  // Start of the bytes written, or base of the computed jump
+        uint16_t size;    // Size of the bytes written or of the region
+    };
+
+    /**
+     * @brief Analyse a memory image, the ROM being size bytes at 0x200
+     */
+    static Analysis Analyze(const uint8_t memory[4096], size_t size);
+
+    /**
+     * @brief Human readable name of a finding or of an edge
+     */
+    static const char *FindingName(FindingKind kind);
+    static const char *EdgeName(EdgeKind kind);
+
+    /* Inline getters */
+
+    inline uint8_t flags(uint16_t address) const { return m_flags[address & 0xFFF]; }
+    inline bool isCode(uint16_t address) const { return flags(address) & CODE; }
+    inline const std::vector<Block> &blocks() const { return m_blocks; }
+    inline const std::vector<Finding> &findings() const { return m_findings; }
+
+    /**
+     * @brief Addresses of the reachable instructions, in increasing order
+     */
+    inline const std::vector<uint16_t> &code() const { return m_code; }
+
+private:
+    uint8_t m_flags[4096] = {};
+    std::vector<uint16_t> m_code;
+    std::vector<Block> m_blocks;
+    std::vector<Finding> m_findings;
+
+    void Explore(const uint8_t memory[4096]);
+    void BuildBlocks(const uint8_t memory[4096]);
+    void TrackIndex(const uint8_t memory[4096]);
+    void FindUnreachable(const uint8_t memory[4096], size_t size);
+};
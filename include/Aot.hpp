@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Chip8.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * A ROM translated ahead of time into C++ by chip8-aot.
+ *
+ * The generated function runs at most budget instructions from pc and returns how many it ran.
+ * It returns early, with pc on the instruction, when that instruction was not translated (the
+ * target of a computed jump, bytes the analysis did not reach) or when its page was overwritten
+ * since the game was loaded: Chip8::Run then executes it with the interpreter.
+ */
+struct AotProgram {
+    const char *name;
+    const uint8_t *image; // ROM the code was translated from, loaded at 0x200
+    size_t size;
+    const uint8_t *code;  // Bitmap of the 4096 addresses, set for the bytes of translated instructions
+    int (*run)(Chip8 &chip8, int budget);
+
+    inline bool isCode(uint16_t address) const {
+        address &= 0xFFF;
+        return (code[address >> 3] >> (address & 7)) & 1;
+    }
+};
+
+/**
+ * @brief Add a program to the list of AotPrograms, done by the generated code at static initialisation
+ */
+bool AotRegister(const AotProgram *program);
+
+/**
+ * @brief Programs linked into the executable
+ */
+const std::vector<const AotProgram *> &AotPrograms();
+
+/**
+ * Registers of the core, copied to locals by the generated code so the compiler keeps them in
+ * host registers, and written back when it returns.
+ */
+struct AotRegisters {
+    uint8_t V[16];
+    uint16_t I;
+    uint16_t pc;
+    uint16_t sp;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint16_t keys;
+};
+
+/**
+ * Access of the generated code to the core, with the same rules as EmulateCycle for memory,
+ * screen and random numbers.
+ */
+class AotMachine {
+private:
+    Chip8 &m_chip8;
+
+public:
+    explicit AotMachine(Chip8 &chip8) : m_chip8(chip8) {}
+
+    inline AotRegisters Load() const {
+        AotRegisters r;
+        memcpy(r.V, m_chip8.V, sizeof(r.V));
+        r.I = m_chip8.I;
+        r.pc = m_chip8.pc;
+        r.sp = m_chip8.sp;
+        r.delayTimer = m_chip8.delayTimer;
+        r.soundTimer = m_chip8.soundTimer;
+        r.keys = m_chip8.m_keys;
+        return r;
+    }
+
+    inline void Store(const AotRegisters &r) {
+        memcpy(m_chip8.V, r.V, sizeof(r.V));
+        m_chip8.I = r.I;
+        m_chip8.pc = r.pc;
+        m_chip8.sp = r.sp;
+        m_chip8.delayTimer = r.delayTimer;
+        m_chip8.soundTimer = r.soundTimer;
+    }
+
+    /* Inline getters */
+
+    inline uint16_t *stack() { return m_chip8.stack; }
+
+    /**
+     * @brief Whether a byte of translated code in one of the pages of mask was overwritten
+     */
+    inline bool modified(uint16_t mask) const { return m_chip8.m_modifiedCode & mask; }
+
+    inline uint8_t Read(uint16_t address) const { return m_chip8.ReadMemory(address); }
+    inline void Write(uint16_t address, uint8_t value) { m_chip8.WriteMemory(address, value); }
+    inline uint8_t Random() { return m_chip8.NextRandom(); }
+    inline void Fault(::Fault fault) { m_chip8.m_fault = fault; }
+
+    inline void Clear() {
+        memset(m_chip8.WritableScreen().pixels, 0, sizeof(Framebuffer::pixels));
+        m_chip8.drawFlag = true;
+    }
+
+    /**
+     * @brief DXYN with the sprite at i, returns VF
+     */
+    inline uint8_t Draw(uint16_t i, uint8_t vx, uint8_t vy, uint8_t height) {
+        m_chip8.I = i;
+        m_chip8.DrawSprite(vx, vy, height);
+        return m_chip8.V[0xF];
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/**
+ * Translates a ROM into a C++ translation unit defining an AotProgram, see Aot.hpp.
+ *
+ * The reachable code found by Analysis is decoded with Decode, so with the same rules as the
+ * interpreter. Every instruction becomes a case of a switch on pc, and the static control flow
+ * (1NNN, 2NNN, skips and fall-through) becomes direct gotos between the cases. 00EE and BNNN
+ * go back through the switch, which returns to the interpreter for the addresses it does not know.
+ */
+class AotTranslator {
+public:
+    struct Stats {
+        size_t instructions = 0; // Translated
+        size_t blocks = 0;
+        size_t computedJumps = 0;       // BNNN, their targets are left to the interpreter
+        size_t selfModifyingWrites = 0; // Pages they overwrite are left to the interpreter at run time
+    };
+
+    /**
+     * @brief Write the translation of the ROM of size bytes, loaded at 0x200 in memory
+     *
+     * @param symbol C++ name of the AotProgram
+     * @param name Name of the game, recorded in the program
+     */
+    static Stats Translate(std::ostream &out, const std::string &symbol, const std::string &name,
+                           const uint8_t memory[4096], size_t size);
+};
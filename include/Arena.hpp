@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+
+/**
+ * Memory region reserved once, backed by huge pages when the system allows it.
+ *
+ * Blocks are carved from the region with a bump pointer, rounded up to a cache line, and freed
+ * blocks are kept in one free list per size for reuse. Thread-safe.
+ */
+class Arena {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    enum class HugePages {
+        None,        // Regular pages
+        Transparent, // Regular mapping, the kernel was asked to back it with huge pages
+        Explicit     // Mapped from the reserved huge pages
+    };
+
+private:
+    char *m_base = nullptr;
+    size_t m_capacity = 0;
+    size_t m_top = 0;
+    size_t m_used = 0;
+    HugePages m_hugePages = HugePages::None;
+
+    // Freed blocks by size, linked through their first bytes
+    std::unordered_map<size_t, void *> m_free;
+
+    mutable std::mutex m_mutex;
+
+public:
+    /**
+     * @param capacity Bytes reserved, only the pages actually used are committed where supported
+     */
+    Arena(size_t capacity);
+    ~Arena();
+
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /**
+     * @brief Allocate a block aligned on a cache line, throw std::bad_alloc when the arena is full
+     */
+    void *Allocate(size_t size);
+
+    /**
+     * @brief Give back a block of the size it was allocated with
+     */
+    void Free(void *block, size_t size);
+
+    /* Inline getters */
+
+    inline size_t capacity() const { return m_capacity; }
+    inline HugePages hugePages() const { return m_hugePages; }
+
+    /**
+     * @brief Bytes in live blocks
+     */
+    inline size_t used() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_used;
+    }
+
+    /**
+     * @brief Bytes ever carved from the region, live or in a free list
+     */
+    inline size_t resident() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_top;
+    }
+};
+
+/**
+ * Standard allocator over an Arena, e.g. for std::allocate_shared.
+ */
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    Arena *arena;
+
+    explicit ArenaAllocator(Arena *arena) : arena(arena) {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        static_assert(alignof(T) <= Arena::ALIGNMENT, "The arena cannot align this type");
+        return static_cast<T *>(arena->Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *block, size_t n) { arena->Free(block, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const { return arena == other.arena; }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const { return arena != other.arena; }
+};
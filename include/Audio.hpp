@@ -4,13 +4,47 @@
 #include <AL/alc.h>
 #include <AL/alext.h>
 
+#include "Metrics.hpp"
+#include "StartupTrace.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+/**
+ * Beeper, opened on first use.
+ *
+ * The device is opened on a background thread, so neither the startup nor the emulation thread
+ * waits for it: a beep requested meanwhile starts once the device is ready. When the device cannot
+ * be opened, the emulator keeps running without sound.
+ */
 class Audio {
 public:
     Audio();
     ~Audio();
 
-    void playBeep() const;
-    void stopAudio() const;
+    Audio(const Audio &) = delete;
+    Audio &operator=(const Audio &) = delete;
+
+    void playBeep();
+    void stopAudio();
+
+    /**
+     * @brief Start opening the device in the background, if not started yet
+     */
+    void Open();
+
+    /* Inline setters */
+
+    /**
+     * @brief Count the underruns, nullptr to stop
+     */
+    inline void SetMetrics(Metrics *metrics) { m_metrics = metrics; }
+
+    /**
+     * @brief Time the opening of the device, nullptr to stop
+     */
+    inline void SetStartupTrace(StartupTrace *trace) { m_trace = trace; }
 
 private:
     ALuint m_source;
@@ -18,5 +52,30 @@ private:
     ALCdevice *m_device;
     ALCcontext *m_context;
 
+    std::thread m_opener;
+    std::atomic<bool> m_opening{false};
+
+    // Guards the state below against the opener thread
+    std::mutex m_mutex;
+    bool m_ready = false;
+
+    // Set between playBeep and stopAudio, the source should be playing meanwhile
+    bool m_beeping = false;
+    Metrics *m_metrics = nullptr;
+    StartupTrace *m_trace = nullptr;
+
+    /**
+     * @brief Open the device, create the source and fill its buffer, on the opener thread
+     */
+    void openDevice();
+    void closeDevice();
+
+    bool isPlaying() const;
+
+    /**
+     * @brief Count an underrun when the source stopped on its own during a beep
+     */
+    void checkUnderrun() const;
+
     void createBuffer();
-};
\ No newline at end of file
+};
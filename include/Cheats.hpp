@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Chip8.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Memory addresses frozen to a value, e.g. the lives found with a RamSearch.
+ */
+struct Cheat {
+    uint16_t address;
+    uint8_t value;
+};
+
+/**
+ * Set of cheats, written into the memory of an instance at every frame.
+ */
+class Cheats {
+private:
+    std::vector<Cheat> m_cheats;
+
+public:
+    /* Inline getters */
+
+    inline const std::vector<Cheat> &cheats() const { return m_cheats; }
+    inline bool empty() const { return m_cheats.empty(); }
+
+    /**
+     * @brief Freeze an address to a value, replacing its previous cheat if any
+     */
+    void Freeze(uint16_t address, uint8_t value);
+
+    /**
+     * @brief Let an address change again
+     */
+    void Unfreeze(uint16_t address);
+
+    /**
+     * @brief Write every frozen value, only the bytes that changed are written
+     */
+    inline void Apply(Chip8 &chip8) const {
+        for (const Cheat &cheat : m_cheats)
+            chip8.Poke(cheat.address, cheat.value);
+    }
+
+    /**
+     * @brief Parse a cheat given as "ADDRESS=VALUE" in hexadecimal, e.g. "2F0=09"
+     */
+    static Cheat Parse(const std::string &cheat);
+};
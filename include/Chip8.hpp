@@ -1,37 +1,334 @@
 #pragma once
 
-#include "Context.hpp"
-#include "Audio.hpp"
-#include "Renderer.hpp"
+#include "Framebuffer.hpp"
+#include "DecodeCache.hpp"
+#include "DecodeStore.hpp"
+#include "Arena.hpp"
 
-#include <iostream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Reasons for the core to halt.
+ */
+enum class Fault : uint8_t {
+    None,
+    UnknownOpcode,  // Including 0NNN machine code routines
+    StackOverflow,  // 2NNN with 16 return addresses already on the stack
+    StackUnderflow, // 00EE with an empty stack
+    Breakpoint,     // Reached a breakpoint, the instruction at pc is not executed yet
+    Watchpoint      // Accessed watched memory, the instruction was executed
+};
+
+/**
+ * Memory range watched by a debugger, checked by the instructions accessing memory through I.
+ */
+struct Watchpoint {
+    uint16_t address;
+    uint16_t size;
+    bool read;
+    bool write;
+};
+
+/**
+ * Copy of the whole machine state, used to rewind the core.
+ * Input and host side callbacks are not part of the state.
+ */
+struct Chip8State {
+    uint8_t memory[4096];
+    uint8_t V[16];
+    uint16_t I;
+    uint16_t pc;
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint16_t stack[16];
+    uint16_t sp;
+    Framebuffer gfx;
+    bool drawFlag;
+    uint32_t random;
+    Fault fault;
+    uint16_t carriedCycles;
+};
+
+/**
+ * A page of memory, shared between an instance and its forks until one of them writes it.
+ */
+struct MemoryPage {
+    static const int SIZE = 256;
+    static const int COUNT = 4096 / SIZE;
+
+    uint8_t bytes[SIZE];
+};
+
+struct AotProgram;
 
 /**
  * CPU core implementation.
+ * The core has no dependency on the window, OpenGL or OpenAL, so it can run on its own thread.
+ * Instances are cache line aligned, the registers filling the first line.
  */
-class Chip8 {
+class alignas(64) Chip8 {
 public:
-    Chip8(Context &context) : renderer() {}
+    /**
+     * Execution engines, they must behave exactly the same.
+     */
+    enum class Backend {
+        Switch, // Decode every instruction with a switch on the opcode
+        Cached  // Execute instructions predecoded in a DecodeCache
+    };
+
+    /**
+     * How the length of a 60 Hz frame is measured.
+     */
+    enum class Timing {
+        Instructions, // A frame runs a number of instructions, see Run
+        Vip           // A frame runs a number of machine cycles of the COSMAC VIP, see RunCycles
+    };
+
+    // Machine cycles of the COSMAC VIP in a 60 Hz frame: 1.7609 MHz, 8 clock cycles per machine cycle
+    static const int VIP_CYCLES_PER_FRAME = 3668;
+
+    Chip8() {}
 
+    /**
+     * @brief Reset the machine, must be called before anything else but Fork
+     */
     void Initialize();
+
+    /**
+     * @brief Turn child into a copy of this instance, sharing memory, screen and decode cache until written
+     *
+     * A fork costs a few reference counts instead of a full state copy. The child keeps its own
+     * sound callback, and the instances can then run on different threads, but this instance must
+     * not run while it is being forked.
+     */
+    void Fork(Chip8 &child) const;
+
+    /**
+     * @brief Load a game file, throw if it cannot be read, is empty or does not fit
+     */
     void LoadGame(const std::string &gamePath);
 
-    void Idle(Context &context);
-    void Display(Context &context);
+    /**
+     * @brief Load a game from memory, throw if it does not fit
+     *
+     * With the cached backend, the code found by a static analysis of the game is predecoded,
+     * or restored from the decode store when one is set.
+     */
+    void LoadGame(const uint8_t *data, size_t size);
 
-private:
-    void EmulateCycle(Context &context);
-    void Tick(Context &context);
+    /**
+     * @brief Execute one instruction with the selected backend
+     */
+    inline void Step() {
+        if (m_decodeCache)
+            EmulateCycleCached();
+        else
+            EmulateCycle();
+    }
 
-    Renderer renderer;
-    double m_globalTimersDelta = 0;
-    bool drawFlag = false;
+    /**
+     * @brief Execute up to instructions instructions, stopping early on a fault
+     *
+     * With a program set, the translated code runs and the backend only executes what it cannot.
+     * Breakpoints and watchpoints are not seen by translated code, so it is not used while any is set.
+     */
+    void Run(int instructions);
 
     /**
-     * Memory.
-     * The Chip 8 has 4K (= 4096 bytes) memory in total, which we can emulated with a list of 4096 uint8_t.
+     * @brief Execute the instructions of a frame of cycles machine cycles, each costing VipCycles, and return how many ran
+     *
+     * DXYN waits for the vertical blank, so it ends the frame and its cost is taken from the next
+     * one, as is the part of the cost of the last instruction beyond the frame. The cycles carried
+     * over are part of the state, so the frames only depend on the state and the keys. Translated
+     * code is not used. beforeInstruction is called with the cycles spent in the frame so far
+     * before each instruction, e.g. to apply the keys pressed by then.
+     */
+    template <typename Func>
+    int RunCycles(int cycles, Func &&beforeInstruction) {
+        int spent = m_carriedCycles;
+        int executed = 0;
+
+        while (spent < cycles && m_fault == Fault::None) {
+            beforeInstruction(spent);
+
+            const uint16_t opcode = FetchOpcode();
+            Step();
+
+            // Not executed, the core stays at the breakpoint
+            if (m_fault == Fault::Breakpoint)
+                break;
+
+            ++executed;
+            const int cost = VipCycles(opcode);
+
+            // The sprite is drawn after the vertical blank
+            if ((opcode & 0xF000) == 0xD000) {
+                m_carriedCycles = static_cast<uint16_t>(cost);
+                return executed;
+            }
+            spent += cost;
+        }
+
+        m_carriedCycles = static_cast<uint16_t>(spent > cycles ? spent - cycles : 0);
+        return executed;
+    }
+
+    inline int RunCycles(int cycles) {
+        return RunCycles(cycles, [](int) {});
+    }
+
+    /**
+     * @brief Fetch, decode and execute one instruction, nothing once the core has faulted
+     */
+    void EmulateCycle();
+
+    /**
+     * @brief Execute one instruction from the decode cache, decoding it on first use
+     */
+    void EmulateCycleCached();
+
+    /**
+     * @brief Decrement the delay and sound timers, must be called at 60 Hz
+     */
+    void Tick();
+
+    /**
+     * @brief Copy the screen into frame if it changed since the last call
+     */
+    bool Display(Framebuffer &frame);
+
+    /**
+     * @brief Save the machine state into state
+     */
+    void SaveState(Chip8State &state) const;
+
+    /**
+     * @brief Save the machine state into state, except memory and screen
+     */
+    void SaveRegisters(Chip8State &state) const;
+
+    /**
+     * @brief Restore a machine state previously saved with SaveState
+     */
+    void LoadState(const Chip8State &state);
+
+    /* Inline setters */
+
+    /**
+     * @brief Seed the random number generator used by CXNN, so runs can be reproduced
+     */
+    inline void SetSeed(uint32_t seed) { m_random = seed ? seed : 1; }
+
+    /**
+     * @brief Select the execution engine
+     */
+    void SetBackend(Backend backend);
+
+    /**
+     * @brief Parse "switch" or "cached"
+     */
+    static Backend ParseBackend(const std::string &name);
+
+    /**
+     * @brief Parse "instructions" or "vip"
+     */
+    static Timing ParseTiming(const std::string &name);
+
+    /**
+     * @brief Human readable description of a fault
+     */
+    static const char *FaultName(Fault fault);
+
+    /**
+     * @brief Run the code translated by chip8-aot in Run, nullptr to disable
+     *
+     * Throw if the loaded game is not the one the program was translated from. Pages of translated
+     * code overwritten later are left to the backend.
+     */
+    void SetProgram(const AotProgram *program);
+
+    /**
+     * @brief Keep the decoding of loaded games on disk, nullptr to disable
+     */
+    inline void SetDecodeStore(DecodeStore *store) { m_decodeStore = store; }
+
+    /**
+     * @brief Analyse and predecode loaded games with the cached backend, true by default
+     *
+     * The analysis allocates, so callers loading a game per iteration, e.g. the fuzzer, turn it off
+     * and let the instructions be decoded on first execution.
+     */
+    inline void SetPrewarm(bool enabled) { m_prewarm = enabled; }
+
+    /**
+     * @brief Allocate memory pages, screen and decode cache from arena, must be set before Initialize
+     */
+    inline void SetArena(Arena *arena) { m_arena = arena; }
+
+    /**
+     * @brief Halt with Fault::Breakpoint before executing the instruction at address, cached backend only
+     */
+    void SetBreakpoint(uint16_t address, bool enabled);
+
+    /**
+     * @brief Halt with Fault::Watchpoint after an instruction accesses one of the ranges, nullptr to disable
+     */
+    inline void SetWatchpoints(const std::vector<Watchpoint> *watchpoints) { m_watchpoints = watchpoints; }
+
+    /**
+     * @brief Clear a Breakpoint or Watchpoint fault, other faults are kept
+     */
+    inline void Resume() {
+        if (m_fault == Fault::Breakpoint || m_fault == Fault::Watchpoint)
+            m_fault = Fault::None;
+    }
+
+    inline void SetSoundFunc(const std::function<void(bool)> &func) { m_soundFunc = func; }
+    inline void SetAudioEnabled(bool enabled) { m_audioEnabled = enabled; }
+
+    /* Inline getters */
+
+    inline uint16_t keys() const { return m_keys; }
+    inline Backend backend() const { return m_decodeCache ? Backend::Cached : Backend::Switch; }
+    inline uint8_t Peek(uint16_t address) const { return ReadMemory(address); }
+    inline const Framebuffer &screen() const { return *m_screen; }
+
+    /**
+     * @brief Copy size bytes of memory from address, wrapping at the end of the 4K
+     */
+    void Peek(uint16_t address, uint8_t *bytes, size_t size) const;
+
+    /**
+     * @brief Write a byte of memory from outside, e.g. a cheat, nothing is copied when it already holds value
+     */
+    inline void Poke(uint16_t address, uint8_t value) {
+        if (ReadMemory(address) != value)
+            WriteMemory(address, value);
+    }
+    inline Fault fault() const { return m_fault; }
+
+    /**
+     * @brief First watched address accessed by the instruction that raised Fault::Watchpoint
+     */
+    inline uint16_t watchAddress() const { return m_watchAddress; }
+
+    /**
+     * @brief Set the keypad state, bit N is set while key N is pressed
+     */
+    inline void SetKeys(uint16_t keys) { m_keys = keys; }
+
+private:
+    friend class AotMachine;
+
+    /*
+     * Hot state, first cache line: everything an instruction or a scheduler scan usually touches.
+     * Memory and screen live in separately allocated pages.
      */
-    uint8_t memory[4096];
 
     /**
      * Registers.
@@ -53,6 +350,11 @@ private:
      */
     uint16_t pc;
 
+    /**
+     * Stack pointer.
+     */
+    uint16_t sp;
+
     /**
      * Delay timer.
      */
@@ -64,13 +366,162 @@ private:
      */
     uint8_t soundTimer;
 
+    /**
+     * Current key state.
+     * The Chip 8 has a HEX based keypad (0x0-0xF), stored as a 16-bit mask.
+     */
+    uint16_t m_keys = 0;
+
+    bool drawFlag = false;
+
+    // Set when the core halts, see Fault
+    Fault m_fault = Fault::None;
+
+    /**
+     * Random number generator state (xorshift32), never 0.
+     */
+    uint32_t m_random = 1;
+
     /**
      * Stack.
      */
     uint16_t stack[16];
 
+    /* Cold state */
+
     /**
-     * Stack pointer.
+     * Memory.
+     * The Chip 8 has 4K (= 4096 bytes) memory in total, which we emulate with 16 pages of 256 bytes,
+     * so the forks only copy the pages they write.
      */
-    uint16_t sp;
-};
\ No newline at end of file
+    std::shared_ptr<MemoryPage> m_pages[MemoryPage::COUNT];
+
+    /**
+     * Screen.
+     * Shared with the forks until one of them draws.
+     */
+    std::shared_ptr<Framebuffer> m_screen;
+
+    // Only allocated with the cached backend, shared with the forks until invalidated
+    std::shared_ptr<DecodeCache> m_decodeCache;
+    DecodeStore *m_decodeStore = nullptr;
+    bool m_prewarm = true;
+
+    // Where pages, screen and decode cache are allocated, the heap when null
+    Arena *m_arena = nullptr;
+
+    // Code translated ahead of time, and the pages of it overwritten since, bit N for page N
+    const AotProgram *m_program = nullptr;
+    uint16_t m_modifiedCode = 0;
+
+    // Machine cycles of the current frame already spent by RunCycles in the previous one
+    uint16_t m_carriedCycles = 0;
+
+    // Set by a debugger
+    const std::vector<Watchpoint> *m_watchpoints = nullptr;
+    uint16_t m_watchAddress = 0;
+
+    // Called with true to start the beep, false to stop it
+    std::function<void(bool)> m_soundFunc;
+    bool m_audioEnabled = true;
+
+    /**
+     * @brief Allocate a shared object from the arena of the instance, or from the heap once the arena is full
+     */
+    template <typename T, typename... Args>
+    std::shared_ptr<T> Allocate(Args &&...args) const {
+        if (m_arena) {
+            try {
+                return std::allocate_shared<T>(ArenaAllocator<T>(m_arena), std::forward<Args>(args)...);
+            } catch (const std::bad_alloc &) {
+                // Thrown before T is constructed, so args were not moved from. Each block remembers
+                // its allocator, so heap and arena blocks can be mixed
+            }
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+
+    inline uint8_t NextRandom() {
+        m_random ^= m_random << 13;
+        m_random ^= m_random >> 17;
+        m_random ^= m_random << 5;
+        return static_cast<uint8_t>(m_random >> 24);
+    }
+
+    /**
+     * @brief Read a byte of memory, addresses wrap around at 4K
+     */
+    inline uint8_t ReadMemory(uint16_t address) const {
+        return m_pages[(address >> 8) & 0xF]->bytes[address & 0xFF];
+    }
+
+    /**
+     * @brief Read the opcode at pc, with a single page lookup unless it straddles two pages
+     */
+    inline uint16_t FetchOpcode() const {
+        const uint8_t *page = m_pages[(pc >> 8) & 0xF]->bytes;
+        const int offset = pc & 0xFF;
+        if (offset != 0xFF)
+            return page[offset] << 8 | page[offset + 1];
+        return page[offset] << 8 | ReadMemory(pc + 1);
+    }
+
+    /**
+     * @brief Write a byte of memory, keeping the decode cache coherent, addresses wrap around at 4K
+     */
+    inline void WriteMemory(uint16_t address, uint8_t value) {
+        address &= 0xFFF;
+        if (m_program)
+            MarkModified(address, value);
+        WritablePage(address >> 8)[address & 0xFF] = value;
+
+        // Data writes leave a shared cache shared, only overwritten code needs a copy
+        if (m_decodeCache && m_decodeCache->Decoded(address))
+            WritableDecodeCache().Invalidate(address);
+    }
+
+    /**
+     * @brief Flag the page of address when value changes a byte of translated code
+     */
+    void MarkModified(uint16_t address, uint8_t value);
+
+    /**
+     * @brief Flag every page whose translated code differs from the program image, after a reload
+     */
+    void CheckProgram();
+
+    /**
+     * @brief Copy the whole memory into image
+     */
+    void CopyMemory(uint8_t image[4096]) const;
+
+    /**
+     * @brief Bytes of a page, copied first if it is shared with a fork
+     */
+    uint8_t *WritablePage(int index);
+
+    /**
+     * @brief Screen, copied first if it is shared with a fork
+     */
+    Framebuffer &WritableScreen();
+
+    /**
+     * @brief Decode cache, copied first if it is shared with a fork
+     */
+    DecodeCache &WritableDecodeCache();
+
+    /**
+     * @brief Raise Fault::Watchpoint if the size bytes from address are watched for this access
+     */
+    void CheckWatchpoints(uint16_t address, int size, bool write);
+
+    /**
+     * @brief Draw a sprite of height rows read from I at (vx, vy), DXYN
+     */
+    void DrawSprite(uint8_t vx, uint8_t vy, uint8_t height);
+
+    /**
+     * @brief Never called, holds the compile-time checks of the cache line layout
+     */
+    static void CheckLayout();
+};
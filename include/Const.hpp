@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+
+#define GFX_ROWS 32
+#define GFX_COLS 64
+
 const uint16_t MAX_GAME_SIZE = 0x1000 - 0x200;
 
 const uint8_t FONTSET_ADDRESS = 0x00;
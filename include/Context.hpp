@@ -6,38 +6,72 @@
 
 class Context {
 private:
-    // Timer
-    double m_deltaTime;
-
     // Window
     Window m_window;
 
-    // Input
-    KeyEvent m_keyEvent;
+    // Input, consumed by the emulation thread
+    KeyQueue m_keyQueue;
 
     // Audio
     Audio m_audio;
 
+    // CHIP-8 key sent for each key of the default layout
+    uint8_t m_keymap[16] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF};
+
+    // Set when the user asked for a screenshot
+    bool m_screenshotRequested = false;
+
+    // Metrics overlay shown on screen
+    bool m_overlayVisible = false;
+
 public:
     Context(Window &window);
     ~Context();
 
     /* Inline getters */
 
-    inline double dt() const { return m_deltaTime; }
     inline GLFWwindow *window() { return m_window.window(); }
-    inline bool key(int i) const { return m_keyEvent.key(i); }
+    inline KeyQueue &keyQueue() { return m_keyQueue; }
+    inline bool overlayVisible() const { return m_overlayVisible; }
+
+    /* Inline setters */
+
+    /**
+     * @brief Remap the keys of the default layout, keymap[i] is sent instead of key i
+     */
+    inline void SetKeymap(const uint8_t keymap[16]) {
+        for (int i = 0; i < 16; ++i)
+            m_keymap[i] = keymap[i] & 0xF;
+    }
+
+    inline void SetOverlayVisible(bool visible) { m_overlayVisible = visible; }
+    inline void SetMetrics(Metrics *metrics) { m_audio.SetMetrics(metrics); }
+    inline void SetStartupTrace(StartupTrace *trace) { m_audio.SetStartupTrace(trace); }
 
     /* Inline event call */
 
-    inline void keyDown(int keycode) { m_keyEvent.keyDown(keycode); }
-    inline void keyUp(int keycode) { m_keyEvent.keyUp(keycode); }
+    /**
+     * @brief Event call when a key is pressed
+     */
+    void keyDown(int keycode);
 
-    inline void playBeep() { m_audio.playBeep(); }
-    inline void stopAudio() { m_audio.stopAudio(); }
+    /**
+     * @brief Event call when a key is released
+     */
+    void keyUp(int keycode);
+
+    inline void requestScreenshot() { m_screenshotRequested = true; }
+    inline void toggleOverlay() { m_overlayVisible = !m_overlayVisible; }
 
     /**
-     * @brief Update the delta time
+     * @brief Return true once after each screenshot request
      */
-    void ComputeDeltaTime();
-};
\ No newline at end of file
+    inline bool takeScreenshotRequest() {
+        bool requested = m_screenshotRequested;
+        m_screenshotRequested = false;
+        return requested;
+    }
+
+    inline void playBeep() { m_audio.playBeep(); }
+    inline void stopAudio() { m_audio.stopAudio(); }
+};
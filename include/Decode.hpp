@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Operations of the Chip 8 instruction set.
+ * NONE marks a decode cache entry that was not decoded yet, BREAK an entry patched with a breakpoint.
+ */
+enum class Op : uint8_t {
+    NONE,
+    CLS,       // 00E0
+    RET,       // 00EE
+    SYS,       // 0NNN, unsupported
+    JP,        // 1NNN
+    CALL,      // 2NNN
+    SE_NN,     // 3XNN
+    SNE_NN,    // 4XNN
+    SE_VY,     // 5XY0
+    LD_NN,     // 6XNN
+    ADD_NN,    // 7XNN
+    LD_VY,     // 8XY0
+    OR,        // 8XY1
+    AND,       // 8XY2
+    XOR,       // 8XY3
+    ADD_VY,    // 8XY4
+    SUB,       // 8XY5
+    SHR,       // 8XY6
+    SUBN,      // 8XY7
+    SHL,       // 8XYE
+    SNE_VY,    // 9XY0
+    LD_I,      // ANNN
+    JP_V0,     // BNNN
+    RND,       // CXNN
+    DRW,       // DXYN
+    SKP,       // EX9E
+    SKNP,      // EXA1
+    LD_VX_DT,  // FX07
+    LD_VX_K,   // FX0A
+    LD_DT_VX,  // FX15
+    LD_ST_VX,  // FX18
+    ADD_I_VX,  // FX1E
+    LD_F_VX,   // FX29
+    LD_B_VX,   // FX33
+    LD_I_VX,   // FX55
+    LD_VX_I,   // FX65
+    INVALID,   // Unknown opcode
+    BREAK      // Breakpoint, never produced by Decode
+};
+
+/**
+ * A decoded instruction.
+ */
+struct Instruction {
+    Op op;
+    uint8_t x;   // (opcode & 0x0F00) >> 8
+    uint8_t y;   // (opcode & 0x00F0) >> 4
+    uint8_t n;   // the lowest 4 bits
+    uint8_t nn;  // the lowest 8 bits
+    uint16_t nnn; // the lowest 12 bits
+    uint16_t opcode;
+};
+
+/**
+ * @brief Decode an opcode, following the same rules as Chip8::EmulateCycle
+ */
+Instruction Decode(uint16_t opcode);
+
+/**
+ * @brief Cost of an opcode in machine cycles of the COSMAC VIP interpreter, 8 clock cycles each
+ *
+ * The costs depending on the data, e.g. a skip taken or a sprite not aligned on a byte, are
+ * averaged, so the cost only depends on the opcode. DXYN is the draw alone, without its wait for
+ * the vertical blank.
+ */
+int VipCycles(uint16_t opcode);
+
+/**
+ * @brief Return the assembly of an opcode, e.g. « LD V1, 0x2A »
+ */
+std::string Disassemble(uint16_t opcode);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Decode.hpp"
+
+#include <bitset>
+#include <vector>
+
+/**
+ * Predecoded instructions, one entry per memory address.
+ * An entry is decoded on first execution and invalidated when one of its two bytes is written.
+ *
+ * The entry at a breakpoint holds Op::BREAK instead, through invalidations too, so the core only
+ * pays for a breakpoint when it reaches it.
+ */
+struct DecodeCache {
+    Instruction entries[4096];
+
+    // Addresses patched with Op::BREAK
+    std::bitset<4096> breakpoints;
+
+    DecodeCache() { Clear(); }
+
+    /**
+     * @brief Invalidate every entry
+     */
+    void Clear() {
+        for (Instruction &entry : entries)
+            entry.op = Op::NONE;
+        ApplyBreakpoints();
+    }
+
+    /**
+     * @brief Patch the entry at address with a breakpoint, or decode it again on next use
+     */
+    void SetBreakpoint(uint16_t address, bool enabled) {
+        address &= 0xFFF;
+        breakpoints[address] = enabled;
+        entries[address].op = enabled ? Op::BREAK : Op::NONE;
+    }
+
+    /**
+     * @brief Patch the entries at breakpoints again, e.g. after they were overwritten as a whole
+     */
+    void ApplyBreakpoints() {
+        if (breakpoints.none())
+            return;
+
+        for (int address = 0; address < 4096; ++address) {
+            if (breakpoints[address])
+                entries[address].op = Op::BREAK;
+        }
+    }
+
+    /**
+     * @brief Decode ahead of time the instructions at addresses, e.g. the code found by Analysis
+     */
+    void Prewarm(const uint8_t memory[4096], const std::vector<uint16_t> &addresses) {
+        for (uint16_t address : addresses) {
+            if (!breakpoints[address & 0xFFF])
+                entries[address & 0xFFF] = Decode(memory[address & 0xFFF] << 8 | memory[(address + 1) & 0xFFF]);
+        }
+    }
+
+    /**
+     * @brief Whether Invalidate(address) would change an entry, so a shared cache is only copied when it must
+     */
+    inline bool Decoded(uint16_t address) const {
+        return !IsReset(address & 0xFFF) || !IsReset((address - 1) & 0xFFF);
+    }
+
+    /**
+     * @brief Whether Invalidate(address, size) would change an entry
+     */
+    bool Decoded(uint16_t address, size_t size) const {
+        for (size_t i = 0; i <= size; ++i) {
+            if (!IsReset((address - 1 + i) & 0xFFF))
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Invalidate the entries containing the byte at address
+     */
+    inline void Invalidate(uint16_t address) {
+        Reset(address & 0xFFF);
+        Reset((address - 1) & 0xFFF);
+    }
+
+    /**
+     * @brief Invalidate the entries containing the size bytes from address
+     */
+    void Invalidate(uint16_t address, size_t size) {
+        for (size_t i = 0; i <= size; ++i)
+            Reset((address - 1 + i) & 0xFFF);
+    }
+
+private:
+    inline bool IsReset(uint16_t address) const {
+        return entries[address].op == (breakpoints[address] ? Op::BREAK : Op::NONE);
+    }
+
+    inline void Reset(uint16_t address) {
+        entries[address].op = breakpoints[address] ? Op::BREAK : Op::NONE;
+    }
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "DecodeCache.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Persistent decode caches, one file per ROM in a directory.
+ *
+ * A file holds the decode cache of a ROM as it is right after LoadGame, so a ROM that was already
+ * loaded once starts with all of its reachable code predecoded, without running the analysis again.
+ *
+ * File format: a Header, then the 4096 entries of ENTRY_SIZE bytes each: op, x, y, n, nn, then nnn
+ * and opcode in little-endian. A file is ignored, and rewritten, when its format version, the emulator
+ * version or the ROM does not match.
+ */
+class DecodeStore {
+public:
+    static constexpr char MAGIC[8] = {'C', 'H', 'I', 'P', '8', 'D', 'C', 0};
+    static constexpr uint32_t VERSION = 2;
+
+    // Bytes of a stored entry, field by field so no padding reaches the file
+    static constexpr uint32_t ENTRY_SIZE = 9;
+
+    struct Header {
+        char magic[8];
+        uint32_t version;
+        uint32_t instructionSize; // ENTRY_SIZE, changes with the layout of the entries
+        char emulatorVersion[48];
+        uint64_t romHash;
+        uint32_t romSize;
+        uint32_t reserved;
+    };
+
+private:
+    std::string m_directory;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+
+    std::string PathOf(uint64_t hash) const;
+    static void FillHeader(Header &header, uint64_t hash, size_t size);
+
+public:
+    /**
+     * @param directory Where the caches are kept, created if needed
+     */
+    DecodeStore(const std::string &directory);
+
+    /**
+     * @brief Hash of a ROM, 64 bits FNV-1a
+     */
+    static uint64_t Hash(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Fill cache with the stored entries of a ROM, return false and leave cache untouched on a miss
+     *
+     * image is the memory with the ROM loaded, every stored entry must match its decoding or the file is a miss.
+     */
+    bool Load(const uint8_t *data, size_t size, const uint8_t image[4096], DecodeCache &cache);
+
+    /**
+     * @brief Store the entries of a ROM, a failure only costs the next start its warm-up
+     */
+    void Save(const uint8_t *data, size_t size, const DecodeCache &cache);
+
+    /* Inline getters */
+
+    inline const std::string &directory() const { return m_directory; }
+    inline uint64_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+    inline uint64_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,199 @@
+#pragma once
+
+#include "Cheats.hpp"
+#include "Chip8.hpp"
+#include "FrameDumper.hpp"
+#include "GdbStub.hpp"
+#include "Keypad.hpp"
+#include "Metrics.hpp"
+#include "Pacer.hpp"
+#include "StateExporter.hpp"
+#include "TripleBuffer.hpp"
+#include "VideoRecorder.hpp"
+
+#include <atomic>
+#include <functional>
+#include <thread>
+
+/**
+ * Drives a Chip8 core at its own clock.
+ * The core runs on a dedicated thread, so a slow buffer swap on the render thread never stalls
+ * the CPU or the timers. Finished frames are handed to the render thread through a triple buffer
+ * and timestamped key events come in through a single-producer single-consumer queue.
+ */
+class Emulator {
+private:
+    Chip8 &m_chip8;
+
+    // Keypad, fed with the key events produced by the window thread
+    Keypad m_keypad;
+
+    // Frames, consumed by the render thread
+    TripleBuffer<Framebuffer> m_frames;
+
+    // Optional recording of the published frames
+    VideoRecorder *m_recorder = nullptr;
+
+    // Optional dump of one emulated frame out of N
+    FrameDumper *m_dumper = nullptr;
+
+    // Optional instrumentation
+    Metrics *m_metrics = nullptr;
+
+    // Optional values frozen at the start of every frame
+    const Cheats *m_cheats = nullptr;
+
+    // Optional export of the state after every frame, to the slot m_stateSlot
+    StateExporter *m_stateExporter = nullptr;
+    uint32_t m_stateSlot = 0;
+
+    // Optional debugger, polled once per frame
+    GdbStub *m_debugger = nullptr;
+
+    // Called when a frame is published or the core faults, to wake the render thread
+    std::function<void(void)> m_wakeFunc;
+
+    // Schedule of the frames on the emulation thread, and frameskip
+    Pacer m_pacer;
+
+    // Last frame handed to the recorder, only the frames that differ are recorded
+    Framebuffer m_recorded;
+    bool m_recordedAny = false;
+
+    // Number of emulated frames, readable from any thread
+    std::atomic<uint64_t> m_frameCount{0};
+
+    // Number of instructions executed between two 60 Hz timer ticks, or machine cycles with the VIP timing
+    int m_cyclesPerFrame = 9;
+    Chip8::Timing m_timing = Chip8::Timing::Instructions;
+
+    // Number of frames emulated ahead of the real state before presenting
+    int m_runAheadFrames = 0;
+    Chip8State m_runAheadState;
+
+    // Time spent running ahead, in nanoseconds, and number of host frames it was spent on
+    std::atomic<uint64_t> m_runAheadTime{0};
+    std::atomic<uint64_t> m_runAheadCount{0};
+
+    // Fault of the core, readable from any thread
+    std::atomic<Fault> m_fault{Fault::None};
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    void Run();
+    void StepFrame();
+    void RunAhead();
+    void Record();
+
+    // Return whether the screen of the core was read, which clears its draw flag
+    bool Publish();
+
+public:
+    Emulator(Chip8 &chip8, KeyQueue *keyQueue = nullptr);
+    ~Emulator();
+
+    /* Inline getters */
+
+    inline int cyclesPerFrame() const { return m_cyclesPerFrame; }
+    inline Chip8::Timing timing() const { return m_timing; }
+    inline int runAheadFrames() const { return m_runAheadFrames; }
+    inline uint64_t frameCount() const { return m_frameCount.load(std::memory_order_relaxed); }
+    inline Fault fault() const { return m_fault.load(std::memory_order_relaxed); }
+    inline Pacer &pacer() { return m_pacer; }
+    inline const Pacer &pacer() const { return m_pacer; }
+
+    /**
+     * @brief Average extra time spent per host frame to run ahead, in nanoseconds
+     */
+    double runAheadCost() const;
+
+    /**
+     * @brief Last frame acquired by the render thread
+     */
+    inline const Framebuffer &frame() const { return m_frames.Front(); }
+
+    /* Inline setters */
+
+    inline void SetCyclesPerFrame(int cycles) { m_cyclesPerFrame = cycles; }
+
+    /**
+     * @brief Measure a frame in instructions or in machine cycles of the COSMAC VIP, see SetCyclesPerFrame
+     */
+    inline void SetTiming(Chip8::Timing timing) { m_timing = timing; }
+
+    /**
+     * @brief Present the state N frames in the future to hide the input latency of the ROM, 0 to disable
+     */
+    inline void SetRunAheadFrames(int frames) { m_runAheadFrames = frames; }
+
+    /**
+     * @brief Record every emulated frame that changed, even those skipped on screen, nullptr to stop recording
+     */
+    inline void SetRecorder(VideoRecorder *recorder) { m_recorder = recorder; }
+
+    /**
+     * @brief Hand every emulated frame to the dumper, even those skipped on screen, nullptr to stop
+     */
+    inline void SetDumper(FrameDumper *dumper) { m_dumper = dumper; }
+
+    /**
+     * @brief Count the instructions and frames and time them, nullptr to stop
+     */
+    inline void SetMetrics(Metrics *metrics) {
+        m_metrics = metrics;
+        m_pacer.SetMetrics(metrics);
+    }
+
+    /**
+     * @brief Write the frozen values into memory at the start of every frame, nullptr to stop
+     */
+    inline void SetCheats(const Cheats *cheats) { m_cheats = cheats; }
+
+    /**
+     * @brief Publish the state of the core to a slot of a shared memory segment after every frame, nullptr to stop
+     */
+    inline void SetStateExporter(StateExporter *exporter, uint32_t slot = 0) {
+        m_stateExporter = exporter;
+        m_stateSlot = slot;
+    }
+
+    /**
+     * @brief Hand the core to a debugger between frames when it halts or is interrupted, nullptr to stop
+     */
+    inline void SetDebugger(GdbStub *debugger) { m_debugger = debugger; }
+
+    /**
+     * @brief Called on the emulation thread when a frame is published or the core faults, so the
+     * render thread can sleep until there is something to show
+     */
+    inline void SetWakeFunc(const std::function<void(void)> &func) { m_wakeFunc = func; }
+
+    /**
+     * @brief Start the emulation thread, paced by pacer()
+     */
+    void Start();
+
+    /**
+     * @brief Stop and join the emulation thread
+     */
+    void Stop();
+
+    /**
+     * @brief Emulate one 60 Hz frame: apply pending key events, run the instructions and tick the timers
+     *
+     * The frame covers the last frame duration of the pacer, each key event is applied at the cycle
+     * boundary matching its timestamp, counted in machine cycles with the VIP timing. Frames skipped by the pacer are not handed to the render thread.
+     *
+     * With run-ahead enabled, the published frame is the one N frames later under the current input,
+     * the core is then rewound so only the first frame is kept. Dumps and recordings keep the real frame.
+     *
+     * Once the core has faulted, the frame is neither emulated nor published.
+     */
+    void RunFrame();
+
+    /**
+     * @brief Pick up the latest published frame, return false if no new frame is available
+     */
+    inline bool AcquireFrame() { return m_frames.Acquire(); }
+};
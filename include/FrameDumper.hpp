@@ -0,0 +1,90 @@
+#pragma once
+
+#include "SoftwareRenderer.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Writes frames to disk through the software renderer, either on demand or every N frames.
+ * Frames are copied into a queue and rendered and encoded on a writer thread, so neither the
+ * emulation thread nor the render thread waits for the disk unless the queue is full.
+ */
+class FrameDumper {
+public:
+    enum class Format { PPM, PNG };
+
+    // Frames queued before the producers wait for the writer
+    static const size_t MAX_QUEUED = 64;
+
+private:
+    struct Item {
+        uint64_t number;
+        Framebuffer frame;
+    };
+
+    SoftwareRenderer m_renderer;
+    std::string m_directory;
+    Format m_format;
+
+    // Dump one frame out of m_every, 0 to only dump on demand
+    uint64_t m_every;
+
+    // Frames waiting to be written, pushed by the emulation thread and the render thread
+    std::deque<Item> m_queue;
+    bool m_writing = false;
+    bool m_running = true;
+
+    // First error of the writer since the last Flush, reported by it
+    std::string m_error;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+    std::condition_variable m_written;
+    std::thread m_thread;
+
+    void Run();
+    void Write(const Item &item);
+
+public:
+    FrameDumper(const SoftwareRenderer &renderer, const std::string &directory, Format format, uint64_t every = 0);
+
+    /**
+     * @brief Write the frames still queued
+     */
+    ~FrameDumper();
+
+    /**
+     * @brief Parse "ppm" or "png"
+     */
+    static Format ParseFormat(const std::string &name);
+
+    /**
+     * @brief Path of the file a frame is written to
+     */
+    std::string Path(uint64_t number) const;
+
+    /**
+     * @brief Queue frame if its number, in emulated frames, is a multiple of the dump period
+     */
+    void OnFrame(const Framebuffer &frame, uint64_t number);
+
+    /**
+     * @brief Queue frame unconditionally, return the path of the file it will be written to
+     */
+    std::string Push(const Framebuffer &frame, uint64_t number);
+
+    /**
+     * @brief Wait until every queued frame is written, throw the first error of the writer since the last call
+     */
+    void Flush();
+
+    /**
+     * @brief Write frame unconditionally and wait for it, return the path of the written file
+     */
+    std::string Dump(const Framebuffer &frame, uint64_t number);
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Const.hpp"
+
+#include <cstring>
+
+/**
+ * Number of bytes of a framebuffer packed at one bit per pixel.
+ */
+const int GFX_PACKED_SIZE = GFX_ROWS * GFX_COLS / 8;
+
+/**
+ * Screen.
+ * The graphics of the Chip 8 are black and white and the screen has a total of 2048 pixels (64 x 32).
+ * Each pixel is stored in one byte, set to 0 or 1.
+ */
+struct Framebuffer {
+    uint8_t pixels[GFX_ROWS * GFX_COLS];
+
+    /* Inline getters */
+
+    inline uint8_t &operator[](int i) { return pixels[i]; }
+    inline uint8_t operator[](int i) const { return pixels[i]; }
+
+    /**
+     * @brief Pack the screen at one bit per pixel, most significant bit first, row by row
+     */
+    void Pack(uint8_t packed[GFX_PACKED_SIZE]) const {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        for (int i = 0; i < GFX_PACKED_SIZE; ++i) {
+            uint8_t byte = 0;
+            for (int bit = 0; bit < 8; ++bit)
+                byte = (byte << 1) | (pixels[i * 8 + bit] & 1);
+            packed[i] = byte;
+        }
+#else
+        // Eight pixels at once: the multiplication gathers bit 0 of byte N into bit 7 - N of the top byte
+        for (int i = 0; i < GFX_PACKED_SIZE; ++i) {
+            uint64_t bits;
+            memcpy(&bits, pixels + i * 8, sizeof(bits));
+            packed[i] = static_cast<uint8_t>(((bits & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56);
+        }
+#endif
+    }
+
+    /**
+     * @brief Unpack a screen packed with Pack
+     */
+    void Unpack(const uint8_t packed[GFX_PACKED_SIZE]) {
+        for (int i = 0; i < GFX_PACKED_SIZE; ++i)
+            for (int bit = 0; bit < 8; ++bit)
+                pixels[i * 8 + bit] = (packed[i] >> (7 - bit)) & 1;
+    }
+};
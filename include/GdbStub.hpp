@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Chip8.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * GDB remote serial protocol server for one Chip8 core, over a TCP socket on the loopback.
+ *
+ * The registers are V0 to VF, I, pc, sp, dt and st, in this order (see the target description),
+ * and the address space is the 4K of memory. Breakpoints patch the decode cache with Op::BREAK,
+ * so the core switches to the cached backend and only pays for them when it reaches one.
+ * Watchpoints are checked by the instructions accessing memory through I, and only while set.
+ *
+ * Every method but Shutdown must be called from the thread running the core: while the
+ * debugger holds the core, that thread serves the debugger.
+ */
+class GdbStub {
+public:
+#ifdef _WIN32
+    using Socket = uintptr_t;
+#else
+    using Socket = int;
+#endif
+
+private:
+    Chip8 &m_chip8;
+
+    Socket m_listener;
+    Socket m_client;
+    bool m_connected = false;
+    bool m_noAck = false;
+
+    // Bytes received and not parsed yet
+    std::string m_input;
+
+    // Signal reported when the core is not faulted: SIGTRAP after a step, SIGINT after an interrupt
+    int m_signal = 5;
+
+    std::set<uint16_t> m_breakpoints;
+
+    // Watchpoints given to the core, and their kind: 2 write, 3 read, 4 access
+    std::vector<Watchpoint> m_watchpoints;
+    std::vector<char> m_watchKinds;
+
+    std::atomic<bool> m_shutdown{false};
+
+    bool Accept(int timeout);
+    void Disconnect();
+
+    /**
+     * @brief Wait up to timeout milliseconds for bytes, -1 to wait until Shutdown
+     */
+    bool Receive(int timeout);
+
+    /**
+     * @brief Next packet or interrupt (as "\x03"), false once disconnected or shut down
+     */
+    bool ReadPacket(std::string &packet);
+    void SendPacket(const std::string &data);
+
+    /**
+     * @brief Answer the debugger until it resumes the core, first reporting why the core stopped if notify
+     */
+    void Serve(bool notify);
+
+    /**
+     * @brief Stop reply for the current state of the core
+     */
+    std::string StopReply() const;
+
+    /**
+     * @brief Execute one instruction, over a breakpoint at pc if any
+     */
+    void StepOver();
+
+    /**
+     * @brief Remove every breakpoint and watchpoint, and let the core run
+     */
+    void Release();
+
+    std::string ReadRegisters() const;
+    void WriteRegisters(const std::string &hex);
+    std::string ReadRegister(int index) const;
+    bool WriteRegister(int index, const std::string &hex);
+    std::string ReadMemory(const std::string &arguments) const;
+    bool WriteMemory(const std::string &arguments);
+    bool SetPoint(const std::string &arguments, bool insert);
+    std::string TargetDescription(const std::string &arguments) const;
+
+public:
+    /**
+     * @param port TCP port to listen on, on the loopback only
+     */
+    GdbStub(Chip8 &chip8, uint16_t port);
+    ~GdbStub();
+
+    GdbStub(const GdbStub &) = delete;
+    GdbStub &operator=(const GdbStub &) = delete;
+
+    /**
+     * @brief Block until a debugger attaches, then serve it until it resumes the core
+     */
+    void WaitForDebugger();
+
+    /**
+     * @brief Call between frames: attach a new debugger, or hand it the core when the core halted
+     * or the debugger interrupted it. Returns at once otherwise.
+     */
+    void Poll();
+
+    /**
+     * @brief Let a thread blocked serving the debugger return, from any thread
+     */
+    void Shutdown();
+
+    /* Inline getters */
+
+    inline bool connected() const { return m_connected; }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "Arena.hpp"
+#include "Chip8.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+/**
+ * Fixed set of Chip8 instances for dense hosting.
+ *
+ * The instances sit side by side in one block of an Arena, so a scan over their registers reads
+ * one cache line per instance. Their memory pages, screens and decode caches come from the same
+ * arena, apart from the instances.
+ */
+class InstancePool {
+public:
+    struct Stats {
+        size_t capacity;         // Maximum number of instances
+        size_t resident;         // Instances in use
+        size_t arenaBytes;       // Bytes of the arena in use, instances included
+        size_t bytesPerInstance; // arenaBytes / resident, shared pages amortised
+        Arena::HugePages hugePages;
+    };
+
+private:
+    Arena m_arena;
+
+    Chip8 *m_instances = nullptr;
+    size_t m_capacity;
+
+    std::vector<bool> m_resident;
+    std::vector<size_t> m_free;
+
+    mutable std::mutex m_mutex;
+
+public:
+    /**
+     * @param capacity Maximum number of instances
+     * @param bytesPerInstance Arena bytes reserved per instance, on top of the instance itself
+     */
+    InstancePool(size_t capacity, size_t bytesPerInstance = 16 * 1024);
+    ~InstancePool();
+
+    InstancePool(const InstancePool &) = delete;
+    InstancePool &operator=(const InstancePool &) = delete;
+
+    /**
+     * @brief Take a fresh instance allocating from the arena, throw when the pool is full
+     *
+     * Like any instance, it must be initialized or forked into before it runs.
+     */
+    Chip8 &Acquire();
+
+    /**
+     * @brief Give an instance back to the pool, releasing its pages
+     */
+    void Release(Chip8 &instance);
+
+    /**
+     * @brief Call func on every instance in use, in memory order
+     */
+    template <typename Func>
+    void ForEach(Func func) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i = 0; i < m_capacity; ++i) {
+            if (m_resident[i])
+                func(m_instances[i]);
+        }
+    }
+
+    /**
+     * @brief Name of a huge page mode
+     */
+    static const char *HugePagesName(Arena::HugePages hugePages);
+
+    /**
+     * @brief Occupancy and memory use of the pool
+     */
+    Stats stats() const;
+
+    /* Inline getters */
+
+    inline size_t capacity() const { return m_capacity; }
+};
@@ -1,34 +1,71 @@
 #pragma once
 
-#include <stdexcept>
+#include "SpscQueue.hpp"
 
-class KeyEvent {
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/**
+ * A key edge, as sent from the window thread to the emulation thread.
+ * The timestamp lets the emulation thread apply the edge at the emulated cycle matching the
+ * moment the key was actually pressed or released.
+ */
+struct KeyEvent {
+    std::chrono::steady_clock::time_point timestamp;
+    uint8_t key;
+    bool pressed;
+};
+
+/**
+ * Key edges from the window thread to the emulation thread.
+ * When the queue is full, the edges are coalesced per key instead: the last state of the key and
+ * whether it was pressed meanwhile, applied once the queued edges are consumed. A release is never
+ * lost and a tap still shows, only the timestamps of the coalesced edges are.
+ */
+class KeyQueue {
 private:
-    /**
-     * Current key state.
-     * The Chip 8 has a HEX based keypad (0x0-0xF), you can use an array to store the current state of the key.
-     */
-    bool m_keys[16];
+    SpscQueue<KeyEvent, 256> m_events;
 
-public:
-    KeyEvent();
-    ~KeyEvent();
+    // Bit N: last state of key N, bit 16 + N: key N has coalesced edges, bit 32 + N: it was pressed meanwhile
+    std::atomic<uint64_t> m_coalesced{0};
 
-    /* Inline getters */
+public:
+    /**
+     * @brief Enqueue an edge, or coalesce it when the queue is full, from the producer thread only
+     */
+    void Push(const KeyEvent &event) {
+        // Once an edge is coalesced the next ones are too, so they cannot overtake it
+        if (m_coalesced.load(std::memory_order_acquire) == 0 && m_events.Push(event))
+            return;
 
-    inline bool key(int i) const { 
-        if (i >= 16)
-            throw std::out_of_range("The Chip 8 has a HEX based keypad (0x0-0xF).");
-        return m_keys[i];
+        const uint64_t bit = uint64_t(1) << (event.key & 0xF);
+        uint64_t coalesced = m_coalesced.load(std::memory_order_relaxed);
+        uint64_t next;
+        do {
+            next = (coalesced & ~bit) | bit << 16;
+            if (event.pressed)
+                next |= bit | bit << 32;
+        } while (!m_coalesced.compare_exchange_weak(coalesced, next, std::memory_order_acq_rel, std::memory_order_relaxed));
     }
 
     /**
-     * @brief Event call when a key is pressed
+     * @brief Peek at the oldest queued edge, return nullptr if none
+     */
+    const KeyEvent *Front() const { return m_events.Front(); }
+
+    /**
+     * @brief Dequeue the oldest queued edge, return false if none
      */
-    void keyUp(int keycode);
+    bool Pop(KeyEvent &event) { return m_events.Pop(event); }
 
     /**
-     * @brief Event call when a key is released
+     * @brief Take the coalesced edges, only meaningful once the queue is empty
      */
-    void keyDown(int keycode);
-};
\ No newline at end of file
+    uint64_t TakeCoalesced() {
+        // Polled every cycle, the exchange is only paid when there is something to take
+        if (m_coalesced.load(std::memory_order_relaxed) == 0)
+            return 0;
+        return m_coalesced.exchange(0, std::memory_order_acq_rel);
+    }
+};
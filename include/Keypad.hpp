@@ -0,0 +1,42 @@
+#pragma once
+
+#include "KeyEvent.hpp"
+
+/**
+ * Keypad state, owned by the emulation thread.
+ * The Chip 8 has a HEX based keypad (0x0-0xF), stored as a 16-bit mask: bit N is set while key N is pressed.
+ *
+ * A key pressed and released within the same frame stays pressed until the end of the frame,
+ * so a ROM polling the keypad once per frame still sees short taps.
+ */
+class Keypad {
+private:
+    KeyQueue *m_queue;
+
+    uint16_t m_state = 0;
+
+    // Keys pressed during the current frame
+    uint16_t m_pressedThisFrame = 0;
+
+    // Keys released during the frame they were pressed in, released at the end of the frame
+    uint16_t m_deferredRelease = 0;
+
+    void Edge(uint16_t bit, bool pressed);
+
+public:
+    Keypad(KeyQueue *queue = nullptr) : m_queue(queue) {}
+
+    /* Inline getters */
+
+    inline uint16_t state() const { return m_state; }
+
+    /**
+     * @brief Apply the queued edges that happened up to time, return true if the state changed
+     */
+    bool Apply(std::chrono::steady_clock::time_point time);
+
+    /**
+     * @brief Release the keys tapped during the frame, return true if the state changed
+     */
+    bool EndFrame();
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * Monotonic counter, incremented from any thread with a relaxed atomic add.
+ */
+class Counter {
+private:
+    std::atomic<uint64_t> m_value{0};
+
+public:
+    inline void Add(uint64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+
+    /* Inline getters */
+
+    inline uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Histogram of integer samples with a bounded relative error, in the manner of HdrHistogram.
+ *
+ * Values below SUB_BUCKETS have a bucket each, above that every power of two is split in
+ * SUB_BUCKETS buckets, so a quantile is within 1/SUB_BUCKETS of the recorded values. Recording
+ * is lock-free: relaxed increments of one bucket, the count and the sum.
+ */
+class Histogram {
+public:
+    static const int SUB_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BITS;
+    static const int BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+private:
+    std::atomic<uint64_t> m_buckets[BUCKETS] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+
+    static int BucketIndex(uint64_t value);
+    static uint64_t BucketLimit(int index);
+
+public:
+    void Record(uint64_t value);
+
+    /**
+     * @brief Highest value equivalent to the one at quantile q in [0, 1], 0 when empty
+     */
+    uint64_t Quantile(double q) const;
+
+    /* Inline getters */
+
+    inline uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    inline uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+};
+
+/**
+ * Instrumentation of a running emulator.
+ *
+ * Every field is written lock-free by the thread that owns the measured work, and read at any
+ * time by the exporter or the overlay. Durations are recorded in nanoseconds.
+ */
+class Metrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Counters at one point in time, rates are computed between two samples.
+     */
+    struct Sample {
+        Clock::time_point time;
+        uint64_t instructions = 0;
+        uint64_t frames = 0;
+        uint64_t presentedFrames = 0;
+        double cpuSeconds = 0; // CPU time of the whole process, every thread
+    };
+
+    struct Rates {
+        double instructionsPerSecond = 0;
+        double framesPerSecond = 0;
+        double presentedFramesPerSecond = 0;
+        double speed = 0; // Emulated time over wall time, 1 at full speed
+        double cpuUtilisation = 0; // CPU time over wall time, 1 for a core fully busy
+    };
+
+    // Emulation thread
+    Counter instructions;  // Instructions executed
+    Counter frames;        // Emulated 60 Hz frames
+    Counter timerResyncs;  // Times the emulation fell too far behind and skipped ahead
+    Histogram frameTime;   // Time to emulate one frame
+    Histogram timerDrift;  // Lateness of each frame against the 60 Hz schedule
+
+    // Render thread
+    Counter presentedFrames; // Frames displayed
+    Histogram uploadTime;    // Texture upload of a new frame, Renderer::Update
+    Histogram drawTime;      // Draw call of Renderer::Display
+
+    // Audio
+    Counter audioUnderruns; // Beeps whose samples ran out before they were stopped
+
+    Metrics();
+
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    Sample sample() const;
+
+    /**
+     * @brief Rates between two samples, from the oldest to the newest
+     */
+    static Rates Rate(const Sample &from, const Sample &to);
+
+    /**
+     * @brief User and system CPU time consumed by the process so far, in seconds
+     */
+    static double ProcessCpuTime();
+
+    /**
+     * @brief Write every metric in the Prometheus text exposition format
+     */
+    void WritePrometheus(std::ostream &out, const Rates &rates) const;
+
+    /* Inline getters */
+
+    inline Clock::time_point startTime() const { return m_start; }
+
+private:
+    Clock::time_point m_start;
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Metrics.hpp"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Publishes Metrics in the Prometheus text format from a background thread.
+ *
+ * The target is either a file, rewritten atomically every interval, or a Unix socket given as
+ * "unix:PATH" that answers every connection with the current metrics (POSIX only). The rates are
+ * computed over the last interval.
+ */
+class MetricsExporter {
+private:
+    const Metrics &m_metrics;
+    std::string m_path;
+    bool m_socket = false;
+    int m_listener = -1;
+    std::chrono::milliseconds m_interval;
+
+    Metrics::Sample m_last;
+    Metrics::Rates m_rates;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{true};
+
+    void Run();
+    void Update();
+    void WriteFile() const;
+    void Serve(int timeout);
+
+public:
+    /**
+     * @param path File to rewrite, or "unix:PATH" for a socket
+     */
+    MetricsExporter(const Metrics &metrics, const std::string &path,
+                    std::chrono::milliseconds interval = std::chrono::milliseconds(1000));
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Metrics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/**
+ * Schedules the emulated frames against the wall clock and decides which ones are presented.
+ *
+ * The pacing sleeps until each frame is due, so it does not depend on the swap interval of the
+ * window. When the host falls too far behind, the schedule restarts from now instead of running
+ * a burst of frames to catch up.
+ */
+class Pacer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Mode {
+        RealTime,    // 60 frames per second, every frame presented
+        FastForward, // speed times 60 frames per second, presented at most 60 times per second
+        Unlimited    // As fast as the host allows, presented at most 60 times per second
+    };
+
+    /**
+     * @brief Duration of an emulated frame at normal speed
+     */
+    static constexpr Clock::duration FRAME_DURATION =
+        std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / 60.0));
+
+private:
+    Mode m_mode = Mode::RealTime;
+    double m_speed = 1.0;
+    Clock::duration m_frameDuration = FRAME_DURATION;
+
+    // Without frameskip every frame is presented, e.g. when every frame is dumped
+    bool m_frameskip = true;
+
+    Clock::time_point m_next;
+    Clock::time_point m_lastPresent;
+
+    // Written by the emulation thread, read by any thread
+    std::atomic<int64_t> m_start{0};
+    std::atomic<uint64_t> m_frames{0};
+
+    Metrics *m_metrics = nullptr;
+
+public:
+    /* Inline getters */
+
+    inline Mode mode() const { return m_mode; }
+
+    /**
+     * @brief Target speed as a multiple of real time, 0 when unlimited
+     */
+    inline double targetSpeed() const { return m_mode == Mode::Unlimited ? 0.0 : m_speed; }
+
+    /**
+     * @brief Wall time of an emulated frame at the target speed, FRAME_DURATION when unlimited
+     */
+    inline Clock::duration frameDuration() const { return m_frameDuration; }
+
+    /**
+     * @brief Speed reached since Start, as a multiple of real time
+     */
+    double achievedSpeed() const;
+
+    /* Inline setters */
+
+    /**
+     * @brief Select the mode, speed is the multiple of real time of the fast-forward
+     */
+    void SetMode(Mode mode, double speed = 1.0);
+
+    /**
+     * @brief Skip the presentation of frames beyond 60 per second, true by default
+     */
+    inline void SetFrameskip(bool enabled) { m_frameskip = enabled; }
+
+    /**
+     * @brief Record the timer drift and the resynchronisations, nullptr to stop
+     */
+    inline void SetMetrics(Metrics *metrics) { m_metrics = metrics; }
+
+    /**
+     * @brief Parse "realtime", "fast-forward" or "unlimited"
+     */
+    static Mode ParseMode(const std::string &name);
+    static const char *ModeName(Mode mode);
+
+    /**
+     * @brief Start the schedule now
+     */
+    void Start();
+
+    /**
+     * @brief Count a frame and sleep until the next one is due
+     */
+    void Wait();
+
+    /**
+     * @brief Whether the frame just emulated should be presented
+     */
+    bool Present();
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "Chip8.hpp"
+#include "ThreadPool.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Search of the memory addresses holding a value, e.g. a score or a life counter.
+ *
+ * Every address starts as a candidate. Each filter compares a new snapshot of the memory with the
+ * previous one, or with a value, and keeps the candidates that match. The candidates are a bitmap
+ * and the comparison runs 16 bytes at a time, only over the 64-byte blocks that still hold one.
+ *
+ * The search may span many instances, e.g. the forks of a batch: an address stays a candidate only
+ * when the comparison holds in every instance.
+ */
+class RamSearch {
+public:
+    static const int MEMORY_SIZE = 4096;
+    static const int WORDS = MEMORY_SIZE / 64;
+
+    using Bitmap = std::array<uint64_t, WORDS>;
+
+    enum class Comparison {
+        Equal,     // Same value as in the previous snapshot
+        Changed,   // Different value
+        Increased, // Greater value, unsigned
+        Decreased, // Lower value, unsigned
+        EqualTo    // Equal to the given value
+    };
+
+private:
+    size_t m_instances;
+
+    // Snapshots of every instance, side by side
+    std::vector<uint8_t> m_previous;
+    std::vector<uint8_t> m_current;
+
+    Bitmap m_candidates;
+
+    template <Comparison C>
+    void Compare(size_t first, size_t last, uint8_t value, Bitmap &matches) const;
+
+public:
+    /**
+     * @param instances Number of instances searched together
+     */
+    RamSearch(size_t instances = 1);
+
+    /**
+     * @brief Take the snapshot of an instance, from any thread for distinct instances
+     */
+    void Capture(size_t instance, const Chip8 &chip8);
+
+    /**
+     * @brief Make every address a candidate again, the last capture becomes the previous snapshot
+     */
+    void Reset();
+
+    /**
+     * @brief Keep the candidates matching in every instance, comparing the last capture with the previous one
+     *
+     * Every instance must have been captured since the last Reset or Filter. The last capture then
+     * becomes the previous snapshot. The instances are split over the pool, if any.
+     */
+    void Filter(Comparison comparison, uint8_t value = 0, ThreadPool *pool = nullptr);
+
+    /**
+     * @brief Parse "equal", "changed", "increased", "decreased" or "equal-to"
+     */
+    static Comparison ParseComparison(const std::string &name);
+
+    /* Inline getters */
+
+    inline size_t instances() const { return m_instances; }
+    inline const Bitmap &candidates() const { return m_candidates; }
+
+    inline bool candidate(uint16_t address) const {
+        return (m_candidates[address / 64] >> (address % 64)) & 1;
+    }
+
+    /**
+     * @brief Value of an address in an instance, as of the last Reset or Filter
+     */
+    inline uint8_t value(size_t instance, uint16_t address) const {
+        return m_previous[instance * MEMORY_SIZE + address];
+    }
+
+    /**
+     * @brief Number of candidates
+     */
+    size_t count() const;
+
+    /**
+     * @brief Candidate addresses, in increasing order
+     */
+    std::vector<uint16_t> addresses() const;
+};
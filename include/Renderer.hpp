@@ -1,30 +1,74 @@
 #pragma once
 
 #include "Shader.hpp"
+#include "Framebuffer.hpp"
+#include "Metrics.hpp"
 
-#define GFX_ROWS 32
-#define GFX_COLS 64
+#include <string>
 
 class Renderer {
 public:
     Renderer();
     ~Renderer();
 
-    /* Inline getters */
+    /**
+     * @brief Replace the screen with a frame published by the emulation thread
+     *
+     * The frame is packed at one bit per pixel and uploaded as is, the fragment shader expands it.
+     */
+    void Update(const Framebuffer &frame);
+
+    /**
+     * @brief Colours of unset and set pixels, as 0xRRGGBB
+     */
+    void SetPalette(uint32_t background, uint32_t foreground);
+
+    /**
+     * @brief Show text over the screen, in a 3x5 font at OVERLAY_SCALE times the resolution of the screen
+     *
+     * Lines are separated by '\n', unsupported characters are left blank. An empty text hides the overlay.
+     */
+    void SetOverlay(const std::string &text);
+
+    /* Inline setters */
 
-    inline uint8_t& operator[](int i) { return gfx[i]; }
-    inline uint8_t operator[](int i) const { return gfx[i]; }
+    /**
+     * @brief Time the texture upload and the draw call of Display, nullptr to stop
+     */
+    inline void SetMetrics(Metrics *metrics) { m_metrics = metrics; }
 
     void Display() const;
     void Clear();
 
+    /**
+     * @brief Rows of a glyph of the 3x5 overlay font, most significant of the 3 bits on the left,
+     * nullptr for unsupported characters
+     */
+    static const uint8_t *Glyph(char c);
+
+    // Bitplanes of the screen, the texture holds them one below the other
+    static const int PLANES = 1;
+
+    static const int OVERLAY_SCALE = 4;
+    static const int OVERLAY_COLS = GFX_COLS * OVERLAY_SCALE;
+    static const int OVERLAY_ROWS = GFX_ROWS * OVERLAY_SCALE;
+
 private:
     /**
      * Screen.
-     * The graphics of the Chip 8 are black and white and the screen has a total of 2048 pixels (64 x 32).
+     * Last frame published by the core, packed as in Framebuffer::Pack.
      */
-    uint8_t gfx[GFX_ROWS * GFX_COLS];
+    uint8_t m_packed[GFX_PACKED_SIZE * PLANES];
 
     GLuint m_texture, m_vao, m_vbo, m_ibo;
     Shader m_program;
+
+    // Overlay, one byte per texel set to 0 or 1 like the screen
+    uint8_t m_overlay[OVERLAY_ROWS * OVERLAY_COLS];
+    bool m_overlayVisible = false;
+    GLuint m_overlayTexture;
+    GLint m_overlayLocation;
+    GLint m_paletteLocation;
+
+    Metrics *m_metrics = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Chip8.hpp"
+#include "Metrics.hpp"
+#include "UdpLink.hpp"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * One side of a two-player session of a deterministic core, kept in sync over a UdpLink by rollback.
+ *
+ * Both sides run the same ROM with the same seed and cycles per frame, and the keypad of a frame is
+ * the union of the keys of both players. The local keys are applied delay frames later and sent to
+ * the peer at once; the remote keys of a frame not received yet are predicted to be the last ones
+ * received. The state before every frame is kept, so when remote keys arrive that differ from the
+ * prediction the core goes back to the first wrong frame and emulates again up to the present.
+ *
+ * Every datagram repeats the local keys the peer has not acknowledged yet, so a lost one is
+ * recovered by the next, and carries the hash of a confirmed state to detect a desync.
+ */
+class Rollback {
+public:
+    // Frames emulated ahead of the remote keys received, the session stalls beyond
+    static const uint32_t MAX_ROLLBACK = 16;
+
+    // Largest input delay, in frames
+    static const uint32_t MAX_DELAY = 8;
+
+    // Frames of keys kept, more than the peer can be behind or ahead of the acknowledgements
+    static const uint32_t HISTORY = 128;
+
+    // Saved states, one per frame that can be rolled back
+    static const uint32_t STATES = MAX_ROLLBACK + 1;
+
+private:
+    Chip8 &m_chip8;
+    UdpLink &m_link;
+    int m_cycles;
+    uint32_t m_delay;
+
+    uint32_t m_frame = 0;       // Next frame emulated
+    uint32_t m_localKnown;      // Local keys are known for the frames before
+    uint32_t m_remoteKnown = 0; // Remote keys are received for the frames before
+    uint32_t m_peerKnown = 0;   // The peer acknowledged the local keys of the frames before
+    uint32_t m_rollbackFrom;    // First frame emulated with a wrong prediction, m_frame when none
+
+    uint16_t m_local[HISTORY] = {};
+    uint16_t m_remote[HISTORY] = {};
+    uint16_t m_used[HISTORY] = {}; // Remote keys each frame was emulated with, received or predicted
+
+    Chip8State m_states[STATES]; // State before frame f at f % STATES
+    Chip8State m_scratch;
+
+    // Hash of the last confirmed state sent, and the last received from the peer
+    uint32_t m_checkFrame = UINT32_MAX;
+    uint64_t m_checkHash = 0;
+    bool m_peerCheck = false;
+    uint32_t m_peerCheckFrame = 0;
+    uint64_t m_peerCheckHash = 0;
+    uint32_t m_verifiedFrame = 0;
+    bool m_desynced = false;
+
+    std::vector<uint8_t> m_packet;
+
+    uint64_t m_rollbacks = 0;
+    uint64_t m_resimulatedFrames = 0;
+    uint32_t m_maxDepth = 0;
+    uint64_t m_stalls = 0;
+    Histogram m_rollbackTime; // Nanoseconds to restore and emulate again, per rollback
+
+    void EmulateFrame(uint32_t frame);
+    void Receive();
+    void Resimulate();
+    void Verify();
+    void Send();
+    uint64_t HashAt(uint32_t frame);
+
+public:
+    /**
+     * @param chip8 Core with the game loaded and seeded, the same on both sides
+     * @param cycles Instructions per frame, the same on both sides
+     * @param delay Frames between reading the local keys and applying them, at most MAX_DELAY
+     */
+    Rollback(Chip8 &chip8, UdpLink &link, int cycles, uint32_t delay);
+
+    Rollback(const Rollback &) = delete;
+    Rollback &operator=(const Rollback &) = delete;
+
+    /**
+     * @brief Exchange keys, roll back if a prediction was wrong, then emulate the next frame, false when stalled
+     */
+    bool Advance(uint16_t keys);
+
+    /**
+     * @brief Exchange keys and roll back if a prediction was wrong, without emulating
+     */
+    void Poll();
+
+    /**
+     * @brief Hash of the machine state, the same on both sides at a frame confirmed by both
+     */
+    static uint64_t Hash(const Chip8State &state);
+
+    /* Inline getters */
+
+    inline uint32_t frame() const { return m_frame; }
+    inline uint32_t delay() const { return m_delay; }
+
+    /**
+     * @brief Frames whose keys are known on both sides, their states can no longer change
+     */
+    inline uint32_t confirmedFrame() const { return m_remoteKnown < m_frame ? m_remoteKnown : m_frame; }
+
+    /**
+     * @brief Frames whose local keys the peer has acknowledged
+     */
+    inline uint32_t acknowledgedFrame() const { return m_peerKnown; }
+
+    /**
+     * @brief Whether a confirmed state differed from the peer's, the session cannot recover
+     */
+    inline bool desynced() const { return m_desynced; }
+
+    /**
+     * @brief Last frame whose state matched the peer's, or the one that differed once desynced
+     */
+    inline uint32_t verifiedFrame() const { return m_verifiedFrame; }
+
+    inline uint64_t rollbacks() const { return m_rollbacks; }
+    inline uint64_t resimulatedFrames() const { return m_resimulatedFrames; }
+    inline uint32_t maxDepth() const { return m_maxDepth; }
+    inline uint64_t stalls() const { return m_stalls; }
+    inline const Histogram &rollbackTime() const { return m_rollbackTime; }
+};
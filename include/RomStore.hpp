@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * A ROM file mapped read-only in memory, shared by every instance running it.
+ */
+class RomImage {
+private:
+    const uint8_t *m_data = nullptr;
+    size_t m_size = 0;
+    uint64_t m_hash = 0;
+    std::string m_name;
+
+    // Mapping of the file, or copy of it where files cannot be mapped
+    void *m_mapping = nullptr;
+    std::vector<uint8_t> m_copy;
+
+public:
+    /**
+     * @brief Map a ROM file, throw if it cannot be read or does not fit in memory
+     */
+    RomImage(const std::string &path);
+    ~RomImage();
+
+    RomImage(const RomImage &) = delete;
+    RomImage &operator=(const RomImage &) = delete;
+
+    /* Inline getters */
+
+    inline const uint8_t *data() const { return m_data; }
+    inline size_t size() const { return m_size; }
+    inline uint64_t hash() const { return m_hash; }
+    inline const std::string &name() const { return m_name; }
+};
+
+/**
+ * Settings of a ROM, looked up by hash in the ROM database.
+ */
+struct RomInfo {
+    std::string name;
+
+    // Instructions per frame, 0 when unknown
+    int cycles = 0;
+
+    // CHIP-8 key sent for each key of the default layout, identity by default
+    uint8_t keymap[16] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0x8, 0x9, 0xA, 0xB, 0xC, 0xD, 0xE, 0xF};
+
+    // Behaviours the ROM expects from the interpreter, e.g. « shift-vx »
+    std::vector<std::string> quirks;
+};
+
+/**
+ * Opens each ROM file once and hands the same read-only image to every instance.
+ *
+ * ROM database format, one ROM per line, « # » starts a comment:
+ *   HASH NAME [cycles=N] [keymap=16 hex digits] [quirks=NAME,NAME]
+ * where HASH is the 64 bits FNV-1a hash of the ROM in hex, as printed by « chip8 ».
+ */
+class RomStore {
+private:
+    std::map<std::string, std::shared_ptr<const RomImage>> m_images;
+    std::map<uint64_t, RomInfo> m_database;
+
+    mutable std::mutex m_mutex;
+
+public:
+    /**
+     * @brief Return the image of a ROM file, mapping it on first use
+     */
+    std::shared_ptr<const RomImage> Open(const std::string &path);
+
+    /**
+     * @brief Add the entries of a ROM database file, throw on a malformed line
+     */
+    void LoadDatabase(const std::string &path);
+
+    /**
+     * @brief Settings of a ROM, nullptr if it is not in the database
+     */
+    const RomInfo *Lookup(uint64_t hash) const;
+
+    /* Inline getters */
+
+    inline size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_images.size();
+    }
+};
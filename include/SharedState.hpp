@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Framebuffer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Layout of the shared memory segment exporting running instances, see StateExporter and StateReader.
+ *
+ * The segment starts with a SharedStateHeader, followed by one slot per instance every slotSize
+ * bytes. A slot is a SharedSlot followed by memorySize bytes of the memory of the instance, from
+ * memoryAddress. Both processes must agree on this layout, so any change bumps SHARED_STATE_VERSION.
+ *
+ * Each slot is guarded by a seqlock: the writer makes the sequence odd, writes the slot, then
+ * makes it even again. A reader copies the slot between two reads of the same even sequence, so
+ * neither side makes a system call nor waits for the other.
+ */
+
+const uint32_t SHARED_STATE_MAGIC = 0x38504843; // "CHP8"
+const uint32_t SHARED_STATE_VERSION = 3;
+
+struct alignas(64) SharedStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t instances;     // Number of slots
+    uint32_t slotSize;      // Bytes between two slots, a multiple of 64
+    uint16_t memoryAddress; // First byte of memory exported
+    uint16_t memorySize;    // Bytes of memory exported, at most 4096
+    uint32_t owner;         // Process id of the exporter, a segment whose owner is gone is stale
+};
+
+/**
+ * Machine state of an instance at the end of a frame.
+ */
+struct SharedInstanceState {
+    uint64_t frame; // Frames emulated, 0 until the first one is published
+    uint8_t V[16];
+    uint16_t I;
+    uint16_t pc;
+    uint16_t opcode; // Instruction at pc, e.g. FX0A while waiting for a key
+    uint16_t sp;
+    uint16_t stack[16];
+    uint16_t keys; // Bit N is set while key N is pressed
+    uint8_t delayTimer;
+    uint8_t soundTimer;
+    uint8_t fault; // Value of the Fault enumeration, 0 when running
+    uint8_t screen[GFX_PACKED_SIZE]; // Framebuffer::Pack
+};
+
+struct alignas(64) SharedSlot {
+    std::atomic<uint32_t> sequence; // Odd while the slot is written, bumped twice per publication
+    SharedInstanceState state;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "The seqlock must be usable across processes");
+
+/**
+ * @brief Offset of the first slot in the segment
+ */
+const size_t SHARED_STATE_SLOTS_OFFSET = sizeof(SharedStateHeader);
+
+/**
+ * @brief Bytes between two slots exporting memorySize bytes of memory
+ */
+inline uint32_t SharedSlotSize(uint16_t memorySize) {
+    return static_cast<uint32_t>((sizeof(SharedSlot) + memorySize + 63) / 64 * 64);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Framebuffer.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * CPU renderer.
+ * Scales the framebuffer into a 32-bit RGBA image in memory, without OpenGL nor a display,
+ * and writes it as PPM or PNG.
+ */
+class SoftwareRenderer {
+private:
+    int m_pixelSize;
+
+    // Colours of unset and set pixels, stored as RGBA bytes in memory order
+    uint32_t m_palette[2];
+
+    std::vector<uint32_t> m_pixels;
+
+public:
+    /**
+     * @param background Colour of unset pixels, as 0xRRGGBB
+     * @param foreground Colour of set pixels, as 0xRRGGBB
+     */
+    SoftwareRenderer(int pixelSize = 5, uint32_t background = 0x000000, uint32_t foreground = 0xFFFFFF);
+
+    /* Inline getters */
+
+    inline int width() const { return GFX_COLS * m_pixelSize; }
+    inline int height() const { return GFX_ROWS * m_pixelSize; }
+    inline const uint32_t *pixels() const { return m_pixels.data(); }
+
+    /**
+     * @brief Scale frame into the image
+     */
+    void Render(const Framebuffer &frame);
+
+    /**
+     * @brief Write the image as binary PPM (P6)
+     */
+    void WritePPM(const std::string &path) const;
+
+    /**
+     * @brief Write the image as PNG
+     */
+    void WritePNG(const std::string &path) const;
+};
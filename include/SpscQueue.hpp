@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free single-producer single-consumer ring buffer.
+ * Capacity must be a power of two. Push never blocks: it fails when the queue is full.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+
+private:
+    T m_items[Capacity];
+
+    // Next slot to read, only written by the consumer
+    alignas(64) std::atomic<size_t> m_head{0};
+
+    // Next slot to write, only written by the producer
+    alignas(64) std::atomic<size_t> m_tail{0};
+
+public:
+    /**
+     * @brief Enqueue an item, return false if the queue is full
+     */
+    bool Push(const T &item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+            return false;
+
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Peek at the oldest item without removing it, return nullptr if the queue is empty
+     */
+    const T *Front() const {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &m_items[head & (Capacity - 1)];
+    }
+
+    /**
+     * @brief Dequeue the oldest item, return false if the queue is empty
+     */
+    bool Pop(T &item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+            return false;
+
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+
+/**
+ * Timeline of the startup phases, printed as each phase ends.
+ *
+ * Phases may run on any thread, e.g. the ROM load and the audio device open run concurrently with
+ * the window and OpenGL initialisation. Times are relative to the construction of the trace.
+ */
+class StartupTrace {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * Phase timed from its construction to its destruction, does nothing without a trace.
+     */
+    class Span {
+    private:
+        StartupTrace *m_trace;
+        const char *m_name;
+        Clock::time_point m_start;
+
+    public:
+        Span(StartupTrace *trace, const char *name);
+        ~Span();
+
+        Span(const Span &) = delete;
+        Span &operator=(const Span &) = delete;
+    };
+
+private:
+    std::ostream &m_out;
+    std::mutex m_mutex;
+    Clock::time_point m_origin;
+
+public:
+    explicit StartupTrace(std::ostream &out);
+
+    StartupTrace(const StartupTrace &) = delete;
+    StartupTrace &operator=(const StartupTrace &) = delete;
+
+    /**
+     * @brief Print a phase that ran from start to end
+     */
+    void Record(const char *name, Clock::time_point start, Clock::time_point end);
+
+    /**
+     * @brief Print an event that happened now, e.g. the first frame on screen
+     */
+    void Mark(const char *name);
+};
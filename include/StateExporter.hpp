@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Chip8.hpp"
+#include "SharedState.hpp"
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Publishes the screen, registers and a range of memory of Chip8 instances in a named shared
+ * memory segment, one slot per instance (see SharedState.hpp for the layout).
+ *
+ * Publishing writes the slot in place under its seqlock, without system calls, so readers in other
+ * processes never slow the emulation down. Different slots may be published from different threads.
+ * The segment is removed when the exporter is destroyed, readers attached keep their mapping. An
+ * existing segment is never truncated: creating it fails while its exporter is alive, and a segment
+ * left by a process that died is replaced by a new one.
+ */
+class StateExporter {
+private:
+    std::string m_name;
+    uint8_t *m_base = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void *m_mapping = nullptr;
+#endif
+
+    SharedStateHeader *m_header = nullptr;
+
+    SharedSlot &Slot(uint32_t index) const;
+
+public:
+    /**
+     * @param name Name of the segment, e.g. "chip8" for /dev/shm/chip8 on Linux
+     * @param instances Number of slots
+     * @param memoryAddress First byte of memory exported
+     * @param memorySize Bytes of memory exported, up to the end of the 4K
+     */
+    StateExporter(const std::string &name, uint32_t instances, uint16_t memoryAddress = 0, uint16_t memorySize = 4096);
+    ~StateExporter();
+
+    StateExporter(const StateExporter &) = delete;
+    StateExporter &operator=(const StateExporter &) = delete;
+
+    /**
+     * @brief Copy the state of an instance to slot index, frame is the number of frames it emulated
+     */
+    void Publish(uint32_t index, const Chip8 &chip8, uint64_t frame);
+
+    /**
+     * @brief Parse a memory range given as "ADDRESS,SIZE" in hexadecimal, e.g. "200,E00"
+     */
+    static std::pair<uint16_t, uint16_t> ParseRange(const std::string &range);
+
+    /* Inline getters */
+
+    inline const std::string &name() const { return m_name; }
+    inline uint32_t instances() const { return m_header->instances; }
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "SharedState.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Attaches to the shared memory segment of a StateExporter, in another process, and takes
+ * consistent snapshots of its instances.
+ *
+ * Reading maps the segment read-only and never writes it, so any number of readers may watch the
+ * same instances. Only needs this header, SharedState.hpp and Framebuffer.hpp, not the core.
+ */
+class StateReader {
+public:
+    struct Snapshot {
+        SharedInstanceState state;
+        std::vector<uint8_t> memory; // From memoryAddress()
+        uint32_t sequence = 0;       // Even, changes with every publication
+    };
+
+private:
+    std::string m_name;
+    const uint8_t *m_base = nullptr;
+    size_t m_size = 0;
+
+#ifdef _WIN32
+    void *m_mapping = nullptr;
+#endif
+
+    const SharedStateHeader *m_header = nullptr;
+
+    const SharedSlot &Slot(uint32_t index) const;
+    void Detach();
+
+public:
+    /**
+     * @brief Attach to a segment, throw when it does not exist or has another layout version
+     */
+    explicit StateReader(const std::string &name);
+    ~StateReader();
+
+    StateReader(const StateReader &) = delete;
+    StateReader &operator=(const StateReader &) = delete;
+
+    /**
+     * @brief Copy the last publication of instance index, retrying while it is being written
+     *
+     * Returns false when no consistent copy was made within maxRetries attempts, e.g. when the
+     * writer died in the middle of a publication.
+     */
+    bool Read(uint32_t index, Snapshot &snapshot, int maxRetries = 1000) const;
+
+    /**
+     * @brief Sequence of instance index, to poll for a new publication without copying the slot
+     */
+    uint32_t sequence(uint32_t index) const;
+
+    /* Inline getters */
+
+    inline const std::string &name() const { return m_name; }
+    inline uint32_t instances() const { return m_header->instances; }
+    inline uint16_t memoryAddress() const { return m_header->memoryAddress; }
+    inline uint16_t memorySize() const { return m_header->memorySize; }
+};
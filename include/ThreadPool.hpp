@@ -0,0 +1,52 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size pool of worker threads running independent tasks, e.g. one ROM or one instance per task.
+ */
+class ThreadPool {
+private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    std::condition_variable m_allDone;
+
+    // Tasks queued or running
+    size_t m_pending = 0;
+    bool m_stopping = false;
+
+    void Work();
+
+public:
+    /**
+     * @param threads Number of workers, 0 to use one per hardware thread
+     */
+    ThreadPool(unsigned threads = 0);
+
+    /**
+     * @brief Finish the queued tasks and join the workers
+     */
+    ~ThreadPool();
+
+    /* Inline getters */
+
+    inline size_t size() const { return m_workers.size(); }
+
+    /**
+     * @brief Queue a task
+     */
+    void Submit(std::function<void()> task);
+
+    /**
+     * @brief Block until every submitted task has completed
+     */
+    void Wait();
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * Lock-free triple buffer.
+ * A single producer writes into the back slot and publishes it, a single consumer acquires the
+ * most recently published slot. Neither side ever waits for the other: the producer always has a
+ * free slot to write into, and the consumer simply skips frames it was too slow to pick up.
+ */
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr uint8_t INDEX_MASK = 0x3;
+    static constexpr uint8_t DIRTY_BIT = 0x4;
+
+    T m_slots[3];
+
+    // Slot owned by the producer
+    alignas(64) uint8_t m_back = 0;
+
+    // Slot shared between both sides, with a dirty bit set when it holds an unread value
+    alignas(64) std::atomic<uint8_t> m_middle{1};
+
+    // Slot owned by the consumer
+    alignas(64) uint8_t m_front = 2;
+
+public:
+    /* Producer side */
+
+    inline T &Back() { return m_slots[m_back]; }
+
+    /**
+     * @brief Make the back slot visible to the consumer and take a new back slot
+     */
+    void Publish() {
+        uint8_t previous = m_middle.exchange(m_back | DIRTY_BIT, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+
+    /* Consumer side */
+
+    inline const T &Front() const { return m_slots[m_front]; }
+
+    /**
+     * @brief Take the last published slot as front slot, return false if nothing new was published
+     */
+    bool Acquire() {
+        if (!(m_middle.load(std::memory_order_relaxed) & DIRTY_BIT))
+            return false;
+
+        uint8_t previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+};
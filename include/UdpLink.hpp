@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/**
+ * Datagram link between two processes on the loopback, e.g. the two sides of a Rollback session.
+ *
+ * Network conditions can be simulated on the sending side: every datagram is dropped with the
+ * loss probability, or held for the latency plus a random jitter before it is sent, so datagrams
+ * may also arrive out of order. Nothing blocks but Wait.
+ */
+class UdpLink {
+public:
+#ifdef _WIN32
+    using Socket = uintptr_t;
+#else
+    using Socket = int;
+#endif
+
+    using Clock = std::chrono::steady_clock;
+
+    // Largest datagram sent or received
+    static const size_t MAX_PACKET = 1024;
+
+    struct Conditions {
+        double latency = 0; // One-way delay, in milliseconds
+        double jitter = 0;  // Random extra delay up to this, in milliseconds
+        double loss = 0;    // Probability of dropping a datagram, from 0 to 1
+        uint32_t seed = 1;  // Of the random drops and jitter, so runs can be reproduced
+    };
+
+private:
+    struct Pending {
+        Clock::time_point due;
+        std::vector<uint8_t> data;
+    };
+
+    Socket m_socket;
+    uint16_t m_peerPort;
+
+    Conditions m_conditions;
+    uint32_t m_random = 1;
+
+    // Held datagrams, in no particular order of due time when there is jitter
+    std::deque<Pending> m_pending;
+
+    uint64_t m_sent = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_received = 0;
+
+    double NextRandom();
+    void SendNow(const uint8_t *data, size_t size);
+
+public:
+    /**
+     * @brief Bind port on the loopback and send to peerPort, throw when the port is taken
+     */
+    UdpLink(uint16_t port, uint16_t peerPort);
+    ~UdpLink();
+
+    UdpLink(const UdpLink &) = delete;
+    UdpLink &operator=(const UdpLink &) = delete;
+
+    void SetConditions(const Conditions &conditions);
+
+    /**
+     * @brief Send a datagram, or hold it or drop it under the simulated conditions
+     */
+    void Send(const uint8_t *data, size_t size);
+
+    /**
+     * @brief Send the held datagrams that are due
+     */
+    void Flush();
+
+    /**
+     * @brief Next datagram received, false when none is waiting
+     */
+    bool Receive(std::vector<uint8_t> &packet);
+
+    /**
+     * @brief Sleep until a datagram arrives, a held one is due, or timeout milliseconds elapsed
+     */
+    void Wait(int timeout);
+
+    /* Inline getters */
+
+    inline const Conditions &conditions() const { return m_conditions; }
+    inline uint64_t sent() const { return m_sent; }
+    inline uint64_t dropped() const { return m_dropped; }
+    inline uint64_t received() const { return m_received; }
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Framebuffer.hpp"
+
+#include <fstream>
+#include <string>
+
+/**
+ * Decoder for the streams written by VideoRecorder.
+ */
+class VideoReader {
+private:
+    std::ifstream m_file;
+
+    uint8_t m_packed[GFX_PACKED_SIZE] = {0};
+    uint64_t m_number = 0;
+
+public:
+    VideoReader(const std::string &path);
+
+    /**
+     * @brief Decode the next recorded frame, return false at the end of the stream
+     *
+     * number is set to the emulated frame the record was taken at, frames in between are
+     * identical to the previous record.
+     */
+    bool Next(Framebuffer &frame, uint64_t &number);
+};
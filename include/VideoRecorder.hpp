@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Framebuffer.hpp"
+#include "SpscQueue.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * Lossless recording of the presented frames.
+ *
+ * Stream format: the 8 bytes magic "CHIP8VID", one version byte, then one record per frame:
+ * the frame number as a difference to the previous record (varint), the size of the payload (varint)
+ * and the payload. The payload is the XOR of the packed frame with the previous packed frame,
+ * run-length coded as a sequence of control bytes: 0x80 | (N - 1) stands for N zero bytes,
+ * N - 1 with the high bit clear is followed by N literal bytes.
+ */
+class VideoRecorder {
+public:
+    static constexpr char MAGIC[8] = {'C', 'H', 'I', 'P', '8', 'V', 'I', 'D'};
+    static constexpr uint8_t VERSION = 1;
+
+private:
+    struct Item {
+        uint64_t number;
+        Framebuffer frame;
+    };
+
+    // Frames waiting to be encoded, bounded so the emulation thread never blocks
+    SpscQueue<Item, 64> m_queue;
+
+    std::ofstream m_file;
+
+    // Last encoded frame, packed
+    uint8_t m_previous[GFX_PACKED_SIZE] = {0};
+    uint64_t m_previousNumber = 0;
+
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Wait for the encoder instead of dropping frames, for offline runs
+    bool m_lossless = false;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{true};
+    std::mutex m_mutex;
+    std::condition_variable m_wakeUp;
+
+    void Run();
+    void Encode(const Item &item);
+
+public:
+    VideoRecorder(const std::string &path);
+
+    /**
+     * @brief Encode the frames still queued and close the file
+     */
+    ~VideoRecorder();
+
+    /* Inline getters */
+
+    /**
+     * @brief Number of frames lost because the encoder could not keep up
+     */
+    inline uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+
+    /* Inline setters */
+
+    /**
+     * @brief Wait for room in the queue instead of dropping frames, only for headless runs
+     */
+    inline void SetLossless(bool lossless) { m_lossless = lossless; }
+
+    /**
+     * @brief Queue a frame for encoding, never blocks unless lossless
+     */
+    void Push(const Framebuffer &frame, uint64_t number);
+};
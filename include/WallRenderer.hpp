@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Shader.hpp"
+#include "Framebuffer.hpp"
+#include "Metrics.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * Draws the screens of many instances side by side, for the monitoring wall.
+ *
+ * Each instance is a layer of a texture array holding its packed screen (Framebuffer::Pack) and,
+ * below it, a label drawn over the top of the tile. Every tile is drawn by a single instanced
+ * draw call of the Vertex quad, with a border coloured by the status of the instance.
+ *
+ * Screens and labels are staged into a persistently mapped pixel buffer split in RING regions, one
+ * per frame in flight: an update is a memcpy of the tiles that changed into the next free region,
+ * then a texture copy of the region done by the GPU. A fence guards each region until that copy
+ * is done.
+ */
+class WallRenderer {
+public:
+    /**
+     * What the border of a tile shows, flags can be combined.
+     */
+    enum Status : uint32_t {
+        RUNNING = 0,
+        FAULTED = 1 << 0, // The core halted
+        WAITING = 1 << 1, // Blocked on FX0A with no key pressed
+        STALE   = 1 << 2  // Nothing published for a while
+    };
+
+    // Tiles beyond are not shown, the minimum number of texture array layers is 2048
+    static const int MAX_TILES = 1024;
+
+    // Regions of the pixel buffer, frames uploaded while the GPU may still read the previous ones
+    static const int RING = 3;
+
+    // Label of a tile, one row of 3x5 glyphs over the screen, packed like the screen
+    static const int LABEL_ROWS = 7;
+    static const int LABEL_CHARS = GFX_COLS / 4;
+
+    // Texture rows of a layer, and bytes of a layer in the pixel buffer
+    static const int LAYER_ROWS = GFX_ROWS + LABEL_ROWS;
+    static const int LAYER_SIZE = GFX_COLS / 8 * LAYER_ROWS;
+
+private:
+    int m_tiles;
+
+    // Last screen and label of each tile, packed as in the texture
+    std::vector<uint8_t> m_layers;
+    std::vector<uint8_t> m_dirty;
+    int m_dirtyCount = 0;
+
+    std::vector<uint32_t> m_status;
+    bool m_statusDirty = true;
+
+    GLuint m_texture, m_vao, m_vbo, m_ibo, m_statusBuffer;
+    Shader m_program;
+    GLint m_gridLocation;
+    GLint m_paletteLocation;
+
+    // Pixel buffer, mapped for the lifetime of the renderer
+    GLuint m_pixelBuffer;
+    uint8_t *m_mapped = nullptr;
+    GLsync m_fences[RING] = {};
+    int m_region = 0;
+
+    Metrics *m_metrics = nullptr;
+
+    inline uint8_t *Layer(int tile) { return m_layers.data() + static_cast<size_t>(tile) * LAYER_SIZE; }
+
+public:
+    /**
+     * @param tiles Number of instances shown, at most MAX_TILES
+     */
+    explicit WallRenderer(int tiles);
+    ~WallRenderer();
+
+    WallRenderer(const WallRenderer &) = delete;
+    WallRenderer &operator=(const WallRenderer &) = delete;
+
+    /**
+     * @brief Replace the screen of a tile, packed as in Framebuffer::Pack, nothing is uploaded when it is the same
+     */
+    void SetScreen(int tile, const uint8_t packed[GFX_PACKED_SIZE]);
+
+    /**
+     * @brief Replace the label of a tile, at most LABEL_CHARS characters of the overlay font
+     */
+    void SetLabel(int tile, const std::string &text);
+
+    /**
+     * @brief Replace the status of a tile, a combination of Status
+     */
+    void SetStatus(int tile, uint32_t status);
+
+    /**
+     * @brief Colours of unset and set pixels, as 0xRRGGBB
+     */
+    void SetPalette(uint32_t background, uint32_t foreground);
+
+    /* Inline setters */
+
+    /**
+     * @brief Time the upload and the draw call, nullptr to stop
+     */
+    inline void SetMetrics(Metrics *metrics) { m_metrics = metrics; }
+
+    /* Inline getters */
+
+    inline int tiles() const { return m_tiles; }
+
+    /**
+     * @brief Stage the tiles changed since the last call and copy them to the texture, false when nothing changed
+     */
+    bool Upload();
+
+    /**
+     * @brief Draw every tile in a grid filling a framebuffer of width x height pixels
+     */
+    void Display(int width, int height) const;
+};
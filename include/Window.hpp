@@ -3,6 +3,8 @@
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
+#include "StartupTrace.hpp"
+
 #include <functional>
 #include <stdexcept>
 
@@ -10,11 +12,18 @@ class Window {
  private:
   GLFWwindow* m_window;
 
-  std::function<void(void)> m_drawFrameFunc;
+  std::function<bool(bool)> m_drawFrameFunc;
+
+  // Longest time the loop sleeps waiting for events, in seconds
+  double m_waitTimeout = 1.0 / 60.0;
+
+  // Size of the framebuffer at the last draw, a new size forces a redraw
+  int m_width = 0;
+  int m_height = 0;
 
  public:
   Window();
-  Window(int width, int height, const char* title);
+  Window(int width, int height, const char* title, StartupTrace* trace = nullptr);
   ~Window();
 
   /* Inline getters */
@@ -24,7 +33,16 @@ class Window {
 
   /* Inline setters */
   
-  inline void SetDrawFrameFunc(const std::function<void(void)>& func) { m_drawFrameFunc = func; }
+  /**
+   * @brief Draw callback, given whether the window must be redrawn even without anything new, and
+   * returning whether it drew in the back buffer, only then are the buffers swapped
+   */
+  inline void SetDrawFrameFunc(const std::function<bool(bool)>& func) { m_drawFrameFunc = func; }
+
+  /**
+   * @brief Longest time the loop sleeps between two draws when no event comes, in seconds
+   */
+  inline void SetWaitTimeout(double seconds) { m_waitTimeout = seconds; }
   inline void SetWindowUserPointer(void* pointer) { glfwSetWindowUserPointer(m_window, pointer); }
 
   /**
@@ -32,5 +50,16 @@ class Window {
    */
   static void OnKey(GLFWwindow* window, int key, int scancode, int action, int mods);
 
+  /**
+   * @brief Wake the main loop from any thread, e.g. when a new frame is ready
+   */
+  static void Wake();
+
+  /**
+   * @brief Draw and wait for events until the window is closed
+   *
+   * The loop sleeps until an event, a Wake or the wait timeout, so an idle emulator does not
+   * keep a core and the GPU busy.
+   */
   void mainLoop();
 };
\ No newline at end of file
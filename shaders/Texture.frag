@@ -2,7 +2,15 @@
 
 /* Variables */
 
-uniform sampler2D uTexSampler;
+// Screen packed at one bit per pixel, most significant bit first, one bitplane after the other
+uniform usampler2D uTexSampler;
+uniform int uPlanes;
+
+// Colour of each combination of the bitplanes
+uniform vec4 uPalette[4];
+
+uniform sampler2D uOverlaySampler;
+uniform bool uOverlay;
 
 layout(location = 0) in vec2 iTexCoord;
 
@@ -11,6 +19,22 @@ layout(location = 0) out vec4 oColour;
 /* Functions */
 
 void main(void) {
-  float color = texture(uTexSampler, iTexCoord).r * 255;
-  oColour = vec4(color, color, color, 1.0);
-}
\ No newline at end of file
+  ivec2 size = textureSize(uTexSampler, 0);
+  int rows = size.y / uPlanes;
+  ivec2 pixel = ivec2(iTexCoord * vec2(size.x * 8, rows));
+  pixel = min(pixel, ivec2(size.x * 8 - 1, rows - 1));
+
+  int index = 0;
+  for (int plane = 0; plane < uPlanes; ++plane) {
+    uint bits = texelFetch(uTexSampler, ivec2(pixel.x >> 3, plane * rows + pixel.y), 0).r;
+    index |= int((bits >> (7 - (pixel.x & 7))) & 1u) << plane;
+  }
+
+  oColour = uPalette[index];
+
+  // Text of the metrics overlay, in yellow over the screen
+  if (uOverlay) {
+    float text = texture(uOverlaySampler, iTexCoord).r * 255;
+    oColour = mix(oColour, vec4(1.0, 1.0, 0.0, 1.0), clamp(text, 0.0, 1.0));
+  }
+}
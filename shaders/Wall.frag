@@ -0,0 +1,58 @@
+#version 450 core
+
+/* Variables */
+
+// Screens of the instances, a layer each, packed at one bit per pixel, then the rows of the label
+uniform usampler2DArray uTiles;
+
+// Colour of unset and set pixels
+uniform vec4 uPalette[2];
+
+layout(location = 0) in vec2 iTexCoord;
+layout(location = 1) flat in int iLayer;
+layout(location = 2) flat in uint iStatus;
+
+layout(location = 0) out vec4 oColour;
+
+// Same values as WallRenderer
+const int COLS = 64;
+const int ROWS = 32;
+const int LABEL_ROWS = 7;
+
+const uint FAULTED = 1u;
+const uint WAITING = 2u;
+const uint STALE = 4u;
+
+/* Functions */
+
+bool bitAt(ivec2 pixel) {
+  uint bits = texelFetch(uTiles, ivec3(pixel.x >> 3, pixel.y, iLayer), 0).r;
+  return ((bits >> (7 - (pixel.x & 7))) & 1u) != 0u;
+}
+
+void main(void) {
+  // The screen with a border of one pixel around it
+  ivec2 pixel = ivec2(floor(iTexCoord * vec2(COLS + 2, ROWS + 2))) - 1;
+  pixel = min(pixel, ivec2(COLS, ROWS));
+
+  if (pixel.x < 0 || pixel.y < 0 || pixel.x >= COLS || pixel.y >= ROWS) {
+    if ((iStatus & FAULTED) != 0u)
+      oColour = vec4(0.9, 0.1, 0.1, 1.0);
+    else if ((iStatus & WAITING) != 0u)
+      oColour = vec4(1.0, 0.6, 0.0, 1.0);
+    else if ((iStatus & STALE) != 0u)
+      oColour = vec4(0.2, 0.2, 0.2, 1.0);
+    else
+      oColour = vec4(0.1, 0.5, 0.1, 1.0);
+    return;
+  }
+
+  oColour = uPalette[bitAt(pixel) ? 1 : 0];
+
+  // Label in yellow over the top rows, a stale tile is dimmed
+  if (pixel.y < LABEL_ROWS && bitAt(ivec2(pixel.x, ROWS + pixel.y)))
+    oColour = vec4(1.0, 1.0, 0.0, 1.0);
+
+  if ((iStatus & STALE) != 0u)
+    oColour.rgb *= 0.5;
+}
@@ -0,0 +1,26 @@
+#version 450 core
+
+/* Variables */
+
+// Columns and rows of the grid of tiles, filling the viewport
+uniform ivec2 uGrid;
+
+layout(location = 0) in vec2 aPosition; // Corner of the unit quad, y down
+layout(location = 1) in vec2 aTexCoord;
+layout(location = 2) in uint aStatus;   // Per tile
+
+layout(location = 0) out vec2 oTexCoord;
+layout(location = 1) flat out int oLayer;
+layout(location = 2) flat out uint oStatus;
+
+/* Functions */
+
+void main(void) {
+    ivec2 cell = ivec2(gl_InstanceID % uGrid.x, gl_InstanceID / uGrid.x);
+    vec2 corner = (vec2(cell) + aPosition) / vec2(uGrid);
+
+    oTexCoord = aTexCoord;
+    oLayer = gl_InstanceID;
+    oStatus = aStatus;
+    gl_Position = vec4(corner.x * 2.0 - 1.0, 1.0 - corner.y * 2.0, 0.0, 1.0);
+}
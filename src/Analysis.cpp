@@ -0,0 +1,242 @@
+#include "Analysis.hpp"
+
+#include <algorithm>
+
+static Instruction fetch(const uint8_t memory[4096], uint16_t address) {
+    return Decode(memory[address & 0xFFF] << 8 | memory[(address + 1) & 0xFFF]);
+}
+
+/**
+ * @brief Where the execution may go after an instruction, in the same way as Chip8::EmulateCycle
+ */
+static void successors(const Instruction &in, uint16_t address, std::vector<Analysis::Edge> &edges) {
+    using EdgeKind = Analysis::EdgeKind;
+
+    const uint16_t next = (address + 2) & 0xFFF;
+    const uint16_t skip = (address + 4) & 0xFFF;
+
+    edges.clear();
+    switch (in.op) {
+        case Op::JP:
+            edges.push_back({in.nnn, EdgeKind::Jump});
+            break;
+
+        case Op::CALL:
+            edges.push_back({in.nnn, EdgeKind::Call});
+            edges.push_back({next, EdgeKind::Return});
+            break;
+
+        case Op::SE_NN:
+        case Op::SNE_NN:
+        case Op::SE_VY:
+        case Op::SNE_VY:
+        case Op::SKP:
+        case Op::SKNP:
+            edges.push_back({next, EdgeKind::Next});
+            edges.push_back({skip, EdgeKind::Skip});
+            break;
+
+        // The core stops, or the target is only known at run time
+        case Op::RET:
+        case Op::JP_V0:
+        case Op::SYS:
+        case Op::INVALID:
+            break;
+
+        default:
+            edges.push_back({next, EdgeKind::Next});
+            break;
+    }
+}
+
+/**
+ * @brief True if the instruction does not simply fall through to the next one
+ */
+static bool endsBlock(const Instruction &in, uint16_t address, std::vector<Analysis::Edge> &edges) {
+    successors(in, address, edges);
+    return edges.size() != 1 || edges[0].kind != Analysis::EdgeKind::Next;
+}
+
+Analysis Analysis::Analyze(const uint8_t memory[4096], size_t size) {
+    Analysis analysis;
+    analysis.Explore(memory);
+    analysis.BuildBlocks(memory);
+    analysis.TrackIndex(memory);
+    analysis.FindUnreachable(memory, size);
+
+    std::sort(analysis.m_findings.begin(), analysis.m_findings.end(),
+              [](const Finding &a, const Finding &b) { return a.address < b.address; });
+
+    return analysis;
+}
+
+void Analysis::Explore(const uint8_t memory[4096]) {
+    std::vector<uint16_t> pending = {0x200};
+    std::vector<Edge> edges;
+
+    while (!pending.empty()) {
+        const uint16_t address = pending.back();
+        pending.pop_back();
+
+        if (m_flags[address] & CODE)
+            continue;
+
+        m_flags[address] |= CODE | CODE_BYTE;
+        m_flags[(address + 1) & 0xFFF] |= CODE_BYTE;
+        m_code.push_back(address);
+
+        const Instruction in = fetch(memory, address);
+        if (in.op == Op::SYS || in.op == Op::INVALID)
+            m_findings.push_back({FindingKind::InvalidInstruction, address, 0, 2});
+        else if (in.op == Op::JP_V0)
+            m_findings.push_back({FindingKind::ComputedJump, address, in.nnn, 0});
+
+        successors(in, address, edges);
+        for (const Edge &edge : edges)
+            pending.push_back(edge.target);
+    }
+
+    std::sort(m_code.begin(), m_code.end());
+}
+
+void Analysis::BuildBlocks(const uint8_t memory[4096]) {
+    std::vector<Edge> edges;
+
+    // Leaders: the entry point and every target of an instruction ending a block
+    m_flags[0x200] |= BLOCK_START;
+    for (uint16_t address : m_code) {
+        if (endsBlock(fetch(memory, address), address, edges)) {
+            for (const Edge &edge : edges)
+                m_flags[edge.target] |= BLOCK_START;
+        }
+    }
+
+    for (uint16_t start : m_code) {
+        if (!(m_flags[start] & BLOCK_START))
+            continue;
+
+        Block block;
+        block.start = start;
+
+        uint16_t address = start;
+        for (int count = 0; count < 2048; ++count) {
+            const uint16_t next = (address + 2) & 0xFFF;
+            if (endsBlock(fetch(memory, address), address, edges) || !(m_flags[next] & CODE) || (m_flags[next] & BLOCK_START))
+                break;
+            address = next;
+        }
+
+        block.end = (address + 2) & 0xFFF;
+        block.successors = edges;
+        m_blocks.push_back(block);
+    }
+}
+
+void Analysis::TrackIndex(const uint8_t memory[4096]) {
+    for (const Block &block : m_blocks) {
+        bool known = false;
+        uint16_t I = 0;
+
+        auto mark = [&](uint16_t address, int size, uint8_t flag) {
+            for (int i = 0; i < size; ++i)
+                m_flags[(I + i) & 0xFFF] |= flag;
+
+            if (flag != WRITTEN)
+                return;
+
+            for (int i = 0; i < size; ++i) {
+                if (m_flags[(I + i) & 0xFFF] & CODE_BYTE) {
+                    m_findings.push_back({FindingKind::SelfModifyingWrite, address, I, static_cast<uint16_t>(size)});
+                    break;
+                }
+            }
+        };
+
+        for (uint16_t address = block.start; address != block.end; address = (address + 2) & 0xFFF) {
+            const Instruction in = fetch(memory, address);
+
+            switch (in.op) {
+                case Op::LD_I:
+                    known = true;
+                    I = in.nnn;
+                    break;
+
+                case Op::ADD_I_VX:
+                case Op::LD_F_VX:
+                    known = false;
+                    break;
+
+                case Op::DRW:
+                    if (known)
+                        mark(address, in.n, DATA);
+                    break;
+
+                case Op::LD_B_VX:
+                    if (known)
+                        mark(address, 3, WRITTEN);
+                    break;
+
+                case Op::LD_I_VX:
+                case Op::LD_VX_I:
+                    if (known) {
+                        mark(address, in.x + 1, in.op == Op::LD_I_VX ? WRITTEN : DATA);
+                        I += in.x + 1;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+}
+
+void Analysis::FindUnreachable(const uint8_t memory[4096], size_t size) {
+    const size_t end = std::min<size_t>(0x200 + size, 4096);
+
+    // Regions neither executed nor read, reported only if every word of it is a valid instruction,
+    // so sprites and padding are not mistaken for code
+    size_t address = 0x200;
+    while (address < end) {
+        if (m_flags[address] & (CODE_BYTE | DATA)) {
+            ++address;
+            continue;
+        }
+
+        size_t regionEnd = address;
+        while (regionEnd < end && !(m_flags[regionEnd] & (CODE_BYTE | DATA)))
+            ++regionEnd;
+
+        bool code = regionEnd - address >= 4;
+        for (size_t i = address; code && i + 1 < regionEnd; i += 2) {
+            const Op op = fetch(memory, static_cast<uint16_t>(i)).op;
+            code = op != Op::SYS && op != Op::INVALID;
+        }
+
+        if (code)
+            m_findings.push_back({FindingKind::UnreachableCode, static_cast<uint16_t>(address), 0, static_cast<uint16_t>(regionEnd - address)});
+
+        address = regionEnd;
+    }
+}
+
+const char *Analysis::FindingName(FindingKind kind) {
+    switch (kind) {
+        case FindingKind::SelfModifyingWrite: return "self-modifying write";
+        case FindingKind::ComputedJump:       return "computed jump";
+        case FindingKind::UnreachableCode:    return "unreachable code";
+        case FindingKind::InvalidInstruction: return "invalid instruction";
+        default:                              return "?";
+    }
+}
+
+const char *Analysis::EdgeName(EdgeKind kind) {
+    switch (kind) {
+        case EdgeKind::Next:   return "next";
+        case EdgeKind::Skip:   return "skip";
+        case EdgeKind::Jump:   return "jump";
+        case EdgeKind::Call:   return "call";
+        case EdgeKind::Return: return "return";
+        default:               return "?";
+    }
+}
@@ -0,0 +1,15 @@
+#include "Aot.hpp"
+
+static std::vector<const AotProgram *> &programs() {
+    static std::vector<const AotProgram *> list;
+    return list;
+}
+
+bool AotRegister(const AotProgram *program) {
+    programs().push_back(program);
+    return true;
+}
+
+const std::vector<const AotProgram *> &AotPrograms() {
+    return programs();
+}
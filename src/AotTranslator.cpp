@@ -0,0 +1,450 @@
+#include "AotTranslator.hpp"
+
+#include "Analysis.hpp"
+#include "Decode.hpp"
+
+#include <cstdio>
+#include <sstream>
+#include <vector>
+
+static std::string hex(unsigned value, int digits) {
+    char text[16];
+    snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+static std::string label(uint16_t address) {
+    char text[8];
+    snprintf(text, sizeof(text), "L%03X", address);
+    return text;
+}
+
+static std::string reg(int index) {
+    char text[16];
+    snprintf(text, sizeof(text), "r.V[0x%X]", index);
+    return text;
+}
+
+/**
+ * @brief Bit of each page holding a byte of the instruction at address
+ */
+static uint16_t pageMask(uint16_t address) {
+    return static_cast<uint16_t>(1 << ((address >> 8) & 0xF) | 1 << (((address + 1) >> 8) & 0xF));
+}
+
+namespace {
+
+/**
+ * State of one translation, the code of every instruction is generated before the labels are known.
+ */
+class Translation {
+private:
+    const uint8_t *m_memory;
+    const Analysis &m_analysis;
+    const size_t m_end;
+
+    std::vector<uint16_t> m_addresses;
+    std::vector<bool> m_translated = std::vector<bool>(4096);
+    std::vector<bool> m_targets = std::vector<bool>(4096);
+    bool m_dispatch = false;
+
+    // Address emitted after the current instruction, where the code falls through
+    uint16_t m_follow = 0;
+
+    uint16_t opcodeAt(uint16_t address) const { return m_memory[address & 0xFFF] << 8 | m_memory[(address + 1) & 0xFFF]; }
+
+    /**
+     * @brief Count the instruction and continue at target, returning when the budget is spent
+     */
+    void Transfer(std::ostream &out, uint32_t target) {
+        if (target >= 4096 || !m_translated[target]) {
+            out << "        ++executed;\n";
+            out << "        r.pc = " << hex(target, 3) << ";\n";
+            out << "        goto leave;\n";
+            return;
+        }
+
+        out << "        if (++executed == budget) { r.pc = " << hex(target, 3) << "; goto leave; }\n";
+        if (target != m_follow) {
+            out << "        goto " << label(target) << ";\n";
+            m_targets[target] = true;
+        }
+    }
+
+    /**
+     * @brief Count the instruction and continue at the pc computed at run time
+     */
+    void Dispatch(std::ostream &out) {
+        out << "        if (++executed == budget) goto leave;\n";
+        out << "        goto dispatch;\n";
+        m_dispatch = true;
+    }
+
+    /**
+     * @brief Continue at the next or the skipped instruction depending on condition
+     */
+    void Skip(std::ostream &out, uint16_t address, const std::string &condition) {
+        out << "        if (" << condition << ") {\n";
+        std::ostringstream taken;
+        const uint16_t follow = m_follow;
+        m_follow = 0xFFFF;
+        Transfer(taken, address + 4);
+        m_follow = follow;
+
+        // Indent the taken branch
+        std::string line;
+        std::istringstream lines(taken.str());
+        while (std::getline(lines, line))
+            out << "    " << line << "\n";
+        out << "        }\n";
+        Transfer(out, address + 2);
+    }
+
+    static void EmitFault(std::ostream &out, uint16_t address, const char *fault) {
+        out << "        r.pc = " << hex(address, 3) << ";\n";
+        out << "        m.Fault(Fault::" << fault << ");\n";
+        out << "        goto leave;\n";
+    }
+
+    /**
+     * @brief Leave after writing memory, when the next instruction was overwritten
+     */
+    static void CheckWrite(std::ostream &out, uint16_t next) {
+        out << "        if (m.modified(" << hex(pageMask(next), 4) << ")) { ++executed; r.pc = " << hex(next, 3)
+            << "; goto leave; }\n";
+    }
+
+    void Emit(std::ostream &out, uint16_t address) {
+        const Instruction in = Decode(opcodeAt(address));
+        const std::string vx = reg(in.x);
+        const std::string vy = reg(in.y);
+        const std::string vf = reg(0xF);
+        const uint16_t next = address + 2;
+
+        switch (in.op) {
+            case Op::CLS:
+                out << "        m.Clear();\n";
+                Transfer(out, next);
+                break;
+
+            case Op::RET:
+                out << "        if (r.sp == 0) {\n";
+                out << "            r.pc = " << hex(address, 3) << ";\n";
+                out << "            m.Fault(Fault::StackUnderflow);\n";
+                out << "            goto leave;\n";
+                out << "        }\n";
+                out << "        r.pc = m.stack()[--r.sp];\n";
+                Dispatch(out);
+                break;
+
+            case Op::JP:
+                Transfer(out, in.nnn);
+                break;
+
+            case Op::CALL:
+                out << "        if (r.sp == 16) {\n";
+                out << "            r.pc = " << hex(address, 3) << ";\n";
+                out << "            m.Fault(Fault::StackOverflow);\n";
+                out << "            goto leave;\n";
+                out << "        }\n";
+                out << "        m.stack()[r.sp++] = " << hex(next, 3) << ";\n";
+                Transfer(out, in.nnn);
+                break;
+
+            case Op::SE_NN:
+                Skip(out, address, vx + " == " + hex(in.nn, 2));
+                break;
+
+            case Op::SNE_NN:
+                Skip(out, address, vx + " != " + hex(in.nn, 2));
+                break;
+
+            case Op::SE_VY:
+                Skip(out, address, vx + " == " + vy);
+                break;
+
+            case Op::LD_NN:
+                out << "        " << vx << " = " << hex(in.nn, 2) << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::ADD_NN:
+                out << "        " << vx << " += " << hex(in.nn, 2) << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::LD_VY:
+                out << "        " << vx << " = " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::OR:
+                out << "        " << vx << " |= " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::AND:
+                out << "        " << vx << " &= " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::XOR:
+                out << "        " << vx << " ^= " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            // VF is written first, as in EmulateCycle, which matters when X or Y is F
+            case Op::ADD_VY:
+                out << "        " << vf << " = ((int)" << vx << " + (int)" << vy << ") > 0xFF ? 1 : 0;\n";
+                out << "        " << vx << " += " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SUB:
+                out << "        " << vf << " = (" << vx << " > " << vy << ") ? 1 : 0;\n";
+                out << "        " << vx << " -= " << vy << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SHR:
+                out << "        " << vf << " = " << vx << " & 0x1;\n";
+                out << "        " << vx << " = " << vx << " >> 1;\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SUBN:
+                out << "        " << vf << " = (" << vy << " > " << vx << ") ? 1 : 0;\n";
+                out << "        " << vx << " = " << vy << " - " << vx << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SHL:
+                out << "        " << vf << " = (" << vx << " >> 7) & 0x1;\n";
+                out << "        " << vx << " = " << vx << " << 1;\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SNE_VY:
+                Skip(out, address, vx + " != " + vy);
+                break;
+
+            case Op::LD_I:
+                out << "        r.I = " << hex(in.nnn, 3) << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::JP_V0:
+                out << "        r.pc = (r.V[0x0] + " << hex(in.nnn, 3) << ") & 0xFFF;\n";
+                Dispatch(out);
+                break;
+
+            case Op::RND:
+                out << "        " << vx << " = m.Random() & " << hex(in.nn, 2) << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::DRW:
+                out << "        " << vf << " = m.Draw(r.I, " << vx << ", " << vy << ", " << int(in.n) << ");\n";
+                Transfer(out, next);
+                break;
+
+            case Op::SKP:
+                Skip(out, address, "(r.keys >> (" + vx + " & 0xF)) & 1");
+                break;
+
+            case Op::SKNP:
+                Skip(out, address, "!((r.keys >> (" + vx + " & 0xF)) & 1)");
+                break;
+
+            case Op::LD_VX_DT:
+                out << "        " << vx << " = r.delayTimer;\n";
+                Transfer(out, next);
+                break;
+
+            // The keys do not change during a run, so the wait spends the whole budget
+            case Op::LD_VX_K:
+                out << "        if (!r.keys) {\n";
+                out << "            r.pc = " << hex(address, 3) << ";\n";
+                out << "            executed = budget;\n";
+                out << "            goto leave;\n";
+                out << "        }\n";
+                out << "        {\n";
+                out << "            int i = 0;\n";
+                out << "            while (!((r.keys >> i) & 1))\n";
+                out << "                ++i;\n";
+                out << "            " << vx << " = i;\n";
+                out << "        }\n";
+                Transfer(out, next);
+                break;
+
+            case Op::LD_DT_VX:
+                out << "        r.delayTimer = " << vx << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::LD_ST_VX:
+                out << "        r.soundTimer = " << vx << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::ADD_I_VX:
+                out << "        r.I += " << vx << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::LD_F_VX:
+                out << "        r.I = FONTSET_BYTES_PER_CHAR * " << vx << ";\n";
+                Transfer(out, next);
+                break;
+
+            case Op::LD_B_VX:
+                out << "        m.Write(r.I, (" << vx << " % 1000) / 100);\n";
+                out << "        m.Write(r.I + 1, (" << vx << " % 100) / 10);\n";
+                out << "        m.Write(r.I + 2, " << vx << " % 10);\n";
+                CheckWrite(out, next);
+                Transfer(out, next);
+                break;
+
+            case Op::LD_I_VX:
+                for (int i = 0; i <= in.x; ++i)
+                    out << "        m.Write(r.I + " << i << ", " << reg(i) << ");\n";
+                out << "        r.I += " << in.x + 1 << ";\n";
+                CheckWrite(out, next);
+                Transfer(out, next);
+                break;
+
+            case Op::LD_VX_I:
+                for (int i = 0; i <= in.x; ++i)
+                    out << "        " << reg(i) << " = m.Read(r.I + " << i << ");\n";
+                out << "        r.I += " << in.x + 1 << ";\n";
+                Transfer(out, next);
+                break;
+
+            default:
+                EmitFault(out, address, "UnknownOpcode");
+                break;
+        }
+    }
+
+public:
+    Translation(const uint8_t memory[4096], size_t size, const Analysis &analysis)
+        : m_memory(memory), m_analysis(analysis), m_end(0x200 + size) {
+        // Only the instructions inside the ROM, the program image covers nothing else
+        for (uint16_t address : analysis.code()) {
+            if (address >= 0x200 && address + 2u <= m_end) {
+                m_addresses.push_back(address);
+                m_translated[address] = true;
+            }
+        }
+    }
+
+    inline size_t instructions() const { return m_addresses.size(); }
+
+    void Write(std::ostream &out) {
+        // Generate every case first, the labels are only emitted where a goto lands
+        std::vector<std::string> bodies;
+        for (size_t i = 0; i < m_addresses.size(); ++i) {
+            const uint16_t address = m_addresses[i];
+            m_follow = i + 1 < m_addresses.size() ? m_addresses[i + 1] : 0xFFFF;
+
+            std::ostringstream body;
+
+            // Entering a block or another page, check the code was not overwritten since
+            const bool pageChange = i == 0 || m_addresses[i - 1] + 2 != address ||
+                                    pageMask(m_addresses[i - 1]) != pageMask(address);
+            if ((m_analysis.flags(address) & Analysis::BLOCK_START) || pageChange)
+                body << "        if (m.modified(" << hex(pageMask(address), 4) << ")) { r.pc = " << hex(address, 3)
+                     << "; goto leave; }\n";
+
+            Emit(body, address);
+            bodies.push_back(body.str());
+        }
+
+        out << "int run(Chip8 &chip8, int budget) {\n";
+        out << "    AotMachine m(chip8);\n";
+        out << "    AotRegisters r = m.Load();\n";
+        out << "    int executed = 0;\n\n";
+        if (m_dispatch)
+            out << "dispatch:\n";
+        out << "    // Entering in the middle of a block, the code of pc may have been overwritten since\n";
+        out << "    if (m.modified(static_cast<uint16_t>(3 << ((r.pc >> 8) & 0xF))))\n";
+        out << "        goto leave;\n\n";
+        out << "    switch (r.pc) {\n";
+
+        for (size_t i = 0; i < m_addresses.size(); ++i) {
+            const uint16_t address = m_addresses[i];
+            out << "    case " << hex(address, 3) << ":";
+            if (m_targets[address])
+                out << " " << label(address) << ":";
+            out << " // " << hex(opcodeAt(address), 4) << "  " << Disassemble(opcodeAt(address)) << "\n";
+            out << bodies[i];
+        }
+
+        out << "    default:\n";
+        out << "        break;\n";
+        out << "    }\n\n";
+        out << "leave:\n";
+        out << "    m.Store(r);\n";
+        out << "    return executed;\n";
+        out << "}\n";
+    }
+};
+
+} // namespace
+
+AotTranslator::Stats AotTranslator::Translate(std::ostream &out, const std::string &symbol, const std::string &name,
+                                              const uint8_t memory[4096], size_t size) {
+    const Analysis analysis = Analysis::Analyze(memory, size);
+    Translation translation(memory, size, analysis);
+
+    Stats stats;
+    stats.instructions = translation.instructions();
+    stats.blocks = analysis.blocks().size();
+    for (const Analysis::Finding &finding : analysis.findings()) {
+        if (finding.kind == Analysis::FindingKind::ComputedJump)
+            ++stats.computedJumps;
+        else if (finding.kind == Analysis::FindingKind::SelfModifyingWrite)
+            ++stats.selfModifyingWrites;
+    }
+
+    out << "// Translated by chip8-aot from " << name << ", do not edit\n";
+    out << "//\n";
+    out << "// " << stats.instructions << " instructions in " << stats.blocks << " blocks, " << stats.computedJumps
+        << " computed jumps, " << stats.selfModifyingWrites << " self-modifying writes\n\n";
+    out << "#include \"Aot.hpp\"\n";
+    out << "#include \"Const.hpp\"\n\n";
+    out << "namespace {\n\n";
+
+    out << "const uint8_t IMAGE[] = {";
+    for (size_t i = 0; i < size; ++i)
+        out << (i % 12 ? " " : "\n    ") << hex(memory[0x200 + i], 2) << (i + 1 < size ? "," : "");
+    out << "\n};\n\n";
+
+    // Bitmap of the bytes of the translated instructions
+    uint8_t code[512] = {};
+    for (uint16_t address = 0x200; address + 2u <= 0x200 + size; ++address) {
+        if (!analysis.isCode(address))
+            continue;
+        code[address >> 3] |= 1 << (address & 7);
+        code[(address + 1) >> 3] |= 1 << ((address + 1) & 7);
+    }
+
+    // The bytes after the last translated instruction are left to the zero initialisation
+    int used = 512;
+    while (used > 0 && !code[used - 1])
+        --used;
+
+    out << "const uint8_t CODE[512] = {";
+    for (int i = 0; i < used; ++i)
+        out << (i % 16 ? " " : "\n    ") << hex(code[i], 2) << (i + 1 < used ? "," : "");
+    out << "\n};\n\n";
+
+    translation.Write(out);
+
+    out << "\n} // namespace\n\n";
+    out << "extern const AotProgram " << symbol << ";\n";
+    out << "const AotProgram " << symbol << " = {\"" << name << "\", IMAGE, sizeof(IMAGE), CODE, run};\n\n";
+    out << "[[maybe_unused]] static const bool REGISTERED = AotRegister(&" << symbol << ");\n";
+
+    return stats;
+}
@@ -0,0 +1,95 @@
+#include "Arena.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+// Mappings from the reserved huge pages must be a multiple of their size
+static const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+static size_t roundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+Arena::Arena(size_t capacity) : m_capacity(roundUp(capacity, HUGE_PAGE_SIZE)) {
+#ifdef _WIN32
+    m_base = static_cast<char *>(VirtualAlloc(nullptr, m_capacity, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+
+    void *base = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    // Without MAP_NORESERVE the mapping fails, rather than faulting later, when too few huge pages are reserved
+    base = mmap(nullptr, m_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (base != MAP_FAILED)
+        m_hugePages = HugePages::Explicit;
+#endif
+
+    if (base == MAP_FAILED) {
+        base = mmap(nullptr, m_capacity, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+#ifdef MADV_HUGEPAGE
+        if (base != MAP_FAILED && madvise(base, m_capacity, MADV_HUGEPAGE) == 0)
+            m_hugePages = HugePages::Transparent;
+#endif
+    }
+
+    m_base = base != MAP_FAILED ? static_cast<char *>(base) : nullptr;
+#endif
+
+    if (!m_base) {
+        throw std::runtime_error("Not be able to reserve " + std::to_string(m_capacity) + " bytes for the arena!");
+    }
+}
+
+Arena::~Arena() {
+#ifdef _WIN32
+    VirtualFree(m_base, 0, MEM_RELEASE);
+#else
+    munmap(m_base, m_capacity);
+#endif
+}
+
+void *Arena::Allocate(size_t size) {
+    size = roundUp(size, ALIGNMENT);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    void *&head = m_free[size];
+    if (head) {
+        void *block = head;
+        head = *static_cast<void **>(block);
+        m_used += size;
+        return block;
+    }
+
+    if (m_capacity - m_top < size)
+        throw std::bad_alloc();
+
+    void *block = m_base + m_top;
+    m_top += size;
+    m_used += size;
+    return block;
+}
+
+void Arena::Free(void *block, size_t size) {
+    if (!block)
+        return;
+
+    size = roundUp(size, ALIGNMENT);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    void *&head = m_free[size];
+    *static_cast<void **>(block) = head;
+    head = block;
+    m_used -= size;
+}
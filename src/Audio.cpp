@@ -1,28 +1,68 @@
 #include "Audio.hpp"
 
-#ifdef _WIN32
-#define _USE_MATH_DEFINES
-#endif
-#include <cmath>
 #include <array>
+#include <iostream>
 #include <stdexcept>
 
-Audio::Audio() : m_source(0), m_buffer(0), m_device(nullptr), m_context(nullptr) {
-    // Opening the device
-    m_device = alcOpenDevice(nullptr);
-    if (!m_device) {
-        throw std::runtime_error("We cannot open an audio device!");
-    }
+static constexpr int SAMPLE_RATE = 44100;
+static constexpr int BEEP_FREQUENCY = 400;
+static constexpr int BEEP_SAMPLES = SAMPLE_RATE; // One second
+
+/**
+ * @brief Square wave of the beep, high over the first half of each period
+ */
+static const std::array<short, BEEP_SAMPLES> &beep() {
+    // Filled once on the thread opening the device, not at compile time: a second of samples
+    // can exceed the constexpr evaluation limit of some compilers
+    static const std::array<short, BEEP_SAMPLES> samples = [] {
+        std::array<short, BEEP_SAMPLES> wave{};
+        for (int i = 0; i < BEEP_SAMPLES; i++)
+            wave[i] = (i * BEEP_FREQUENCY) % SAMPLE_RATE * 2 < SAMPLE_RATE ? 32760 : -32760;
+        return wave;
+    }();
+    return samples;
+}
 
-    // Creating the context
-    m_context = alcCreateContext(m_device, nullptr);
-    if (!m_context) {
-        throw std::runtime_error("We cannot create an audio context!");
-    }
+Audio::Audio() : m_source(0), m_buffer(0), m_device(nullptr), m_context(nullptr) {}
+
+Audio::~Audio() {
+    if (m_opener.joinable())
+        m_opener.join();
+
+    closeDevice();
+}
+
+void Audio::Open() {
+    if (m_opening.exchange(true))
+        return;
 
-    // Context activation
-    if (!alcMakeContextCurrent(m_context)) {
-        throw std::runtime_error("We cannot activate the audio context!");
+    m_opener = std::thread(&Audio::openDevice, this);
+}
+
+void Audio::openDevice() {
+    StartupTrace::Span span(m_trace, "audio device");
+
+    try {
+        // Opening the device
+        m_device = alcOpenDevice(nullptr);
+        if (!m_device) {
+            throw std::runtime_error("We cannot open an audio device!");
+        }
+
+        // Creating the context
+        m_context = alcCreateContext(m_device, nullptr);
+        if (!m_context) {
+            throw std::runtime_error("We cannot create an audio context!");
+        }
+
+        // Context activation, for every thread
+        if (!alcMakeContextCurrent(m_context)) {
+            throw std::runtime_error("We cannot activate the audio context!");
+        }
+    } catch (const std::exception &e) {
+        std::cout << e.what() << " The sound is disabled." << std::endl;
+        closeDevice();
+        return;
     }
 
     // Creating a source
@@ -40,56 +80,85 @@ Audio::Audio() : m_source(0), m_buffer(0), m_device(nullptr), m_context(nullptr)
 
     // We attach the buffer containing the audio samples to the source
     alSourcei(m_source, AL_BUFFER, m_buffer);
+
+    // Start the beep which opened the device
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ready = true;
+    if (m_beeping)
+        alSourcePlay(m_source);
 }
 
-Audio::~Audio() {
-    // Destruction of the buffer
-    alDeleteBuffers(1, &m_buffer);
+void Audio::closeDevice() {
+    if (m_ready) {
+        // Destruction of the buffer
+        alDeleteBuffers(1, &m_buffer);
+
+        // Destruction of the source
+        alSourcei(m_source, AL_BUFFER, 0);
+        alDeleteSources(1, &m_source);
+    }
 
-    // Destruction of the source
-    alSourcei(m_source, AL_BUFFER, 0);
-    alDeleteSources(1, &m_source);
+    if (m_context) {
+        // Deactivation of the context
+        alcMakeContextCurrent(nullptr);
 
-    // Deactivation of the context
-    alcMakeContextCurrent(nullptr);
+        // Destruction of the context
+        alcDestroyContext(m_context);
+    }
 
-    // Destruction of the context
-    alcDestroyContext(m_context);
+    if (m_device) {
+        // Closing the device
+        alcCloseDevice(m_device);
+    }
 
-    // Closing the device
-    alcCloseDevice(m_device);
+    m_ready = false;
+    m_context = nullptr;
+    m_device = nullptr;
 }
 
-void Audio::playBeep() const {
+bool Audio::isPlaying() const {
     ALint state = 0;
     alGetSourcei(m_source, AL_SOURCE_STATE, &state);
-    if (state != AL_PLAYING) {
+    return state == AL_PLAYING;
+}
+
+void Audio::checkUnderrun() const {
+    if (m_beeping && m_metrics)
+        m_metrics->audioUnderruns.Add();
+}
+
+void Audio::playBeep() {
+    // Opened on the first beep, which starts once the device is ready
+    Open();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_ready && !isPlaying()) {
+        checkUnderrun();
+
         // Sound playback
         alSourcePlay(m_source);
     }
+
+    m_beeping = true;
 }
 
-void Audio::stopAudio() const {
-    ALint state = 0;
-    alGetSourcei(m_source, AL_SOURCE_STATE, &state);
-    if (state == AL_PLAYING) {
-        alSourceStop(m_source);
+void Audio::stopAudio() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_ready) {
+        if (isPlaying()) {
+            alSourceStop(m_source);
+        } else {
+            checkUnderrun();
+        }
     }
+
+    m_beeping = false;
 }
 
 void Audio::createBuffer() {
-    constexpr auto freq = 400.0f;
-    constexpr auto seconds = 1;
-    constexpr auto sampleRate = 44100;
-    constexpr auto buffSize = seconds * sampleRate;
-    std::array<short, buffSize> samples;
-
-    for (int i = 0; i < buffSize; i++)
-    {
-        auto wave = static_cast<short>(32760 * sin((2.0f * M_PI * freq) / sampleRate * i));
-        samples[i] = (short)(wave > 0 ? 32760 : -32760);
-    }
-
     // Filling with samples
-    alBufferData(m_buffer, AL_FORMAT_MONO16, samples.data(), buffSize, sampleRate);
-}
\ No newline at end of file
+    const std::array<short, BEEP_SAMPLES> &samples = beep();
+    alBufferData(m_buffer, AL_FORMAT_MONO16, samples.data(), sizeof(samples), SAMPLE_RATE);
+}
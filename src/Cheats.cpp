@@ -0,0 +1,37 @@
+#include "Cheats.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+void Cheats::Freeze(uint16_t address, uint8_t value) {
+    address &= 0xFFF;
+
+    for (Cheat &cheat : m_cheats) {
+        if (cheat.address == address) {
+            cheat.value = value;
+            return;
+        }
+    }
+
+    m_cheats.push_back({address, value});
+}
+
+void Cheats::Unfreeze(uint16_t address) {
+    address &= 0xFFF;
+
+    m_cheats.erase(std::remove_if(m_cheats.begin(), m_cheats.end(), [&](const Cheat &cheat) { return cheat.address == address; }),
+                   m_cheats.end());
+}
+
+Cheat Cheats::Parse(const std::string &cheat) {
+    const size_t equal = cheat.find('=');
+    if (equal == std::string::npos)
+        throw std::invalid_argument("A cheat must be given as ADDRESS=VALUE in hexadecimal (e.g. 2F0=09).");
+
+    const unsigned long address = std::stoul(cheat.substr(0, equal), nullptr, 16);
+    const unsigned long value = std::stoul(cheat.substr(equal + 1), nullptr, 16);
+    if (address > 0xFFF || value > 0xFF)
+        throw std::invalid_argument("The cheat " + cheat + " does not fit a byte of the 4K of memory.");
+
+    return {static_cast<uint16_t>(address), static_cast<uint8_t>(value)};
+}
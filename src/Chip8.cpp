@@ -1,15 +1,33 @@
 #include "Chip8.hpp"
 
+#include "Aot.hpp"
 #include "Log.hpp"
 #include "Const.hpp"
+#include "Analysis.hpp"
+#include "RomStore.hpp"
 
+#include <algorithm>
+#include <cstddef>
 #include <stdexcept>
-#include <fstream>
-#include <ios>
 #include <cstring>
 
-#include <stdlib.h> /* srand, rand */
-#include <time.h>   /* time */
+void Chip8::CheckLayout() {
+    // offsetof is only conditionally supported on a class that is not standard-layout, every
+    // supported compiler computes it for one without virtual bases
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Winvalid-offsetof"
+#endif
+    static_assert(offsetof(Chip8, V) + sizeof(V) <= 64, "V must be in the first cache line.");
+    static_assert(offsetof(Chip8, I) + sizeof(I) <= 64, "I must be in the first cache line.");
+    static_assert(offsetof(Chip8, pc) + sizeof(pc) <= 64, "pc must be in the first cache line.");
+    static_assert(offsetof(Chip8, sp) + sizeof(sp) <= 64, "sp must be in the first cache line.");
+    static_assert(offsetof(Chip8, stack) + sizeof(stack) <= 64, "The stack must be in the first cache line.");
+    static_assert(offsetof(Chip8, m_pages) == 64, "The cold state must start on the second cache line.");
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+}
 
 void Chip8::Initialize() {
     pc       = 0x200; // Program counter starts at 0x200
@@ -18,7 +36,7 @@ void Chip8::Initialize() {
     drawFlag = true;
 
     // Clear display
-    renderer.Clear();
+    memset(WritableScreen().pixels, 0, sizeof(Framebuffer::pixels));
 
     // Clear stack
     memset(stack, 0, sizeof(uint16_t) * 16);
@@ -27,62 +45,290 @@ void Chip8::Initialize() {
     memset(V, 0, sizeof(uint8_t) * 16);
 
     // Clear memory
-    memset(memory, 0, sizeof(uint8_t) * 4096);
+    for (int i = 0; i < MemoryPage::COUNT; ++i)
+        memset(WritablePage(i), 0, MemoryPage::SIZE);
 
     // Load fontset
     for (int i = 0; i < 80; ++i)
-        memory[FONTSET_ADDRESS + i] = FONTSET[i];
+        WritablePage((FONTSET_ADDRESS + i) >> 8)[(FONTSET_ADDRESS + i) & 0xFF] = FONTSET[i];
 
     // Reset timers
     delayTimer = 0;
     soundTimer = 0;
+
+    m_fault = Fault::None;
+    m_carriedCycles = 0;
+
+    if (m_decodeCache)
+        WritableDecodeCache().Clear();
+
+    if (m_program)
+        CheckProgram();
 }
 
-void Chip8::LoadGame(const std::string& gamePath) {
-    const int bufferSize = MAX_GAME_SIZE;
-    char buffer[bufferSize];
+void Chip8::Fork(Chip8 &child) const {
+    for (int i = 0; i < MemoryPage::COUNT; ++i)
+        child.m_pages[i] = m_pages[i];
+    child.m_screen = m_screen;
+    child.m_decodeCache = m_decodeCache;
+    child.m_decodeStore = m_decodeStore;
+    child.m_program = m_program;
+    child.m_modifiedCode = m_modifiedCode;
+
+    memcpy(child.V, V, sizeof(V));
+    child.I = I;
+    child.pc = pc;
+    child.delayTimer = delayTimer;
+    child.soundTimer = soundTimer;
+    memcpy(child.stack, stack, sizeof(stack));
+    child.sp = sp;
+    child.drawFlag = drawFlag;
+    child.m_random = m_random;
+    child.m_fault = m_fault;
+    child.m_keys = m_keys;
+    child.m_carriedCycles = m_carriedCycles;
+}
+
+void Chip8::CopyMemory(uint8_t image[4096]) const {
+    for (int i = 0; i < MemoryPage::COUNT; ++i)
+        memcpy(image + i * MemoryPage::SIZE, m_pages[i]->bytes, MemoryPage::SIZE);
+}
 
-    std::ifstream gameFile(gamePath, std::ios::in | std::ios::binary);
+void Chip8::Peek(uint16_t address, uint8_t *bytes, size_t size) const {
+    while (size > 0) {
+        address &= 0xFFF;
+        const size_t offset = address % MemoryPage::SIZE;
+        const size_t count = std::min(size, static_cast<size_t>(MemoryPage::SIZE) - offset);
+        memcpy(bytes, m_pages[address / MemoryPage::SIZE]->bytes + offset, count);
 
-    if (!gameFile) {
-        // An error occurred!
-        throw std::runtime_error("Not be able to read game file!");
+        bytes += count;
+        address += count;
+        size -= count;
     }
+}
+
+uint8_t *Chip8::WritablePage(int index) {
+    std::shared_ptr<MemoryPage> &page = m_pages[index];
+    if (!page)
+        page = Allocate<MemoryPage>();
+    else if (page.use_count() > 1)
+        page = Allocate<MemoryPage>(*page);
+    return page->bytes;
+}
+
+Framebuffer &Chip8::WritableScreen() {
+    if (!m_screen)
+        m_screen = Allocate<Framebuffer>();
+    else if (m_screen.use_count() > 1)
+        m_screen = Allocate<Framebuffer>(*m_screen);
+    return *m_screen;
+}
+
+DecodeCache &Chip8::WritableDecodeCache() {
+    if (m_decodeCache.use_count() > 1)
+        m_decodeCache = Allocate<DecodeCache>(*m_decodeCache);
+    return *m_decodeCache;
+}
+
+void Chip8::LoadGame(const std::string& gamePath) {
+    const RomImage image(gamePath);
+    LoadGame(image.data(), image.size());
+}
 
-    gameFile.read(buffer, bufferSize);
+void Chip8::LoadGame(const uint8_t *data, size_t size) {
+    if (size > MAX_GAME_SIZE) {
+        throw std::length_error("The game does not fit in memory!");
+    }
 
     // Start filling the memory at location: 0x200 == 512
-    for (int i = 0; i < bufferSize; ++i)
-        memory[i + 512] = buffer[i];
+    uint8_t image[4096];
+    CopyMemory(image);
+    memcpy(image + 0x200, data, size);
+    memset(image + 0x200 + size, 0, MAX_GAME_SIZE - size);
+
+    for (int i = 0x200 / MemoryPage::SIZE; i < MemoryPage::COUNT; ++i)
+        memcpy(WritablePage(i), image + i * MemoryPage::SIZE, MemoryPage::SIZE);
+
+    // Decode the reachable code now rather than on first execution, or reuse the stored decoding
+    if (m_decodeCache) {
+        DecodeCache &cache = WritableDecodeCache();
+
+        if (!m_prewarm) {
+            cache.Clear();
+        } else if (!(m_decodeStore && m_decodeStore->Load(data, size, image, cache))) {
+            cache.Clear();
+            cache.Prewarm(image, Analysis::Analyze(image, size).code());
+
+            if (m_decodeStore)
+                m_decodeStore->Save(data, size, cache);
+        }
+    }
 
-    gameFile.close();
+    if (m_program)
+        CheckProgram();
 }
 
-void Chip8::Idle(Context& context) {
-    // Emulate one cycle
-    EmulateCycle(context);
+Chip8::Backend Chip8::ParseBackend(const std::string& name) {
+    if (name == "switch")
+        return Backend::Switch;
+    if (name == "cached")
+        return Backend::Cached;
 
-    // The delay timer and the sound timer. 
-    // They both work the same way; they should be decremented by one 60 times per second (ie. at 60 Hz). 
-    // This is independent of the speed of the fetch/decode/execute loop below.
-    const constexpr double dt = 1.0 / 60.0;
-    
-    m_globalTimersDelta += context.dt();
-    while (m_globalTimersDelta > dt) {
-        m_globalTimersDelta = 0;
-        Tick(context);
+    throw std::invalid_argument("Unknown backend: " + name + " (expected switch or cached).");
+}
+
+Chip8::Timing Chip8::ParseTiming(const std::string& name) {
+    if (name == "instructions")
+        return Timing::Instructions;
+    if (name == "vip")
+        return Timing::Vip;
+
+    throw std::invalid_argument("Unknown timing: " + name + " (expected instructions or vip).");
+}
+
+void Chip8::SetBreakpoint(uint16_t address, bool enabled) {
+    if (!m_decodeCache) {
+        throw std::logic_error("Breakpoints need the cached backend!");
     }
+
+    WritableDecodeCache().SetBreakpoint(address, enabled);
 }
 
-void Chip8::Display(Context& context) {
+void Chip8::CheckWatchpoints(uint16_t address, int size, bool write) {
+    for (int i = 0; i < size; ++i) {
+        const uint16_t byte = (address + i) & 0xFFF;
+
+        for (const Watchpoint &watchpoint : *m_watchpoints) {
+            if ((write ? watchpoint.write : watchpoint.read) && byte >= watchpoint.address &&
+                byte < watchpoint.address + watchpoint.size) {
+                m_fault = Fault::Watchpoint;
+                m_watchAddress = byte;
+                return;
+            }
+        }
+    }
+}
+
+void Chip8::SetBackend(Backend backend) {
+    if (backend == Backend::Cached && !m_decodeCache)
+        m_decodeCache = Allocate<DecodeCache>();
+    else if (backend == Backend::Switch)
+        m_decodeCache.reset();
+}
+
+bool Chip8::Display(Framebuffer& frame) {
     // If the draw flag is set, update the screen
-    if(drawFlag) {
-        renderer.Display();
-        drawFlag = false;
+    if (!drawFlag)
+        return false;
+
+    frame = *m_screen;
+    drawFlag = false;
+    return true;
+}
+
+void Chip8::SaveState(Chip8State& state) const {
+    SaveRegisters(state);
+    CopyMemory(state.memory);
+    state.gfx = *m_screen;
+}
+
+void Chip8::SaveRegisters(Chip8State& state) const {
+    memcpy(state.V, V, sizeof(V));
+    state.I = I;
+    state.pc = pc;
+    state.delayTimer = delayTimer;
+    state.soundTimer = soundTimer;
+    memcpy(state.stack, stack, sizeof(stack));
+    state.sp = sp;
+    state.drawFlag = drawFlag;
+    state.random = m_random;
+    state.fault = m_fault;
+    state.carriedCycles = m_carriedCycles;
+}
+
+void Chip8::LoadState(const Chip8State& state) {
+    // Only the pages that differ are written, so shared pages stay shared and the decoding of
+    // unchanged code is kept
+    for (int i = 0; i < MemoryPage::COUNT; ++i) {
+        const uint8_t *bytes = state.memory + i * MemoryPage::SIZE;
+        if (memcmp(m_pages[i]->bytes, bytes, MemoryPage::SIZE) == 0)
+            continue;
+
+        memcpy(WritablePage(i), bytes, MemoryPage::SIZE);
+        if (m_decodeCache && m_decodeCache->Decoded(i * MemoryPage::SIZE, MemoryPage::SIZE))
+            WritableDecodeCache().Invalidate(i * MemoryPage::SIZE, MemoryPage::SIZE);
+    }
+
+    memcpy(V, state.V, sizeof(V));
+    I = state.I;
+    pc = state.pc;
+    delayTimer = state.delayTimer;
+    soundTimer = state.soundTimer;
+    memcpy(stack, state.stack, sizeof(stack));
+    sp = state.sp;
+    if (memcmp(m_screen->pixels, state.gfx.pixels, sizeof(state.gfx.pixels)) != 0)
+        WritableScreen() = state.gfx;
+    drawFlag = state.drawFlag;
+    m_random = state.random;
+    m_fault = state.fault;
+    m_carriedCycles = state.carriedCycles;
+
+    if (m_program)
+        CheckProgram();
+}
+
+void Chip8::SetProgram(const AotProgram *program) {
+    m_program = program;
+    m_modifiedCode = 0;
+    if (!program)
+        return;
+
+    std::vector<uint8_t> rom(program->size);
+    Peek(0x200, rom.data(), rom.size());
+    if (program->size > MAX_GAME_SIZE || memcmp(rom.data(), program->image, program->size) != 0) {
+        m_program = nullptr;
+        throw std::invalid_argument(std::string("The loaded game is not the one ") + program->name + " was translated from!");
+    }
+}
+
+void Chip8::MarkModified(uint16_t address, uint8_t value) {
+    if (m_program->isCode(address) && ReadMemory(address) != value)
+        m_modifiedCode |= 1 << (address >> 8);
+}
+
+void Chip8::CheckProgram() {
+    // Only the bytes of the ROM are translated
+    m_modifiedCode = 0;
+    for (size_t i = 0; i < m_program->size; ++i) {
+        const uint16_t address = static_cast<uint16_t>(0x200 + i);
+        if (m_program->isCode(address) && ReadMemory(address) != m_program->image[i])
+            m_modifiedCode |= 1 << (address >> 8);
+    }
+}
+
+void Chip8::Run(int instructions) {
+    // Breakpoints and watchpoints cannot change while running
+    const bool translated = m_program && !m_watchpoints && !(m_decodeCache && m_decodeCache->breakpoints.any());
+
+    while (instructions > 0 && m_fault == Fault::None) {
+        // The translated code returns where it cannot go on, the backend runs until it can again
+        if (translated && m_program->isCode(pc) && !(m_modifiedCode & (1 << ((pc >> 8) & 0xF)))) {
+            const int executed = m_program->run(*this, instructions);
+            instructions -= executed;
+            if (executed > 0)
+                continue;
+        }
+
+        Step();
+        --instructions;
     }
 }
 
-void Chip8::EmulateCycle(Context& context) {
+void Chip8::EmulateCycle() {
+    // A faulted core is halted
+    if (m_fault != Fault::None)
+        return;
+
     // Fetch opcode
 
     /**
@@ -91,7 +337,7 @@ void Chip8::EmulateCycle(Context& context) {
      * To store the current opcode, we need a data type that allows us to store two bytes.
      * An uint16_t has the length of two bytes and therefor fits our needs.
      */
-    uint16_t opcode = memory[pc] << 8 | memory[pc + 1];
+    uint16_t opcode = FetchOpcode();
 
     // Decode opcode
     uint16_t x   = (opcode & 0x0F00) >> 8;
@@ -105,18 +351,23 @@ void Chip8::EmulateCycle(Context& context) {
             switch (opcode) {
                 case 0x00E0: // 0x00E0: Clears the screen
                     LOG(LOG_INFO, "Clears the screen");
-                    renderer.Clear();
+                    memset(WritableScreen().pixels, 0, sizeof(Framebuffer::pixels));
                     drawFlag = true;
                     break;
 
                 case 0x00EE: // 00EE: Returns from subroutine
                     LOG(LOG_INFO, "Returns from subroutine");
+                    if (sp == 0) {
+                        m_fault = Fault::StackUnderflow;
+                        return;
+                    }
                     pc = stack[--sp];
                     break;
 
                 default: // 0NNN: Calls machine code routine (RCA 1802 for COSMAC VIP) at address NNN. Not necessary for most ROMs.
                     LOG(LOG_ERROR, "Unknown opcode [0x0000]: " << FORMAT_HEX(opcode));
-                    exit(2);
+                    m_fault = Fault::UnknownOpcode;
+                    return;
             }
             break;
 
@@ -127,6 +378,10 @@ void Chip8::EmulateCycle(Context& context) {
 
         case 0x2000: // 2NNN: Calls subroutine at NNN.
             LOG(LOG_INFO, "Call address " << FORMAT_HEX(nnn));
+            if (sp == 16) {
+                m_fault = Fault::StackOverflow;
+                return;
+            }
             stack[sp++] = pc + 2;
             pc = nnn;
             break;
@@ -221,7 +476,8 @@ void Chip8::EmulateCycle(Context& context) {
 
                 default:
                     LOG(LOG_ERROR, "Unknown opcode [0x8000]: " << FORMAT_HEX(opcode));
-                    exit(2);
+                    m_fault = Fault::UnknownOpcode;
+                    return;
                 }
             break;
 
@@ -234,7 +490,8 @@ void Chip8::EmulateCycle(Context& context) {
 
                 default:
                     LOG(LOG_ERROR, "Unknown opcode [0x9000]: " << FORMAT_HEX(opcode));
-                    exit(2);
+                    m_fault = Fault::UnknownOpcode;
+                    return;
                 }
             break;
 
@@ -246,13 +503,12 @@ void Chip8::EmulateCycle(Context& context) {
 
         case 0xB000: // BNNN: Jumps to the address NNN plus V0.
             LOG(LOG_INFO, "Jump to " << FORMAT_HEX(nnn) << " + V[0] (" << FORMAT_HEX((unsigned int)V[0]) << ")");
-            pc = V[0] + (nnn);
+            pc = (V[0] + nnn) & 0xFFF;
             break;
 
         case 0xC000: // CXNN: Sets VX to the result of a bitwise and operation on a random number (Typically: 0 to 255) and NN.
             LOG(LOG_INFO, "V[" << FORMAT_HEX(x) << "] = random byte");
-            srand((unsigned int)time(NULL));
-            V[x] = (rand() % 256) & nn;
+            V[x] = NextRandom() & nn;
             pc += 2;
             break;
 
@@ -262,21 +518,9 @@ void Chip8::EmulateCycle(Context& context) {
                      // As described above, VF is set to 1 if any screen pixels are flipped from set to unset when the sprite is drawn,
                      // and to 0 if that does not happen.
             LOG(LOG_INFO, "Draw sprite at (V[" << FORMAT_HEX(x) << "], V[" << FORMAT_HEX(y) << "]) = (" << FORMAT_HEX((unsigned int)V[x]) << ", " << FORMAT_HEX((unsigned int)V[y]) << ") of height " << n);
-            uint16_t pixel;
-
-            V[0xF] = 0;
-            for (int yline = 0; yline < n; yline++) {
-                pixel = memory[I + yline];
-                for (int xline = 0; xline < 8; xline++) {
-                    if ((pixel & (0x80 >> xline)) != 0) {
-                        if (renderer[(V[x] + xline + ((V[y] + yline) * GFX_COLS))] == 1)
-                            V[0xF] = 1;
-                        renderer[V[x] + xline + ((V[y] + yline) * GFX_COLS)] ^= 1;
-                    }
-                }
-            }
-
-            drawFlag = true;
+            if (m_watchpoints)
+                CheckWatchpoints(I, n, false);
+            DrawSprite(V[x], V[y], n);
             pc += 2;
             break;
 
@@ -286,17 +530,18 @@ void Chip8::EmulateCycle(Context& context) {
 
                 case 0x9E: // EX9E: Skips the next instruction if the key stored in VX is pressed.
                     LOG(LOG_INFO, "Skip next instruction if key[" << x << "] is pressed");
-                    pc += context.key(V[x]) ? 4 : 2;
+                    pc += ((m_keys >> (V[x] & 0xF)) & 1) ? 4 : 2;
                     break;
 
                 case 0xA1: // EXA1: Skips the next instruction if the key stored in VX is not pressed.
                     LOG(LOG_INFO, "Skip next instruction if key[" << x << "] is NOT pressed");
-                    pc += (!context.key(V[x])) ? 4 : 2;
+                    pc += ((m_keys >> (V[x] & 0xF)) & 1) ? 2 : 4;
                     break;
 
                 default:
                     LOG(LOG_ERROR, "Unknown opcode [0xE000]: " << FORMAT_HEX(opcode));
-                    exit(2);
+                    m_fault = Fault::UnknownOpcode;
+                    return;
             }
             break;
 
@@ -312,12 +557,12 @@ void Chip8::EmulateCycle(Context& context) {
 
                 case 0x0A: // FX0A: A key press is awaited, and then stored in VX.
                     LOG(LOG_INFO, "Wait for key instruction");
-                    for (int i = 0; i < 16; i++) {
-                        if (context.key(i)) {
-                            V[x] = i;
-                            pc += 2;
-                            break;
-                        }
+                    if (m_keys) {
+                        int i = 0;
+                        while (!((m_keys >> i) & 1))
+                            ++i;
+                        V[x] = i;
+                        pc += 2;
                     }
                     break;
 
@@ -350,17 +595,21 @@ void Chip8::EmulateCycle(Context& context) {
                             // most significant of three digits at the address in I, the middle digit 
                             // at I plus 1, and the least significant digit at I plus 2.
                     LOG(LOG_INFO, "Store BCD for " << (unsigned int)V[x] << " starting at address " << FORMAT_HEX(I));
-                    memory[I] = (V[x] % 1000) / 100;   // hundred's digit
-                    memory[I + 1] = (V[x] % 100) / 10; // ten's digit
-                    memory[I + 2] = (V[x] % 10);       // one's digit
+                    if (m_watchpoints)
+                        CheckWatchpoints(I, 3, true);
+                    WriteMemory(I, (V[x] % 1000) / 100);   // hundred's digit
+                    WriteMemory(I + 1, (V[x] % 100) / 10); // ten's digit
+                    WriteMemory(I + 2, (V[x] % 10));       // one's digit
                     pc += 2;
                     break;
 
                 case 0x55: // FX55: Stores V0 to VX (including VX) in memory starting at address I.
                             // The offset from I is increased by 1 for each value written, but I itself is left unmodified
                     LOG(LOG_INFO, "Copy sprite from registers 0 to " << FORMAT_HEX(x) << " into memory at address " << std::hex <<I);
+                    if (m_watchpoints)
+                        CheckWatchpoints(I, x + 1, true);
                     for (int i = 0; i <= (x); i++)
-                        memory[I + i] = V[i];
+                        WriteMemory(I + i, V[i]);
                     I += x + 1;
                     pc += 2;
                     break;
@@ -368,34 +617,72 @@ void Chip8::EmulateCycle(Context& context) {
                 case 0x65: // FX65: Fills V0 to VX (including VX) with values from memory starting at address I.
                             // The offset from I is increased by 1 for each value written, but I itself is left unmodified.
                     LOG(LOG_INFO, "Copy sprite from memory at address " << FORMAT_HEX(x) << " into registers 0 to " << FORMAT_HEX(I));
+                    if (m_watchpoints)
+                        CheckWatchpoints(I, x + 1, false);
                     for (int i = 0; i <= x; i++)
-                        V[i] = memory[I + i];
+                        V[i] = ReadMemory(I + i);
                     I += x + 1;
                     pc += 2;
                     break;
 
                 default:
                     LOG(LOG_ERROR, "Unknown opcode [0xF000]: " << FORMAT_HEX(opcode));
-                    exit(2);
+                    m_fault = Fault::UnknownOpcode;
+                    return;
                 }
             break;
 
         default:
             LOG(LOG_ERROR, "Unknown opcode: " << FORMAT_HEX(opcode));
-            exit(2);
+            m_fault = Fault::UnknownOpcode;
+            return;
     }
 }
 
-void Chip8::Tick(Context& context) {
-    // Update timers
+void Chip8::Tick() {
+    // The delay timer and the sound timer. 
+    // They both work the same way; they should be decremented by one 60 times per second (ie. at 60 Hz). 
+    // This is independent of the speed of the fetch/decode/execute loop.
     if (delayTimer > 0)
         --delayTimer;
 
     if (soundTimer > 0) {
         --soundTimer;
-        if (soundTimer == 0)
-            context.playBeep();
-        else
-            context.stopAudio();
+        if (m_soundFunc && m_audioEnabled)
+            m_soundFunc(soundTimer == 0);
+    }
+}
+
+void Chip8::DrawSprite(uint8_t vx, uint8_t vy, uint8_t height) {
+    Framebuffer &screen = WritableScreen();
+
+    // Sprites wrap around to the opposite side of the screen
+    V[0xF] = 0;
+    for (int yline = 0; yline < height; yline++) {
+        const uint8_t pixel = ReadMemory(I + yline);
+        const int row = ((vy + yline) % GFX_ROWS) * GFX_COLS;
+
+        for (int xline = 0; xline < 8; xline++) {
+            if ((pixel & (0x80 >> xline)) != 0) {
+                uint8_t &dst = screen[row + (vx + xline) % GFX_COLS];
+                if (dst == 1)
+                    V[0xF] = 1;
+                dst ^= 1;
+            }
+        }
+    }
+
+    drawFlag = true;
+}
+
+const char *Chip8::FaultName(Fault fault) {
+    switch (fault) {
+        case Fault::None:           return "none";
+        case Fault::UnknownOpcode:  return "unknown opcode";
+        case Fault::StackOverflow:  return "stack overflow";
+        case Fault::StackUnderflow: return "stack underflow";
+        case Fault::Breakpoint:     return "breakpoint";
+        case Fault::Watchpoint:     return "watchpoint";
+        default:                    return "?";
     }
 }
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "Chip8.hpp"
+
+#include "Log.hpp"
+#include "Const.hpp"
+
+#include <cstring>
+
+/**
+ * Cached backend.
+ * Same semantics as the switch in Chip8::EmulateCycle, but each instruction is decoded once
+ * and then dispatched on a dense operation code.
+ */
+void Chip8::EmulateCycleCached() {
+    // A faulted core is halted
+    if (m_fault != Fault::None)
+        return;
+
+    const Instruction *entry = &m_decodeCache->entries[pc & 0xFFF];
+    Instruction decoded;
+    if (entry->op == Op::NONE) {
+        decoded = Decode(FetchOpcode());
+        entry = &decoded;
+
+        // A cache shared with forks is read-only
+        if (m_decodeCache.use_count() == 1)
+            m_decodeCache->entries[pc & 0xFFF] = decoded;
+    }
+
+    const Instruction &in = *entry;
+
+    const uint8_t x = in.x;
+    const uint8_t y = in.y;
+
+    switch (in.op) {
+        case Op::CLS:
+            memset(WritableScreen().pixels, 0, sizeof(Framebuffer::pixels));
+            drawFlag = true;
+            break;
+
+        case Op::RET:
+            if (sp == 0) {
+                m_fault = Fault::StackUnderflow;
+                return;
+            }
+            pc = stack[--sp];
+            break;
+
+        case Op::JP:
+            pc = in.nnn;
+            break;
+
+        case Op::CALL:
+            if (sp == 16) {
+                m_fault = Fault::StackOverflow;
+                return;
+            }
+            stack[sp++] = pc + 2;
+            pc = in.nnn;
+            break;
+
+        case Op::SE_NN:
+            pc += (V[x] == in.nn) ? 4 : 2;
+            break;
+
+        case Op::SNE_NN:
+            pc += (V[x] != in.nn) ? 4 : 2;
+            break;
+
+        case Op::SE_VY:
+            pc += (V[x] == V[y]) ? 4 : 2;
+            break;
+
+        case Op::LD_NN:
+            V[x] = in.nn;
+            pc += 2;
+            break;
+
+        case Op::ADD_NN:
+            V[x] += in.nn;
+            pc += 2;
+            break;
+
+        case Op::LD_VY:
+            V[x] = V[y];
+            pc += 2;
+            break;
+
+        case Op::OR:
+            V[x] |= V[y];
+            pc += 2;
+            break;
+
+        case Op::AND:
+            V[x] &= V[y];
+            pc += 2;
+            break;
+
+        case Op::XOR:
+            V[x] ^= V[y];
+            pc += 2;
+            break;
+
+        case Op::ADD_VY:
+            V[0xF] = ((int)V[x] + (int)V[y]) > 0xFF ? 1 : 0;
+            V[x] += V[y];
+            pc += 2;
+            break;
+
+        case Op::SUB:
+            V[0xF] = (V[x] > V[y]) ? 1 : 0;
+            V[x] -= V[y];
+            pc += 2;
+            break;
+
+        case Op::SHR:
+            V[0xF] = V[x] & 0x1;
+            V[x] = (V[x] >> 1);
+            pc += 2;
+            break;
+
+        case Op::SUBN:
+            V[0xF] = (V[y] > V[x]) ? 1 : 0;
+            V[x] = V[y] - V[x];
+            pc += 2;
+            break;
+
+        case Op::SHL:
+            V[0xF] = (V[x] >> 7) & 0x1;
+            V[x] = (V[x] << 1);
+            pc += 2;
+            break;
+
+        case Op::SNE_VY:
+            pc += (V[x] != V[y]) ? 4 : 2;
+            break;
+
+        case Op::LD_I:
+            I = in.nnn;
+            pc += 2;
+            break;
+
+        case Op::JP_V0:
+            pc = (V[0] + in.nnn) & 0xFFF;
+            break;
+
+        case Op::RND:
+            V[x] = NextRandom() & in.nn;
+            pc += 2;
+            break;
+
+        case Op::DRW:
+            if (m_watchpoints)
+                CheckWatchpoints(I, in.n, false);
+            DrawSprite(V[x], V[y], in.n);
+            pc += 2;
+            break;
+
+        case Op::SKP:
+            pc += ((m_keys >> (V[x] & 0xF)) & 1) ? 4 : 2;
+            break;
+
+        case Op::SKNP:
+            pc += ((m_keys >> (V[x] & 0xF)) & 1) ? 2 : 4;
+            break;
+
+        case Op::LD_VX_DT:
+            V[x] = delayTimer;
+            pc += 2;
+            break;
+
+        case Op::LD_VX_K:
+            if (m_keys) {
+                int i = 0;
+                while (!((m_keys >> i) & 1))
+                    ++i;
+                V[x] = i;
+                pc += 2;
+            }
+            break;
+
+        case Op::LD_DT_VX:
+            delayTimer = V[x];
+            pc += 2;
+            break;
+
+        case Op::LD_ST_VX:
+            soundTimer = V[x];
+            pc += 2;
+            break;
+
+        case Op::ADD_I_VX:
+            I += V[x];
+            pc += 2;
+            break;
+
+        case Op::LD_F_VX:
+            I = FONTSET_BYTES_PER_CHAR * V[x];
+            pc += 2;
+            break;
+
+        case Op::LD_B_VX:
+            if (m_watchpoints)
+                CheckWatchpoints(I, 3, true);
+            WriteMemory(I, (V[x] % 1000) / 100);
+            WriteMemory(I + 1, (V[x] % 100) / 10);
+            WriteMemory(I + 2, (V[x] % 10));
+            pc += 2;
+            break;
+
+        case Op::LD_I_VX:
+            if (m_watchpoints)
+                CheckWatchpoints(I, x + 1, true);
+            for (int i = 0; i <= x; i++)
+                WriteMemory(I + i, V[i]);
+            I += x + 1;
+            pc += 2;
+            break;
+
+        case Op::LD_VX_I:
+            if (m_watchpoints)
+                CheckWatchpoints(I, x + 1, false);
+            for (int i = 0; i <= x; i++)
+                V[i] = ReadMemory(I + i);
+            I += x + 1;
+            pc += 2;
+            break;
+
+        case Op::BREAK:
+            // The debugger removes the breakpoint to step over it
+            m_fault = Fault::Breakpoint;
+            return;
+
+        default: // SYS and unknown opcodes
+            LOG(LOG_ERROR, "Unknown opcode: " << FORMAT_HEX(in.opcode));
+            m_fault = Fault::UnknownOpcode;
+            return;
+    }
+}
@@ -0,0 +1,170 @@
+#include "Decode.hpp"
+
+#include <cstdio>
+
+static Op decodeOp(uint16_t opcode) {
+    const uint16_t n = opcode & 0x000F;
+    const uint16_t nn = opcode & 0x00FF;
+
+    switch (opcode & 0xF000) {
+        case 0x0000:
+            switch (opcode) {
+                case 0x00E0: return Op::CLS;
+                case 0x00EE: return Op::RET;
+                default:     return Op::SYS;
+            }
+
+        case 0x1000: return Op::JP;
+        case 0x2000: return Op::CALL;
+        case 0x3000: return Op::SE_NN;
+        case 0x4000: return Op::SNE_NN;
+        case 0x5000: return Op::SE_VY;
+        case 0x6000: return Op::LD_NN;
+        case 0x7000: return Op::ADD_NN;
+
+        case 0x8000:
+            switch (n) {
+                case 0x0: return Op::LD_VY;
+                case 0x1: return Op::OR;
+                case 0x2: return Op::AND;
+                case 0x3: return Op::XOR;
+                case 0x4: return Op::ADD_VY;
+                case 0x5: return Op::SUB;
+                case 0x6: return Op::SHR;
+                case 0x7: return Op::SUBN;
+                case 0xE: return Op::SHL;
+                default:  return Op::INVALID;
+            }
+
+        case 0x9000: return n == 0x0 ? Op::SNE_VY : Op::INVALID;
+        case 0xA000: return Op::LD_I;
+        case 0xB000: return Op::JP_V0;
+        case 0xC000: return Op::RND;
+        case 0xD000: return Op::DRW;
+
+        case 0xE000:
+            switch (nn) {
+                case 0x9E: return Op::SKP;
+                case 0xA1: return Op::SKNP;
+                default:   return Op::INVALID;
+            }
+
+        case 0xF000:
+            switch (nn) {
+                case 0x07: return Op::LD_VX_DT;
+                case 0x0A: return Op::LD_VX_K;
+                case 0x15: return Op::LD_DT_VX;
+                case 0x18: return Op::LD_ST_VX;
+                case 0x1E: return Op::ADD_I_VX;
+                case 0x29: return Op::LD_F_VX;
+                case 0x33: return Op::LD_B_VX;
+                case 0x55: return Op::LD_I_VX;
+                case 0x65: return Op::LD_VX_I;
+                default:   return Op::INVALID;
+            }
+
+        default:
+            return Op::INVALID;
+    }
+}
+
+Instruction Decode(uint16_t opcode) {
+    Instruction instruction;
+    instruction.op     = decodeOp(opcode);
+    instruction.x      = (opcode & 0x0F00) >> 8;
+    instruction.y      = (opcode & 0x00F0) >> 4;
+    instruction.n      = opcode & 0x000F;
+    instruction.nn     = opcode & 0x00FF;
+    instruction.nnn    = opcode & 0x0FFF;
+    instruction.opcode = opcode;
+    return instruction;
+}
+
+int VipCycles(uint16_t opcode) {
+    const Instruction instruction = Decode(opcode);
+
+    switch (instruction.op) {
+        case Op::CLS:      return 24;
+        case Op::RET:      return 23;
+        case Op::SYS:      return 23;
+        case Op::JP:       return 23;
+        case Op::CALL:     return 23;
+        case Op::SE_NN:    return 12;
+        case Op::SNE_NN:   return 12;
+        case Op::SE_VY:    return 16;
+        case Op::LD_NN:    return 6;
+        case Op::ADD_NN:   return 10;
+        case Op::LD_VY:
+        case Op::OR:
+        case Op::AND:
+        case Op::XOR:
+        case Op::ADD_VY:
+        case Op::SUB:
+        case Op::SHR:
+        case Op::SUBN:
+        case Op::SHL:      return 44;
+        case Op::SNE_VY:   return 16;
+        case Op::LD_I:     return 12;
+        case Op::JP_V0:    return 23;
+        case Op::RND:      return 36;
+        case Op::DRW:      return 68 + 20 * instruction.n; // Each row shifted into place and XORed into two bytes
+        case Op::SKP:      return 16;
+        case Op::SKNP:     return 16;
+        case Op::LD_VX_DT: return 10;
+        case Op::LD_VX_K:  return 10; // Per poll of the keypad
+        case Op::LD_DT_VX: return 10;
+        case Op::LD_ST_VX: return 10;
+        case Op::ADD_I_VX: return 19;
+        case Op::LD_F_VX:  return 20;
+        case Op::LD_B_VX:  return 204; // Repeated subtractions, a few per digit
+        case Op::LD_I_VX:  return 20 + 14 * (instruction.x + 1);
+        case Op::LD_VX_I:  return 20 + 14 * (instruction.x + 1);
+        default:           return 1;
+    }
+}
+
+std::string Disassemble(uint16_t opcode) {
+    const Instruction in = Decode(opcode);
+    char text[32];
+
+    switch (in.op) {
+        case Op::CLS:      snprintf(text, sizeof(text), "CLS"); break;
+        case Op::RET:      snprintf(text, sizeof(text), "RET"); break;
+        case Op::SYS:      snprintf(text, sizeof(text), "SYS 0x%03X", in.nnn); break;
+        case Op::JP:       snprintf(text, sizeof(text), "JP 0x%03X", in.nnn); break;
+        case Op::CALL:     snprintf(text, sizeof(text), "CALL 0x%03X", in.nnn); break;
+        case Op::SE_NN:    snprintf(text, sizeof(text), "SE V%X, 0x%02X", in.x, in.nn); break;
+        case Op::SNE_NN:   snprintf(text, sizeof(text), "SNE V%X, 0x%02X", in.x, in.nn); break;
+        case Op::SE_VY:    snprintf(text, sizeof(text), "SE V%X, V%X", in.x, in.y); break;
+        case Op::LD_NN:    snprintf(text, sizeof(text), "LD V%X, 0x%02X", in.x, in.nn); break;
+        case Op::ADD_NN:   snprintf(text, sizeof(text), "ADD V%X, 0x%02X", in.x, in.nn); break;
+        case Op::LD_VY:    snprintf(text, sizeof(text), "LD V%X, V%X", in.x, in.y); break;
+        case Op::OR:       snprintf(text, sizeof(text), "OR V%X, V%X", in.x, in.y); break;
+        case Op::AND:      snprintf(text, sizeof(text), "AND V%X, V%X", in.x, in.y); break;
+        case Op::XOR:      snprintf(text, sizeof(text), "XOR V%X, V%X", in.x, in.y); break;
+        case Op::ADD_VY:   snprintf(text, sizeof(text), "ADD V%X, V%X", in.x, in.y); break;
+        case Op::SUB:      snprintf(text, sizeof(text), "SUB V%X, V%X", in.x, in.y); break;
+        case Op::SHR:      snprintf(text, sizeof(text), "SHR V%X", in.x); break;
+        case Op::SUBN:     snprintf(text, sizeof(text), "SUBN V%X, V%X", in.x, in.y); break;
+        case Op::SHL:      snprintf(text, sizeof(text), "SHL V%X", in.x); break;
+        case Op::SNE_VY:   snprintf(text, sizeof(text), "SNE V%X, V%X", in.x, in.y); break;
+        case Op::LD_I:     snprintf(text, sizeof(text), "LD I, 0x%03X", in.nnn); break;
+        case Op::JP_V0:    snprintf(text, sizeof(text), "JP V0, 0x%03X", in.nnn); break;
+        case Op::RND:      snprintf(text, sizeof(text), "RND V%X, 0x%02X", in.x, in.nn); break;
+        case Op::DRW:      snprintf(text, sizeof(text), "DRW V%X, V%X, %d", in.x, in.y, in.n); break;
+        case Op::SKP:      snprintf(text, sizeof(text), "SKP V%X", in.x); break;
+        case Op::SKNP:     snprintf(text, sizeof(text), "SKNP V%X", in.x); break;
+        case Op::LD_VX_DT: snprintf(text, sizeof(text), "LD V%X, DT", in.x); break;
+        case Op::LD_VX_K:  snprintf(text, sizeof(text), "LD V%X, K", in.x); break;
+        case Op::LD_DT_VX: snprintf(text, sizeof(text), "LD DT, V%X", in.x); break;
+        case Op::LD_ST_VX: snprintf(text, sizeof(text), "LD ST, V%X", in.x); break;
+        case Op::ADD_I_VX: snprintf(text, sizeof(text), "ADD I, V%X", in.x); break;
+        case Op::LD_F_VX:  snprintf(text, sizeof(text), "LD F, V%X", in.x); break;
+        case Op::LD_B_VX:  snprintf(text, sizeof(text), "LD B, V%X", in.x); break;
+        case Op::LD_I_VX:  snprintf(text, sizeof(text), "LD [I], V%X", in.x); break;
+        case Op::LD_VX_I:  snprintf(text, sizeof(text), "LD V%X, [I]", in.x); break;
+        default:           snprintf(text, sizeof(text), "DW 0x%04X", opcode); break;
+    }
+
+    return text;
+}
@@ -0,0 +1,191 @@
+#include "DecodeStore.hpp"
+
+#include "Hash.hpp"
+#include "Log.hpp"
+#include "Version.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <random>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static const size_t FILE_SIZE = sizeof(DecodeStore::Header) + 4096 * DecodeStore::ENTRY_SIZE;
+
+constexpr char DecodeStore::MAGIC[8];
+
+static void putEntry(uint8_t *p, const Instruction &entry) {
+    p[0] = static_cast<uint8_t>(entry.op);
+    p[1] = entry.x;
+    p[2] = entry.y;
+    p[3] = entry.n;
+    p[4] = entry.nn;
+    p[5] = static_cast<uint8_t>(entry.nnn);
+    p[6] = static_cast<uint8_t>(entry.nnn >> 8);
+    p[7] = static_cast<uint8_t>(entry.opcode);
+    p[8] = static_cast<uint8_t>(entry.opcode >> 8);
+}
+
+static void getEntry(const uint8_t *p, Instruction &entry) {
+    entry.op = static_cast<Op>(p[0]);
+    entry.x = p[1];
+    entry.y = p[2];
+    entry.n = p[3];
+    entry.nn = p[4];
+    entry.nnn = static_cast<uint16_t>(p[5] | p[6] << 8);
+    entry.opcode = static_cast<uint16_t>(p[7] | p[8] << 8);
+}
+
+DecodeStore::DecodeStore(const std::string &directory) : m_directory(directory) {
+    std::error_code error;
+    fs::create_directories(directory, error);
+
+    if (error) {
+        throw std::runtime_error("Not be able to create the decode cache directory " + directory + "!");
+    }
+}
+
+uint64_t DecodeStore::Hash(const uint8_t *data, size_t size) {
+    return Fnv1a(data, size);
+}
+
+std::string DecodeStore::PathOf(uint64_t hash) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.dcache", static_cast<unsigned long long>(hash));
+    return (fs::path(m_directory) / name).string();
+}
+
+void DecodeStore::FillHeader(Header &header, uint64_t hash, size_t size) {
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.instructionSize = ENTRY_SIZE;
+    snprintf(header.emulatorVersion, sizeof(header.emulatorVersion), "%s+%s", CHIP8_VERSION, CHIP8_VERSION_BUILD);
+    header.romHash = hash;
+    header.romSize = static_cast<uint32_t>(size);
+}
+
+/**
+ * @brief Check a stored file against the expected header and the memory image, then copy its entries into cache
+ */
+static bool restore(const uint8_t *file, size_t fileSize, const DecodeStore::Header &expected, const uint8_t image[4096],
+                    DecodeCache &cache) {
+    if (fileSize != FILE_SIZE || memcmp(file, &expected, sizeof(expected)) != 0)
+        return false;
+
+    const uint8_t *entries = file + sizeof(expected);
+
+    // A damaged or stale file must not put anything in the cache that decoding the image would not,
+    // e.g. a register index out of range: every entry is decoded again and compared
+    std::vector<Instruction> restored(4096);
+    for (size_t i = 0; i < 4096; ++i) {
+        Instruction stored;
+        getEntry(entries + i * DecodeStore::ENTRY_SIZE, stored);
+
+        if (stored.op == Op::NONE) {
+            restored[i] = Instruction();
+            restored[i].op = Op::NONE;
+            continue;
+        }
+
+        const uint16_t opcode = static_cast<uint16_t>(image[i] << 8 | image[(i + 1) & 0xFFF]);
+        const Instruction decoded = Decode(opcode);
+        if (stored.opcode != opcode || stored.op != decoded.op || stored.x != decoded.x || stored.y != decoded.y ||
+            stored.n != decoded.n || stored.nn != decoded.nn || stored.nnn != decoded.nnn)
+            return false;
+
+        restored[i] = decoded;
+    }
+
+    std::copy(restored.begin(), restored.end(), cache.entries);
+    cache.ApplyBreakpoints();
+    return true;
+}
+
+bool DecodeStore::Load(const uint8_t *data, size_t size, const uint8_t image[4096], DecodeCache &cache) {
+    const uint64_t hash = Hash(data, size);
+
+    Header expected;
+    FillHeader(expected, hash, size);
+
+    const std::string path = PathOf(hash);
+    bool loaded = false;
+
+#ifndef _WIN32
+    // Map the file, the entries are copied straight from the page cache
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == FILE_SIZE) {
+            void *file = mmap(nullptr, FILE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (file != MAP_FAILED) {
+                loaded = restore(static_cast<const uint8_t *>(file), FILE_SIZE, expected, image, cache);
+                munmap(file, FILE_SIZE);
+            }
+        }
+        close(fd);
+    }
+#else
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (file) {
+        std::vector<uint8_t> buffer(FILE_SIZE + 1);
+        file.read(reinterpret_cast<char *>(buffer.data()), buffer.size());
+        loaded = restore(buffer.data(), file.gcount(), expected, image, cache);
+    }
+#endif
+
+    (loaded ? m_hits : m_misses).fetch_add(1, std::memory_order_relaxed);
+    return loaded;
+}
+
+void DecodeStore::Save(const uint8_t *data, size_t size, const DecodeCache &cache) {
+    const uint64_t hash = Hash(data, size);
+
+    Header header;
+    FillHeader(header, hash, size);
+
+    // Write aside then rename, so concurrent instances never read a partial file
+    const std::string path = PathOf(hash);
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".tmp.%08x", std::random_device()());
+    const std::string temporary = path + suffix;
+
+    {
+        std::ofstream file(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        // Breakpoints belong to the debugging session, not to the game
+        std::vector<uint8_t> entries(4096 * ENTRY_SIZE);
+        for (size_t i = 0; i < 4096; ++i) {
+            Instruction entry = cache.entries[i];
+            if (entry.op == Op::BREAK)
+                entry.op = Op::NONE;
+            putEntry(entries.data() + i * ENTRY_SIZE, entry);
+        }
+
+        file.write(reinterpret_cast<const char *>(entries.data()), entries.size());
+
+        if (!file) {
+            LOG(LOG_WARNING, "Not be able to write the decode cache " << temporary << "!");
+            return;
+        }
+    }
+
+    std::error_code error;
+    fs::rename(temporary, path, error);
+    if (error) {
+        fs::remove(temporary, error);
+        LOG(LOG_WARNING, "Not be able to write the decode cache " << path << "!");
+    }
+}
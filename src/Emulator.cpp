@@ -0,0 +1,170 @@
+#include "Emulator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using Clock = std::chrono::steady_clock;
+
+Emulator::Emulator(Chip8 &chip8, KeyQueue *keyQueue) : m_chip8(chip8), m_keypad(keyQueue) {}
+
+Emulator::~Emulator() {
+    Stop();
+}
+
+void Emulator::Start() {
+    if (m_running.exchange(true))
+        return;
+
+    m_thread = std::thread(&Emulator::Run, this);
+}
+
+void Emulator::Stop() {
+    m_running = false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void Emulator::RunFrame() {
+    if (m_fault.load(std::memory_order_relaxed) != Fault::None)
+        return;
+
+    if (m_cheats)
+        m_cheats->Apply(m_chip8);
+
+    const Clock::time_point now = Clock::now();
+    const Clock::time_point start = now - m_pacer.frameDuration();
+    const Clock::duration cycleDuration = m_pacer.frameDuration() / std::max(m_cyclesPerFrame, 1);
+
+    int executed = m_cyclesPerFrame;
+    if (m_timing == Chip8::Timing::Vip) {
+        executed = m_chip8.RunCycles(m_cyclesPerFrame, [&](int cycle) {
+            if (m_keypad.Apply(start + cycle * cycleDuration))
+                m_chip8.SetKeys(m_keypad.state());
+        });
+    } else {
+        for (int i = 0; i < m_cyclesPerFrame; ++i) {
+            if (m_keypad.Apply(start + i * cycleDuration))
+                m_chip8.SetKeys(m_keypad.state());
+
+            m_chip8.Step();
+        }
+    }
+
+    // A core halted on a breakpoint skips the rest of the frame, the debugger takes over here
+    if (m_debugger)
+        m_debugger->Poll();
+
+    m_chip8.Tick();
+    m_frameCount.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_metrics) {
+        m_metrics->instructions.Add(executed);
+        m_metrics->frames.Add();
+        m_metrics->frameTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - now).count());
+    }
+
+    m_fault.store(m_chip8.fault(), std::memory_order_relaxed);
+
+    // The real state, before any run-ahead
+    if (m_stateExporter)
+        m_stateExporter->Publish(m_stateSlot, m_chip8, frameCount());
+    if (m_chip8.fault() != Fault::None && m_wakeFunc)
+        m_wakeFunc();
+
+    if (m_keypad.EndFrame())
+        m_chip8.SetKeys(m_keypad.state());
+
+    // Dumps and recordings follow the real state, only the presented frame runs ahead
+    Record();
+
+    if (m_runAheadFrames > 0) {
+        RunAhead();
+        return;
+    }
+
+    Publish();
+}
+
+void Emulator::Record() {
+    const Framebuffer &screen = m_chip8.screen();
+
+    // Dumps are counted in emulated frames, skipped on screen or not
+    if (m_dumper)
+        m_dumper->OnFrame(screen, frameCount());
+
+    // The recorder keeps every frame that changed, even those skipped on screen
+    if (m_recorder && (!m_recordedAny || memcmp(screen.pixels, m_recorded.pixels, sizeof(screen.pixels)) != 0)) {
+        m_recorder->Push(screen, frameCount());
+        m_recorded = screen;
+        m_recordedAny = true;
+    }
+}
+
+bool Emulator::Publish() {
+    // A skipped frame keeps the draw flag set, so the next presented one is published
+    if (!m_pacer.Present())
+        return false;
+
+    // Hand the frame to the render thread
+    if (m_chip8.Display(m_frames.Back())) {
+        m_frames.Publish();
+
+        if (m_wakeFunc)
+            m_wakeFunc();
+    }
+
+    return true;
+}
+
+void Emulator::StepFrame() {
+    if (m_cheats)
+        m_cheats->Apply(m_chip8);
+
+    if (m_timing == Chip8::Timing::Vip)
+        m_chip8.RunCycles(m_cyclesPerFrame);
+    else
+        m_chip8.Run(m_cyclesPerFrame);
+    m_chip8.Tick();
+}
+
+void Emulator::RunAhead() {
+    const Clock::time_point start = Clock::now();
+
+    m_chip8.SaveState(m_runAheadState);
+
+    // The speculative frames must not be heard
+    m_chip8.SetAudioEnabled(false);
+    for (int i = 0; i < m_runAheadFrames; ++i)
+        StepFrame();
+    m_chip8.SetAudioEnabled(true);
+
+    // The draw flag of the real frame is consumed with the published screen, restoring it would
+    // publish the same screen again on the next frame
+    if (Publish())
+        m_runAheadState.drawFlag = false;
+
+    m_chip8.LoadState(m_runAheadState);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+    m_runAheadTime.fetch_add(elapsed.count(), std::memory_order_relaxed);
+    m_runAheadCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+double Emulator::runAheadCost() const {
+    const uint64_t count = m_runAheadCount.load(std::memory_order_relaxed);
+    if (count == 0)
+        return 0;
+
+    return static_cast<double>(m_runAheadTime.load(std::memory_order_relaxed)) / count;
+}
+
+void Emulator::Run() {
+    m_pacer.Start();
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        RunFrame();
+        m_pacer.Wait();
+    }
+}
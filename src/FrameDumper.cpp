@@ -0,0 +1,112 @@
+#include "FrameDumper.hpp"
+
+#include <cstdio>
+#include <exception>
+#include <stdexcept>
+
+FrameDumper::FrameDumper(const SoftwareRenderer &renderer, const std::string &directory, Format format, uint64_t every)
+    : m_renderer(renderer), m_directory(directory), m_format(format), m_every(every) {
+    m_thread = std::thread(&FrameDumper::Run, this);
+}
+
+FrameDumper::~FrameDumper() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_wakeUp.notify_one();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+FrameDumper::Format FrameDumper::ParseFormat(const std::string &name) {
+    if (name == "ppm")
+        return Format::PPM;
+    if (name == "png")
+        return Format::PNG;
+
+    throw std::invalid_argument("Unknown image format: " + name + " (expected ppm or png).");
+}
+
+std::string FrameDumper::Path(uint64_t number) const {
+    char name[32];
+    snprintf(name, sizeof(name), "frame_%06llu.%s", static_cast<unsigned long long>(number),
+             m_format == Format::PNG ? "png" : "ppm");
+
+    return m_directory + "/" + name;
+}
+
+void FrameDumper::OnFrame(const Framebuffer &frame, uint64_t number) {
+    if (m_every != 0 && number % m_every == 0)
+        Push(frame, number);
+}
+
+std::string FrameDumper::Push(const Framebuffer &frame, uint64_t number) {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_written.wait(lock, [this]() { return m_queue.size() < MAX_QUEUED; });
+        m_queue.push_back({number, frame});
+    }
+    m_wakeUp.notify_one();
+
+    return Path(number);
+}
+
+void FrameDumper::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_written.wait(lock, [this]() { return m_queue.empty() && !m_writing; });
+
+    // Reported once, the next writes may succeed
+    if (!m_error.empty()) {
+        const std::string error = m_error;
+        m_error.clear();
+        throw std::runtime_error(error);
+    }
+}
+
+std::string FrameDumper::Dump(const Framebuffer &frame, uint64_t number) {
+    const std::string path = Push(frame, number);
+    Flush();
+    return path;
+}
+
+void FrameDumper::Run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    // Frames pushed before the dumper was destroyed are still written
+    for (;;) {
+        m_wakeUp.wait(lock, [this]() { return !m_queue.empty() || !m_running; });
+        if (m_queue.empty())
+            break;
+
+        const Item item = m_queue.front();
+        m_queue.pop_front();
+        m_writing = true;
+
+        lock.unlock();
+        std::string error;
+        try {
+            Write(item);
+        } catch (const std::exception &e) {
+            error = e.what();
+        }
+        lock.lock();
+
+        if (m_error.empty())
+            m_error = error;
+        m_writing = false;
+        m_written.notify_all();
+    }
+}
+
+void FrameDumper::Write(const Item &item) {
+    const std::string path = Path(item.number);
+
+    m_renderer.Render(item.frame);
+
+    if (m_format == Format::PNG)
+        m_renderer.WritePNG(path);
+    else
+        m_renderer.WritePPM(path);
+}
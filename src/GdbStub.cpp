@@ -0,0 +1,699 @@
+#include "GdbStub.hpp"
+
+#include "Log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#define poll WSAPoll
+
+static void closeSocket(GdbStub::Socket socket) { closesocket(socket); }
+
+static const int SEND_FLAGS = 0;
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void closeSocket(GdbStub::Socket socket) { close(socket); }
+
+// A debugger dropping the connection must not kill the emulator with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+#endif
+
+static const GdbStub::Socket NO_SOCKET = static_cast<GdbStub::Socket>(-1);
+
+// Signals of the stop replies
+static const int SIGNAL_INT = 2;
+static const int SIGNAL_ILL = 4;
+static const int SIGNAL_TRAP = 5;
+static const int SIGNAL_SEGV = 11;
+
+/*
+ * Registers, in the order of the 'g' packet and of the target description: V0 to VF, I, pc, sp,
+ * dt and st, multi-byte registers in little endian.
+ */
+static const int REGISTER_COUNT = 21;
+static const int REGISTER_SIZES[REGISTER_COUNT] = {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1};
+
+static const char TARGET_XML[] =
+    "<?xml version=\"1.0\"?>\n"
+    "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+    "<target version=\"1.0\">\n"
+    "  <feature name=\"org.chip8.core\">\n"
+    "    <reg name=\"v0\" bitsize=\"8\" regnum=\"0\"/>\n"
+    "    <reg name=\"v1\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v2\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v3\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v4\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v5\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v6\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v7\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v8\" bitsize=\"8\"/>\n"
+    "    <reg name=\"v9\" bitsize=\"8\"/>\n"
+    "    <reg name=\"va\" bitsize=\"8\"/>\n"
+    "    <reg name=\"vb\" bitsize=\"8\"/>\n"
+    "    <reg name=\"vc\" bitsize=\"8\"/>\n"
+    "    <reg name=\"vd\" bitsize=\"8\"/>\n"
+    "    <reg name=\"ve\" bitsize=\"8\"/>\n"
+    "    <reg name=\"vf\" bitsize=\"8\"/>\n"
+    "    <reg name=\"i\" bitsize=\"16\" type=\"data_ptr\"/>\n"
+    "    <reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>\n"
+    "    <reg name=\"sp\" bitsize=\"16\"/>\n"
+    "    <reg name=\"dt\" bitsize=\"8\"/>\n"
+    "    <reg name=\"st\" bitsize=\"8\"/>\n"
+    "  </feature>\n"
+    "</target>\n";
+
+static std::string toHex(const uint8_t *bytes, size_t size) {
+    static const char DIGITS[] = "0123456789abcdef";
+
+    std::string hex;
+    hex.reserve(size * 2);
+    for (size_t i = 0; i < size; ++i) {
+        hex += DIGITS[bytes[i] >> 4];
+        hex += DIGITS[bytes[i] & 0xF];
+    }
+    return hex;
+}
+
+static int fromHexDigit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief Decode pairs of hex digits, false if hex holds anything else
+ */
+static bool fromHex(const std::string &hex, std::vector<uint8_t> &bytes) {
+    if (hex.size() % 2)
+        return false;
+
+    bytes.resize(hex.size() / 2);
+    for (size_t i = 0; i < bytes.size(); ++i) {
+        const int high = fromHexDigit(hex[2 * i]), low = fromHexDigit(hex[2 * i + 1]);
+        if (high < 0 || low < 0)
+            return false;
+        bytes[i] = static_cast<uint8_t>(high << 4 | low);
+    }
+    return true;
+}
+
+static std::string signalReply(int signal) {
+    char reply[8];
+    snprintf(reply, sizeof(reply), "T%02x", signal);
+    return reply;
+}
+
+/**
+ * @brief Registers of state laid out as in the 'g' packet
+ */
+static std::vector<uint8_t> packRegisters(const Chip8State &state) {
+    std::vector<uint8_t> bytes(state.V, state.V + 16);
+    for (uint16_t value : {state.I, state.pc, state.sp}) {
+        bytes.push_back(value & 0xFF);
+        bytes.push_back(value >> 8);
+    }
+    bytes.push_back(state.delayTimer);
+    bytes.push_back(state.soundTimer);
+    return bytes;
+}
+
+static void unpackRegisters(const std::vector<uint8_t> &bytes, Chip8State &state) {
+    memcpy(state.V, bytes.data(), 16);
+    state.I = (bytes[16] | bytes[17] << 8) & 0xFFF;
+    state.pc = (bytes[18] | bytes[19] << 8) & 0xFFF;
+    state.sp = std::min(bytes[20] | bytes[21] << 8, 16);
+    state.delayTimer = bytes[22];
+    state.soundTimer = bytes[23];
+}
+
+static int registerOffset(int index) {
+    int offset = 0;
+    for (int i = 0; i < index; ++i)
+        offset += REGISTER_SIZES[i];
+    return offset;
+}
+
+GdbStub::GdbStub(Chip8 &chip8, uint16_t port) : m_chip8(chip8), m_listener(NO_SOCKET), m_client(NO_SOCKET) {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        throw std::runtime_error("Not be able to initialize the sockets!");
+    }
+#endif
+
+    m_listener = socket(AF_INET, SOCK_STREAM, 0);
+
+    const int reuse = 1;
+    setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char *>(&reuse), sizeof(reuse));
+
+    // Only local debuggers, the protocol has no authentication
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+
+    if (m_listener == NO_SOCKET || bind(m_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(m_listener, 1) != 0) {
+        if (m_listener != NO_SOCKET)
+            closeSocket(m_listener);
+        throw std::runtime_error("Not be able to listen for a debugger on port " + std::to_string(port) + "!");
+    }
+
+    // Breakpoints live in the decode cache
+    m_chip8.SetBackend(Chip8::Backend::Cached);
+}
+
+GdbStub::~GdbStub() {
+    if (m_connected)
+        Disconnect();
+
+    closeSocket(m_listener);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void GdbStub::Shutdown() {
+    m_shutdown = true;
+}
+
+bool GdbStub::Accept(int timeout) {
+    pollfd listener = {m_listener, POLLIN, 0};
+    if (poll(&listener, 1, timeout) <= 0)
+        return false;
+
+    m_client = accept(m_listener, nullptr, nullptr);
+    if (m_client == NO_SOCKET)
+        return false;
+
+    // Packets are small and answered one by one
+    const int noDelay = 1;
+    setsockopt(m_client, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char *>(&noDelay), sizeof(noDelay));
+
+#ifdef SO_NOSIGPIPE
+    // No MSG_NOSIGNAL on Apple, the socket itself is told not to raise SIGPIPE
+    const int noSigPipe = 1;
+    setsockopt(m_client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    m_connected = true;
+    m_noAck = false;
+    m_input.clear();
+    m_signal = SIGNAL_TRAP;
+
+    LOG(LOG_INFO, "Debugger attached");
+    return true;
+}
+
+void GdbStub::Disconnect() {
+    closeSocket(m_client);
+    m_client = NO_SOCKET;
+    m_connected = false;
+
+    LOG(LOG_INFO, "Debugger detached");
+}
+
+void GdbStub::WaitForDebugger() {
+    while (!m_shutdown.load(std::memory_order_relaxed)) {
+        if (Accept(100)) {
+            Serve(false);
+            return;
+        }
+    }
+}
+
+void GdbStub::Poll() {
+    if (!m_connected) {
+        // Like gdbserver, a debugger attaching finds the core halted
+        if (Accept(0))
+            Serve(false);
+        return;
+    }
+
+    if (m_chip8.fault() != Fault::None) {
+        Serve(true);
+        return;
+    }
+
+    // The debugger interrupts a running core with a single 0x03 byte
+    if (Receive(0) && m_connected && !m_input.empty() && m_input[0] == '\x03') {
+        m_input.erase(0, 1);
+        m_signal = SIGNAL_INT;
+        Serve(true);
+    }
+}
+
+bool GdbStub::Receive(int timeout) {
+    if (!m_connected)
+        return false;
+
+    // Wait in short slices so Shutdown is noticed
+    const int slice = timeout < 0 ? 100 : timeout;
+
+    pollfd client = {m_client, POLLIN, 0};
+    for (;;) {
+        const int ready = poll(&client, 1, slice);
+        if (ready > 0)
+            break;
+        if (ready < 0 || timeout >= 0 || m_shutdown.load(std::memory_order_relaxed))
+            return false;
+    }
+
+    char buffer[4096];
+    const int received = static_cast<int>(recv(m_client, buffer, sizeof(buffer), 0));
+    if (received <= 0) {
+        Disconnect();
+        return false;
+    }
+
+    m_input.append(buffer, received);
+    return true;
+}
+
+bool GdbStub::ReadPacket(std::string &packet) {
+    for (;;) {
+        // Acknowledgements and noise before a packet are skipped
+        size_t start = 0;
+        while (start < m_input.size() && m_input[start] != '$' && m_input[start] != '\x03')
+            ++start;
+        m_input.erase(0, start);
+
+        if (!m_input.empty() && m_input[0] == '\x03') {
+            m_input.erase(0, 1);
+            packet = "\x03";
+            return true;
+        }
+
+        const size_t end = m_input.find('#');
+        if (!m_input.empty() && end != std::string::npos && end + 2 < m_input.size()) {
+            packet = m_input.substr(1, end - 1);
+
+            uint8_t checksum = 0;
+            for (char c : packet)
+                checksum += static_cast<uint8_t>(c);
+
+            const int high = fromHexDigit(m_input[end + 1]), low = fromHexDigit(m_input[end + 2]);
+            m_input.erase(0, end + 3);
+
+            if (m_noAck || (high << 4 | low) == checksum) {
+                if (!m_noAck)
+                    send(m_client, "+", 1, SEND_FLAGS);
+                return true;
+            }
+
+            // Ask for the packet again
+            send(m_client, "-", 1, SEND_FLAGS);
+            continue;
+        }
+
+        if (!Receive(-1))
+            return false;
+    }
+}
+
+void GdbStub::SendPacket(const std::string &data) {
+    std::string packet = "$";
+    uint8_t checksum = 0;
+
+    for (char c : data) {
+        // Characters with a meaning in the framing are escaped
+        if (c == '$' || c == '#' || c == '}' || c == '*') {
+            packet += '}';
+            c ^= 0x20;
+            checksum += '}';
+        }
+        packet += c;
+        checksum += static_cast<uint8_t>(c);
+    }
+
+    char trailer[4];
+    snprintf(trailer, sizeof(trailer), "#%02x", checksum);
+    packet += trailer;
+
+    size_t sent = 0;
+    while (sent < packet.size()) {
+        const int written = static_cast<int>(send(m_client, packet.data() + sent, static_cast<int>(packet.size() - sent), SEND_FLAGS));
+        if (written <= 0)
+            return;
+        sent += written;
+    }
+}
+
+std::string GdbStub::StopReply() const {
+    switch (m_chip8.fault()) {
+        case Fault::Breakpoint:
+            return signalReply(SIGNAL_TRAP) + "swbreak:;";
+
+        case Fault::Watchpoint: {
+            static const char *KINDS[] = {"watch", "rwatch", "awatch"};
+
+            const uint16_t address = m_chip8.watchAddress();
+            for (size_t i = 0; i < m_watchpoints.size(); ++i) {
+                const Watchpoint &watchpoint = m_watchpoints[i];
+                if (address >= watchpoint.address && address < watchpoint.address + watchpoint.size) {
+                    char reply[32];
+                    snprintf(reply, sizeof(reply), "%s:%x;", KINDS[m_watchKinds[i] - '2'], address);
+                    return signalReply(SIGNAL_TRAP) + reply;
+                }
+            }
+            return signalReply(SIGNAL_TRAP);
+        }
+
+        case Fault::UnknownOpcode:
+            return signalReply(SIGNAL_ILL);
+
+        case Fault::StackOverflow:
+        case Fault::StackUnderflow:
+            return signalReply(SIGNAL_SEGV);
+
+        default:
+            return signalReply(m_signal);
+    }
+}
+
+void GdbStub::StepOver() {
+    m_chip8.Resume();
+    if (m_chip8.fault() != Fault::None)
+        return;
+
+    Chip8State state;
+    m_chip8.SaveRegisters(state);
+
+    // Lift the breakpoint at pc for one instruction, as GDB does on targets without hardware single-step
+    const bool patched = m_breakpoints.count(state.pc) > 0;
+    if (patched)
+        m_chip8.SetBreakpoint(state.pc, false);
+
+    m_chip8.Step();
+
+    if (patched)
+        m_chip8.SetBreakpoint(state.pc, true);
+}
+
+void GdbStub::Release() {
+    for (uint16_t address : m_breakpoints)
+        m_chip8.SetBreakpoint(address, false);
+    m_breakpoints.clear();
+
+    m_watchpoints.clear();
+    m_watchKinds.clear();
+    m_chip8.SetWatchpoints(nullptr);
+
+    m_chip8.Resume();
+}
+
+void GdbStub::Serve(bool notify) {
+    if (notify)
+        SendPacket(StopReply());
+
+    std::string packet;
+    while (ReadPacket(packet)) {
+        // Already halted
+        if (packet == "\x03" || packet.empty())
+            continue;
+
+        const char command = packet[0];
+        const std::string arguments = packet.substr(1);
+
+        switch (command) {
+            case '?':
+                SendPacket(StopReply());
+                break;
+
+            case 'g':
+                SendPacket(ReadRegisters());
+                break;
+
+            case 'G':
+                WriteRegisters(arguments);
+                SendPacket("OK");
+                break;
+
+            case 'p':
+                SendPacket(ReadRegister(static_cast<int>(strtol(arguments.c_str(), nullptr, 16))));
+                break;
+
+            case 'P': {
+                const size_t equal = arguments.find('=');
+                const int index = static_cast<int>(strtol(arguments.c_str(), nullptr, 16));
+                SendPacket(equal != std::string::npos && WriteRegister(index, arguments.substr(equal + 1)) ? "OK" : "E01");
+                break;
+            }
+
+            case 'm':
+                SendPacket(ReadMemory(arguments));
+                break;
+
+            case 'M':
+                SendPacket(WriteMemory(arguments) ? "OK" : "E01");
+                break;
+
+            case 'Z':
+            case 'z':
+                // Only kinds 0 to 4 exist, anything else is not supported
+                if (arguments.empty() || arguments[0] < '0' || arguments[0] > '4')
+                    SendPacket("");
+                else
+                    SendPacket(SetPoint(arguments, command == 'Z') ? "OK" : "E01");
+                break;
+
+            case 'c':
+            case 's': {
+                if (!arguments.empty()) {
+                    Chip8State state;
+                    m_chip8.SaveState(state);
+                    state.pc = static_cast<uint16_t>(strtol(arguments.c_str(), nullptr, 16)) & 0xFFF;
+                    m_chip8.LoadState(state);
+                }
+
+                // A faulted core cannot go on, the program is over for the debugger
+                const Fault fault = m_chip8.fault();
+                if (fault != Fault::None && fault != Fault::Breakpoint && fault != Fault::Watchpoint) {
+                    char reply[8];
+                    snprintf(reply, sizeof(reply), "X%02x", fault == Fault::UnknownOpcode ? SIGNAL_ILL : SIGNAL_SEGV);
+                    SendPacket(reply);
+                    Release();
+                    Disconnect();
+                    return;
+                }
+
+                StepOver();
+
+                if (command == 's' || m_chip8.fault() != Fault::None) {
+                    m_signal = SIGNAL_TRAP;
+                    SendPacket(StopReply());
+                    break;
+                }
+
+                // Running, the next stop is reported by Poll
+                return;
+            }
+
+            case 'D':
+                SendPacket("OK");
+                Release();
+                Disconnect();
+                return;
+
+            case 'k':
+                Release();
+                Disconnect();
+                return;
+
+            case 'H':
+            case 'T':
+                SendPacket("OK");
+                break;
+
+            case 'q':
+                if (arguments.compare(0, 9, "Supported") == 0)
+                    SendPacket("PacketSize=4000;qXfer:features:read+;QStartNoAckMode+;swbreak+");
+                else if (arguments.compare(0, 22, "Xfer:features:read:tar") == 0)
+                    SendPacket(TargetDescription(arguments));
+                else if (arguments == "Attached")
+                    SendPacket("1");
+                else if (arguments == "C")
+                    SendPacket("QC1");
+                else if (arguments == "fThreadInfo")
+                    SendPacket("m1");
+                else if (arguments == "sThreadInfo")
+                    SendPacket("l");
+                else if (arguments.compare(0, 6, "Symbol") == 0)
+                    SendPacket("OK");
+                else
+                    SendPacket("");
+                break;
+
+            case 'Q':
+                if (arguments == "StartNoAckMode") {
+                    SendPacket("OK");
+                    m_noAck = true;
+                } else {
+                    SendPacket("");
+                }
+                break;
+
+            default:
+                // Including 'X' and 'v' packets, GDB falls back on the packets above
+                SendPacket("");
+                break;
+        }
+    }
+
+    // Gone or shut down, the core runs on its own again
+    Release();
+}
+
+std::string GdbStub::ReadRegisters() const {
+    Chip8State state;
+    m_chip8.SaveRegisters(state);
+
+    const std::vector<uint8_t> bytes = packRegisters(state);
+    return toHex(bytes.data(), bytes.size());
+}
+
+void GdbStub::WriteRegisters(const std::string &hex) {
+    std::vector<uint8_t> bytes;
+    if (!fromHex(hex, bytes) || bytes.size() < static_cast<size_t>(registerOffset(REGISTER_COUNT)))
+        return;
+
+    Chip8State state;
+    m_chip8.SaveState(state);
+    unpackRegisters(bytes, state);
+    m_chip8.LoadState(state);
+}
+
+std::string GdbStub::ReadRegister(int index) const {
+    if (index < 0 || index >= REGISTER_COUNT)
+        return "E01";
+
+    Chip8State state;
+    m_chip8.SaveRegisters(state);
+
+    const std::vector<uint8_t> bytes = packRegisters(state);
+    return toHex(bytes.data() + registerOffset(index), REGISTER_SIZES[index]);
+}
+
+bool GdbStub::WriteRegister(int index, const std::string &hex) {
+    std::vector<uint8_t> value;
+    if (index < 0 || index >= REGISTER_COUNT || !fromHex(hex, value) || value.size() != static_cast<size_t>(REGISTER_SIZES[index]))
+        return false;
+
+    Chip8State state;
+    m_chip8.SaveState(state);
+
+    std::vector<uint8_t> bytes = packRegisters(state);
+    memcpy(bytes.data() + registerOffset(index), value.data(), value.size());
+    unpackRegisters(bytes, state);
+
+    m_chip8.LoadState(state);
+    return true;
+}
+
+std::string GdbStub::ReadMemory(const std::string &arguments) const {
+    unsigned long address = 0, length = 0;
+    if (sscanf(arguments.c_str(), "%lx,%lx", &address, &length) != 2 || address >= 4096)
+        return "E01";
+
+    // Reads are cut at the end of memory
+    if (length > 4096 - address)
+        length = 4096 - address;
+
+    std::vector<uint8_t> bytes(length);
+    for (unsigned long i = 0; i < length; ++i)
+        bytes[i] = m_chip8.Peek(static_cast<uint16_t>(address + i));
+
+    return toHex(bytes.data(), bytes.size());
+}
+
+bool GdbStub::WriteMemory(const std::string &arguments) {
+    unsigned long address = 0, length = 0;
+    const size_t colon = arguments.find(':');
+    std::vector<uint8_t> bytes;
+
+    if (colon == std::string::npos || sscanf(arguments.c_str(), "%lx,%lx", &address, &length) != 2 ||
+        !fromHex(arguments.substr(colon + 1), bytes) || bytes.size() != length || address + length > 4096)
+        return false;
+
+    // Through LoadState, so the decode cache forgets the old code but keeps the breakpoints
+    Chip8State state;
+    m_chip8.SaveState(state);
+    memcpy(state.memory + address, bytes.data(), length);
+    m_chip8.LoadState(state);
+
+    return true;
+}
+
+bool GdbStub::SetPoint(const std::string &arguments, bool insert) {
+    char kind = 0;
+    unsigned long address = 0, length = 0;
+    if (sscanf(arguments.c_str(), "%c,%lx,%lx", &kind, &address, &length) != 3 || address >= 4096)
+        return false;
+
+    // Software and hardware breakpoints are the same patch
+    if (kind == '0' || kind == '1') {
+        if (insert)
+            m_breakpoints.insert(static_cast<uint16_t>(address));
+        else
+            m_breakpoints.erase(static_cast<uint16_t>(address));
+
+        m_chip8.SetBreakpoint(static_cast<uint16_t>(address), insert);
+        return true;
+    }
+
+    const Watchpoint watchpoint = {static_cast<uint16_t>(address), static_cast<uint16_t>(length), kind != '2', kind != '3'};
+
+    if (insert) {
+        m_watchpoints.push_back(watchpoint);
+        m_watchKinds.push_back(kind);
+    } else {
+        for (size_t i = 0; i < m_watchpoints.size(); ++i) {
+            if (m_watchpoints[i].address == watchpoint.address && m_watchpoints[i].size == watchpoint.size && m_watchKinds[i] == kind) {
+                m_watchpoints.erase(m_watchpoints.begin() + i);
+                m_watchKinds.erase(m_watchKinds.begin() + i);
+                break;
+            }
+        }
+    }
+
+    // No watchpoint, no check at all in the core
+    m_chip8.SetWatchpoints(m_watchpoints.empty() ? nullptr : &m_watchpoints);
+    return true;
+}
+
+std::string GdbStub::TargetDescription(const std::string &arguments) const {
+    // Xfer:features:read:target.xml:OFFSET,LENGTH
+    const size_t colon = arguments.rfind(':');
+    unsigned long offset = 0, length = 0;
+    if (arguments.compare(0, 30, "Xfer:features:read:target.xml:") != 0 || colon == std::string::npos ||
+        sscanf(arguments.c_str() + colon + 1, "%lx,%lx", &offset, &length) != 2)
+        return "E00";
+
+    const size_t size = sizeof(TARGET_XML) - 1;
+    if (offset >= size)
+        return "l";
+
+    const std::string chunk(TARGET_XML + offset, std::min<size_t>(length, size - offset));
+    return (offset + chunk.size() < size ? "m" : "l") + chunk;
+}
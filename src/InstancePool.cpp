@@ -0,0 +1,80 @@
+#include "InstancePool.hpp"
+
+#include <new>
+#include <stdexcept>
+
+InstancePool::InstancePool(size_t capacity, size_t bytesPerInstance)
+    : m_arena(capacity * (sizeof(Chip8) + bytesPerInstance) + sizeof(DecodeCache) + Arena::ALIGNMENT),
+      m_capacity(capacity),
+      m_resident(capacity, false) {
+    m_instances = static_cast<Chip8 *>(m_arena.Allocate(capacity * sizeof(Chip8)));
+
+    // Hand out the lowest slots first, so the instances in use stay packed
+    m_free.reserve(capacity);
+    for (size_t i = capacity; i > 0; --i)
+        m_free.push_back(i - 1);
+}
+
+InstancePool::~InstancePool() {
+    for (size_t i = 0; i < m_capacity; ++i) {
+        if (m_resident[i])
+            m_instances[i].~Chip8();
+    }
+}
+
+Chip8 &InstancePool::Acquire() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_free.empty()) {
+        throw std::runtime_error("The instance pool is full (" + std::to_string(m_capacity) + " instances)!");
+    }
+
+    const size_t index = m_free.back();
+    m_free.pop_back();
+
+    Chip8 *instance = new (&m_instances[index]) Chip8();
+    instance->SetArena(&m_arena);
+    m_resident[index] = true;
+
+    return *instance;
+}
+
+void InstancePool::Release(Chip8 &instance) {
+    const size_t index = &instance - m_instances;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (index >= m_capacity || !m_resident[index]) {
+        throw std::invalid_argument("This instance does not belong to the pool!");
+    }
+
+    instance.~Chip8();
+    m_resident[index] = false;
+    m_free.push_back(index);
+}
+
+InstancePool::Stats InstancePool::stats() const {
+    Stats stats;
+    stats.capacity = m_capacity;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        stats.resident = m_capacity - m_free.size();
+    }
+
+    // The slots of the instances are counted once they are used
+    stats.arenaBytes = m_arena.used() - (m_capacity - stats.resident) * sizeof(Chip8);
+    stats.bytesPerInstance = stats.resident ? stats.arenaBytes / stats.resident : 0;
+    stats.hugePages = m_arena.hugePages();
+
+    return stats;
+}
+
+const char *InstancePool::HugePagesName(Arena::HugePages hugePages) {
+    switch (hugePages) {
+        case Arena::HugePages::None:        return "none";
+        case Arena::HugePages::Transparent: return "transparent";
+        case Arena::HugePages::Explicit:    return "explicit";
+        default:                            return "?";
+    }
+}
@@ -0,0 +1,55 @@
+#include "Keypad.hpp"
+
+void Keypad::Edge(uint16_t bit, bool pressed) {
+    if (pressed) {
+        m_state |= bit;
+        m_pressedThisFrame |= bit;
+        m_deferredRelease &= ~bit;
+    } else if (m_pressedThisFrame & bit) {
+        m_deferredRelease |= bit;
+    } else {
+        m_state &= ~bit;
+    }
+}
+
+bool Keypad::Apply(std::chrono::steady_clock::time_point time) {
+    if (!m_queue)
+        return false;
+
+    const uint16_t previous = m_state;
+
+    const KeyEvent *event;
+    while ((event = m_queue->Front()) && event->timestamp <= time) {
+        Edge(static_cast<uint16_t>(1 << (event->key & 0xF)), event->pressed);
+
+        KeyEvent done;
+        m_queue->Pop(done);
+    }
+
+    // The edges coalesced when the queue was full are newer than every queued one
+    if (!m_queue->Front()) {
+        const uint64_t coalesced = m_queue->TakeCoalesced();
+        for (int key = 0; key < 16; ++key) {
+            if (!(coalesced >> (16 + key) & 1))
+                continue;
+
+            const uint16_t bit = static_cast<uint16_t>(1 << key);
+            if (coalesced >> (32 + key) & 1)
+                Edge(bit, true);
+            if (!(coalesced >> key & 1))
+                Edge(bit, false);
+        }
+    }
+
+    return m_state != previous;
+}
+
+bool Keypad::EndFrame() {
+    const uint16_t previous = m_state;
+
+    m_state &= ~m_deferredRelease;
+    m_pressedThisFrame = 0;
+    m_deferredRelease = 0;
+
+    return m_state != previous;
+}
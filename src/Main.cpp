@@ -1,18 +1,177 @@
+#include <algorithm>
+#include <chrono>
 #include <iostream>
 #include <exception>
+#include <memory>
+#include <vector>
+#include <cstdio>
+#include <ctime>
+#include <future>
 
 #include <cxxopts.hpp>
 
 #include "Window.hpp"
 #include "Chip8.hpp"
 #include "Context.hpp"
+#include "Emulator.hpp"
+#include "Renderer.hpp"
+#include "FrameDumper.hpp"
+#include "RomStore.hpp"
+#include "MetricsExporter.hpp"
+#include "StartupTrace.hpp"
+#include "StateReader.hpp"
+#include "WallRenderer.hpp"
 
 #define PIXEL_SIZE 5
 
-#define SCREEN_ROWS (GFX_ROWS * PIXEL_SIZE)
-#define SCREEN_COLS (GFX_COLS * PIXEL_SIZE)
+/**
+ * @brief Text of the metrics overlay
+ */
+static std::string overlayText(const Metrics &metrics, const Metrics::Rates &rates, const Pacer &pacer) {
+  char target[16] = "MAX";
+  if (pacer.targetSpeed() > 0)
+    snprintf(target, sizeof(target), "%.2f", pacer.targetSpeed());
+
+  char text[256];
+  snprintf(text, sizeof(text),
+           "IPS %.0f\nFPS %.1f / %.1f\nSPEED %.2f / %s\nCPU %.1f%%\nUPLOAD %.1f US\nDRAW %.1f US\nDRIFT P99 %.2f MS\nUNDERRUNS %llu",
+           rates.instructionsPerSecond, rates.framesPerSecond, rates.presentedFramesPerSecond, rates.speed, target,
+           rates.cpuUtilisation * 100.0,
+           metrics.uploadTime.Quantile(0.5) / 1000.0, metrics.drawTime.Quantile(0.5) / 1000.0,
+           metrics.timerDrift.Quantile(0.99) / 1e6, static_cast<unsigned long long>(metrics.audioUnderruns.value()));
+  return text;
+}
+
+/**
+ * @brief Speed reached by the pacer against its target
+ */
+static void reportSpeed(const Pacer &pacer) {
+  std::cout << "Speed : " << pacer.achievedSpeed() << "x real time";
+  if (pacer.targetSpeed() > 0)
+    std::cout << " for a target of " << pacer.targetSpeed() << "x";
+  std::cout << " (" << Pacer::ModeName(pacer.mode()) << ")" << std::endl;
+}
+
+/**
+ * @brief Host CPU time spent by the process since a sample, as a share of one core
+ */
+static void reportCpu(const Metrics &metrics, const Metrics::Sample &since) {
+  const Metrics::Rates rates = Metrics::Rate(since, metrics.sample());
+  std::cout << "CPU : " << rates.cpuUtilisation * 100.0 << "% of a core" << std::endl;
+}
+
+/**
+ * @brief Parse a "RRGGBB,RRGGBB" background and foreground palette
+ */
+static std::pair<uint32_t, uint32_t> parsePalette(const std::string &palette) {
+  const size_t comma = palette.find(',');
+  if (comma == std::string::npos)
+    throw std::invalid_argument("The palette must be given as BACKGROUND,FOREGROUND (e.g. 000000,FFFFFF).");
+
+  return {std::stoul(palette.substr(0, comma), nullptr, 16), std::stoul(palette.substr(comma + 1), nullptr, 16)};
+}
+
+/**
+ * @brief Show the instances exported to a shared memory segment until the window is closed
+ *
+ * A tile shows the screen of an instance, its speed over the last half second, and its status in
+ * the colour of the border: red once faulted, orange while waiting for a key, grey when nothing
+ * was published for a second.
+ */
+static int runWall(const std::string &name, const std::pair<uint32_t, uint32_t> &palette) {
+  using Clock = std::chrono::steady_clock;
+
+  StateReader reader(name);
+  const int tiles = static_cast<int>(std::min<uint32_t>(reader.instances(), WallRenderer::MAX_TILES));
+  if (reader.instances() > static_cast<uint32_t>(tiles))
+    std::cout << "Wall : only the first " << tiles << " of " << reader.instances() << " instances are shown" << std::endl;
+
+  Window window(1280, 720, ("Chip8 Wall - " + name).c_str());
+  WallRenderer wall(tiles);
+  wall.SetPalette(palette.first, palette.second);
+
+  struct Tile {
+    uint32_t sequence = 0;
+    Clock::time_point published;  // Last publication seen
+    bool sampled = false;         // The first snapshot was seen, the speed needs two samples
+    uint64_t sampleFrame = 0;     // Frame and time at the last speed sample
+    Clock::time_point sampleTime;
+    uint32_t status = WallRenderer::RUNNING;
+  };
+
+  const Clock::time_point start = Clock::now();
+  std::vector<Tile> states(tiles);
+  for (Tile &tile : states)
+    tile.published = tile.sampleTime = start;
+
+  StateReader::Snapshot snapshot;
+  Clock::time_point lastSample = start;
+
+  window.SetDrawFrameFunc([&](bool redraw) {
+    const Clock::time_point now = Clock::now();
+    const bool sample = now - lastSample >= std::chrono::milliseconds(500);
+    if (sample)
+      lastSample = now;
+
+    for (int i = 0; i < tiles; ++i) {
+      Tile &tile = states[i];
+
+      // Only the instances that published since the last check are copied
+      const uint32_t sequence = reader.sequence(i);
+      if (sequence != tile.sequence && !(sequence & 1) && reader.Read(i, snapshot)) {
+        const SharedInstanceState &state = snapshot.state;
+        tile.sequence = snapshot.sequence;
+        tile.published = now;
+        wall.SetScreen(i, state.screen);
+
+        tile.status = WallRenderer::RUNNING;
+        if (state.fault)
+          tile.status |= WallRenderer::FAULTED;
+        if ((state.opcode & 0xF0FF) == 0xF00A && !state.keys)
+          tile.status |= WallRenderer::WAITING;
+
+        if (!tile.sampled) {
+          // The instance may have run long before the wall opened, its first frame is not a speed
+          wall.SetLabel(i, state.fault ? std::to_string(i) + " FAULT" : std::to_string(i));
+          tile.sampled = true;
+          tile.sampleFrame = state.frame;
+          tile.sampleTime = now;
+        } else if (sample) {
+          const double seconds = std::chrono::duration<double>(now - tile.sampleTime).count();
+          char label[WallRenderer::LABEL_CHARS + 1];
+          snprintf(label, sizeof(label), "%d %.2fX", i, (state.frame - tile.sampleFrame) / (seconds * 60.0));
+          wall.SetLabel(i, state.fault ? std::to_string(i) + " FAULT" : label);
+          tile.sampleFrame = state.frame;
+          tile.sampleTime = now;
+        }
+      }
+
+      const bool stale = now - tile.published >= std::chrono::seconds(1);
+      wall.SetStatus(i, tile.status | (stale ? WallRenderer::STALE : 0));
+      if (stale && sample && !(tile.status & WallRenderer::FAULTED))
+        wall.SetLabel(i, std::to_string(i) + " 0.00X");
+    }
+
+    if (wall.Upload())
+      redraw = true;
+
+    if (redraw) {
+      int width, height;
+      glfwGetFramebufferSize(window.window(), &width, &height);
+      wall.Display(width, height);
+    }
+
+    return redraw;
+  });
+
+  window.mainLoop();
+  return 0;
+}
 
 int main(int argc, char **argv) try {
+  // The startup timeline starts here
+  StartupTrace startupTrace(std::cout);
+
   /* Command-line */
 
   cxxopts::Options options("chip8", "A Chip8 emulator");
@@ -21,7 +180,34 @@ int main(int argc, char **argv) try {
   // clang-format off
   options.add_options()
       ("h,help", "Show help")
-      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME");
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("c,cycles", "Instructions executed per 60 Hz frame, or machine cycles with --timing vip where it defaults to 3668", cxxopts::value<int>()->default_value("9"), "N")
+      ("timing", "Length of a frame: instructions, or vip for the machine cycles of the COSMAC VIP", cxxopts::value<std::string>()->default_value("instructions"), "NAME")
+      ("backend", "Execution engine: switch or cached", cxxopts::value<std::string>()->default_value("switch"), "NAME")
+      ("pacing", "Frame pacing: realtime, fast-forward or unlimited (default: realtime, unlimited when headless)", cxxopts::value<std::string>(), "MODE")
+      ("speed", "Multiple of real time of the fast-forward", cxxopts::value<double>()->default_value("4"), "X")
+      ("run-ahead", "Frames emulated ahead to reduce input latency", cxxopts::value<int>()->default_value("0"), "N")
+      ("rom-db", "ROM database giving the cycles per frame and the keymap of known games", cxxopts::value<std::string>(), "FILE")
+      ("decode-cache", "Keep the decoding of games in DIR, with the cached backend", cxxopts::value<std::string>(), "DIR")
+      ("seed", "Seed of the random number generator, defaults to the current time", cxxopts::value<uint32_t>(), "N")
+      ("record-video", "Record the session losslessly (convert it with chip8-video)", cxxopts::value<std::string>(), "FILE")
+      ("gdb", "Serve the GDB remote protocol on this local TCP port, the headless mode waits for the debugger", cxxopts::value<uint16_t>(), "PORT")
+      ("metrics", "Publish Prometheus metrics to FILE every second, or serve them on unix:PATH", cxxopts::value<std::string>(), "FILE")
+      ("shm", "Export the screen, registers and memory to the shared memory NAME (watch it with chip8-watch)", cxxopts::value<std::string>(), "NAME")
+      ("shm-memory", "Range of memory exported, in hexadecimal", cxxopts::value<std::string>()->default_value("0,1000"), "ADDRESS,SIZE")
+      ("cheat", "Freeze a byte of memory at every frame, may be repeated (find it with chip8-search)", cxxopts::value<std::vector<std::string>>(), "ADDRESS=VALUE")
+      ("startup-trace", "Print the timeline of the startup phases, up to the first frame on screen");
+
+  options.add_options("Rendering")
+      ("pixel-size", "Size of a Chip8 pixel on screen", cxxopts::value<int>()->default_value(std::to_string(PIXEL_SIZE)), "N")
+      ("palette", "Background and foreground colours of the screen and of dumped frames", cxxopts::value<std::string>()->default_value("000000,FFFFFF"), "RGB,RGB")
+      ("overlay", "Show the metrics over the screen (F3 toggles it)")
+      ("headless", "Run without window, audio nor OpenGL")
+      ("wall", "Instead of a game, show every instance exported to the shared memory NAME in a grid", cxxopts::value<std::string>(), "NAME")
+      ("frames", "Number of frames to emulate in headless mode", cxxopts::value<uint64_t>()->default_value("600"), "N")
+      ("dump-dir", "Directory where frames are written (F12 takes a screenshot)", cxxopts::value<std::string>()->default_value("."), "DIR")
+      ("dump-every", "Write one emulated frame out of N, skipped on screen or not, 0 to disable", cxxopts::value<uint64_t>()->default_value("0"), "N")
+      ("dump-format", "Format of written frames: png or ppm", cxxopts::value<std::string>()->default_value("png"), "FORMAT");
   ;
   // clang-format on
 
@@ -30,10 +216,13 @@ int main(int argc, char **argv) try {
   auto result = options.parse(argc, argv);
 
   if (result["help"].as<bool>()) {
-      std::cout << options.help();
+      std::cout << options.help({"", "Rendering"});
       return 0;
   }
 
+  if (result.count("wall"))
+    return runWall(result["wall"].as<std::string>(), parsePalette(result["palette"].as<std::string>()));
+
   std::string gamePath = "";
   if (result.count("game")) {
       gamePath = result["game"].as<std::string>();
@@ -43,29 +232,306 @@ int main(int argc, char **argv) try {
       return 0;
   }
 
+  const Chip8::Timing timing = Chip8::ParseTiming(result["timing"].as<std::string>());
+
+  StartupTrace *trace = result["startup-trace"].as<bool>() ? &startupTrace : nullptr;
+
+  // Games are mapped once, instances copy them from the shared image. The ROM is read and hashed
+  // on another thread, concurrently with the window and OpenGL initialisation.
+  RomStore roms;
+  std::future<std::shared_ptr<const RomImage>> gameLoad = std::async(std::launch::async, [&]() {
+    StartupTrace::Span span(trace, "rom load");
+
+    if (result.count("rom-db"))
+      roms.LoadDatabase(result["rom-db"].as<std::string>());
+
+    return roms.Open(gamePath);
+  });
+
+  std::shared_ptr<const RomImage> game;
+  const RomInfo *info = nullptr;
+  int cycles = 0;
+
+  // Wait for the ROM, then apply what the database knows about it
+  const auto openGame = [&]() {
+    game = gameLoad.get();
+    info = roms.Lookup(game->hash());
+
+    char hash[17];
+    snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(game->hash()));
+    std::cout << "Game : " << (info ? info->name : game->name()) << " (" << hash << ", " << game->size() << " bytes)" << std::endl;
+
+    if (info && !info->quirks.empty())
+      std::cout << "Game : the quirks of this game are not supported, it may not run correctly" << std::endl;
+
+    // The command-line wins over the database, which gives instructions
+    if (timing == Chip8::Timing::Vip)
+      cycles = result.count("cycles") ? result["cycles"].as<int>() : Chip8::VIP_CYCLES_PER_FRAME;
+    else
+      cycles = result.count("cycles") || !info || info->cycles <= 0 ? result["cycles"].as<int>() : info->cycles;
+  };
+
+  const int pixelSize = result["pixel-size"].as<int>();
+
+  const Chip8::Backend backend = Chip8::ParseBackend(result["backend"].as<std::string>());
+
+  const uint32_t seed = result.count("seed") ? result["seed"].as<uint32_t>() : static_cast<uint32_t>(time(nullptr));
+
+  const std::pair<uint32_t, uint32_t> palette = parsePalette(result["palette"].as<std::string>());
+
+  FrameDumper dumper(SoftwareRenderer(pixelSize, palette.first, palette.second),
+                     result["dump-dir"].as<std::string>(),
+                     FrameDumper::ParseFormat(result["dump-format"].as<std::string>()),
+                     result["dump-every"].as<uint64_t>());
+
+  std::unique_ptr<DecodeStore> decodeStore;
+  if (result.count("decode-cache"))
+    decodeStore = std::make_unique<DecodeStore>(result["decode-cache"].as<std::string>());
+
+  std::unique_ptr<VideoRecorder> recorder;
+  if (result.count("record-video"))
+    recorder = std::make_unique<VideoRecorder>(result["record-video"].as<std::string>());
+
+  Metrics metrics;
+
+  std::unique_ptr<MetricsExporter> exporter;
+  if (result.count("metrics"))
+    exporter = std::make_unique<MetricsExporter>(metrics, result["metrics"].as<std::string>());
+
+  Cheats cheats;
+  if (result.count("cheat")) {
+    for (const std::string &cheat : result["cheat"].as<std::vector<std::string>>()) {
+      const Cheat parsed = Cheats::Parse(cheat);
+      cheats.Freeze(parsed.address, parsed.value);
+    }
+  }
+
+  std::unique_ptr<StateExporter> stateExporter;
+  if (result.count("shm")) {
+    const std::pair<uint16_t, uint16_t> range = StateExporter::ParseRange(result["shm-memory"].as<std::string>());
+    stateExporter = std::make_unique<StateExporter>(result["shm"].as<std::string>(), 1, range.first, range.second);
+  }
+
+  /* Headless */
+
+  if (result["headless"].as<bool>()) {
+    openGame();
+
+    Chip8 app;
+    app.SetBackend(backend);
+    app.SetDecodeStore(decodeStore.get());
+    app.SetSeed(seed);
+    app.Initialize();
+    app.LoadGame(game->data(), game->size());
+
+    std::unique_ptr<GdbStub> debugger;
+    if (result.count("gdb")) {
+      debugger = std::make_unique<GdbStub>(app, result["gdb"].as<uint16_t>());
+      std::cout << "GDB : waiting for a debugger on port " << result["gdb"].as<uint16_t>() << std::endl;
+      debugger->WaitForDebugger();
+    }
+
+    Emulator emulator(app);
+    emulator.SetCyclesPerFrame(cycles);
+    emulator.SetTiming(timing);
+    emulator.SetRecorder(recorder.get());
+    emulator.SetDumper(&dumper);
+    emulator.SetMetrics(&metrics);
+    emulator.SetDebugger(debugger.get());
+    emulator.SetStateExporter(stateExporter.get());
+    emulator.SetCheats(cheats.empty() ? nullptr : &cheats);
+
+    if (recorder)
+      recorder->SetLossless(true);
+
+    // Every frame is dumped, so none is skipped
+    Pacer &pacer = emulator.pacer();
+    pacer.SetMode(result.count("pacing") ? Pacer::ParseMode(result["pacing"].as<std::string>()) : Pacer::Mode::Unlimited,
+                  result["speed"].as<double>());
+    pacer.SetFrameskip(false);
+
+    // Run on this thread, frames are still handed through the triple buffer
+    const uint64_t frames = result["frames"].as<uint64_t>();
+    const Metrics::Sample start = metrics.sample();
+    pacer.Start();
+    for (uint64_t frame = 1; frame <= frames; ++frame) {
+      emulator.RunFrame();
+      emulator.AcquireFrame();
+
+      if (emulator.fault() != Fault::None) {
+        std::cout << "Fault : " << Chip8::FaultName(emulator.fault()) << " at frame " << frame << std::endl;
+
+        // The frames dumped up to the fault matter most, a write error must not hide the fault
+        try {
+          dumper.Flush();
+        } catch (const std::exception &e) {
+          std::cout << e.what() << std::endl;
+        }
+        return 2;
+      }
+
+      pacer.Wait();
+    }
+
+    dumper.Flush();
+
+    if (result.count("pacing")) {
+      reportSpeed(pacer);
+      reportCpu(metrics, start);
+    }
+
+    return 0;
+  }
+
   /* Application */
 
-  Window window(SCREEN_COLS, SCREEN_ROWS, "Chip8 Emulator");
+  Window window(GFX_COLS * pixelSize, GFX_ROWS * pixelSize, "Chip8 Emulator", trace);
 
   Context context(window);
 
-  Chip8 app(context);
+  // The audio device is opened in the background on the first beep
+  context.SetStartupTrace(trace);
+
+  const StartupTrace::Clock::time_point shadersStart = StartupTrace::Clock::now();
+  Renderer renderer;
+  if (trace)
+    trace->Record("shaders", shadersStart, StartupTrace::Clock::now());
+
+  {
+    StartupTrace::Span span(trace, "rom wait");
+    openGame();
+  }
+
+  Chip8 app;
 
   window.SetWindowUserPointer(&context);
 
-  app.Initialize();
-  app.LoadGame(gamePath);
+  if (info)
+    context.SetKeymap(info->keymap);
 
-  window.SetDrawFrameFunc([&]() {
-    context.ComputeDeltaTime();
+  context.SetMetrics(&metrics);
+  context.SetOverlayVisible(result["overlay"].as<bool>());
+  renderer.SetMetrics(&metrics);
+  renderer.SetPalette(palette.first, palette.second);
 
-    app.Idle(context);
-    app.Display(context); 
+  app.SetSoundFunc([&](bool beep) {
+    if (beep)
+      context.playBeep();
+    else
+      context.stopAudio();
   });
 
+  app.SetBackend(backend);
+  app.SetDecodeStore(decodeStore.get());
+  app.SetSeed(seed);
+  {
+    StartupTrace::Span span(trace, "load game");
+    app.Initialize();
+    app.LoadGame(game->data(), game->size());
+  }
+
+  // The debugger attaches whenever it wants, it is served on the emulation thread
+  std::unique_ptr<GdbStub> debugger;
+  if (result.count("gdb")) {
+    debugger = std::make_unique<GdbStub>(app, result["gdb"].as<uint16_t>());
+    std::cout << "GDB : listening on port " << result["gdb"].as<uint16_t>() << std::endl;
+  }
+
+  // The core runs on its own thread, the main thread only presents frames and polls events
+  Emulator emulator(app, &context.keyQueue());
+  emulator.SetCyclesPerFrame(cycles);
+  emulator.SetTiming(timing);
+  // The speculative frames would hit the breakpoints too
+  emulator.SetRunAheadFrames(debugger ? 0 : result["run-ahead"].as<int>());
+  emulator.SetRecorder(recorder.get());
+  emulator.SetDumper(&dumper);
+  emulator.SetMetrics(&metrics);
+  emulator.SetDebugger(debugger.get());
+  emulator.SetStateExporter(stateExporter.get());
+  emulator.SetCheats(cheats.empty() ? nullptr : &cheats);
+  emulator.pacer().SetMode(result.count("pacing") ? Pacer::ParseMode(result["pacing"].as<std::string>()) : Pacer::Mode::RealTime,
+                           result["speed"].as<double>());
+
+  // The main loop sleeps until the next frame is published, or input comes, or the next 60 Hz tick
+  emulator.SetWakeFunc(&Window::Wake);
+  window.SetWaitTimeout(std::chrono::duration<double>(Pacer::FRAME_DURATION).count());
+
+  bool framePresented = false;
+  bool firstFrameShown = false;
+
+  // The overlay is refreshed twice a second with the rates over that period
+  Metrics::Sample overlaySample = metrics.sample();
+  bool overlayShown = false;
+
+  window.SetDrawFrameFunc([&](bool redraw) {
+    // Close the window once the core has faulted, the fault is reported on exit with status 2
+    if (emulator.fault() != Fault::None)
+      glfwSetWindowShouldClose(window.window(), 1);
+
+    // Nothing is drawn nor swapped while the screen does not change, e.g. in FX0A or an idle loop
+    if (emulator.AcquireFrame()) {
+      renderer.Update(emulator.frame());
+      framePresented = true;
+      redraw = true;
+    }
+
+    if (context.takeScreenshotRequest())
+      std::cout << "Screenshot : " << dumper.Push(emulator.frame(), emulator.frameCount()) << std::endl;
+
+    if (context.overlayVisible()) {
+      const Metrics::Sample now = metrics.sample();
+      if (!overlayShown || now.time - overlaySample.time >= std::chrono::milliseconds(500)) {
+        renderer.SetOverlay(overlayText(metrics, Metrics::Rate(overlaySample, now), emulator.pacer()));
+        overlaySample = now;
+        overlayShown = true;
+        redraw = true;
+      }
+    } else if (overlayShown) {
+      renderer.SetOverlay("");
+      overlayShown = false;
+      redraw = true;
+    }
+
+    if (redraw)
+      renderer.Display();
+
+    if (trace && !firstFrameShown && framePresented) {
+      glFinish();
+      trace->Mark("first frame drawn");
+      firstFrameShown = true;
+    }
+
+    return redraw;
+  });
+
+  const Metrics::Sample start = metrics.sample();
+  emulator.Start();
+
   window.mainLoop();
 
+  // The emulation thread may be serving the debugger
+  if (debugger)
+    debugger->Shutdown();
+
+  emulator.Stop();
+  dumper.Flush();
+
+  reportSpeed(emulator.pacer());
+  reportCpu(metrics, start);
+
+  if (emulator.runAheadFrames() > 0)
+    std::cout << "Run-ahead cost : " << emulator.runAheadCost() / 1000.0 << " us per frame" << std::endl;
+
+  if (recorder && recorder->dropped() > 0)
+    std::cout << "Video : " << recorder->dropped() << " frames dropped" << std::endl;
+
+  if (emulator.fault() != Fault::None) {
+    std::cout << "Fault : " << Chip8::FaultName(emulator.fault()) << " at frame " << emulator.frameCount() << std::endl;
+    return 2;
+  }
+
   return 0;
 } catch (const std::exception &e) {
   std::cout << e.what() << std::endl;
+  return 1;
 }
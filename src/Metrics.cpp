@@ -0,0 +1,166 @@
+#include "Metrics.hpp"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+static int highestBit(uint64_t value) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return static_cast<int>(index);
+#else
+    return 63 - __builtin_clzll(value);
+#endif
+}
+
+int Histogram::BucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS)
+        return static_cast<int>(value);
+
+    // The SUB_BITS bits below the highest one select the bucket within the power of two
+    const int shift = highestBit(value) - SUB_BITS;
+    return (shift + 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t Histogram::BucketLimit(int index) {
+    if (index < SUB_BUCKETS)
+        return index;
+
+    const int shift = index / SUB_BUCKETS - 1;
+    const uint64_t low = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+}
+
+void Histogram::Record(uint64_t value) {
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+}
+
+uint64_t Histogram::Quantile(double q) const {
+    // The buckets are read one by one while samples keep coming, so count them rather than trust m_count
+    uint64_t total = 0;
+    for (const std::atomic<uint64_t> &bucket : m_buckets)
+        total += bucket.load(std::memory_order_relaxed);
+
+    if (total == 0)
+        return 0;
+
+    const uint64_t rank = q <= 0 ? 1 : q >= 1 ? total : static_cast<uint64_t>(q * total + 0.5);
+
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank && seen > 0)
+            return BucketLimit(i);
+    }
+
+    return BucketLimit(BUCKETS - 1);
+}
+
+Metrics::Metrics() : m_start(Clock::now()) {}
+
+Metrics::Sample Metrics::sample() const {
+    Sample sample;
+    sample.time = Clock::now();
+    sample.instructions = instructions.value();
+    sample.frames = frames.value();
+    sample.presentedFrames = presentedFrames.value();
+    sample.cpuSeconds = ProcessCpuTime();
+    return sample;
+}
+
+Metrics::Rates Metrics::Rate(const Sample &from, const Sample &to) {
+    Rates rates;
+
+    const double seconds = std::chrono::duration<double>(to.time - from.time).count();
+    if (seconds <= 0)
+        return rates;
+
+    rates.instructionsPerSecond = (to.instructions - from.instructions) / seconds;
+    rates.framesPerSecond = (to.frames - from.frames) / seconds;
+    rates.presentedFramesPerSecond = (to.presentedFrames - from.presentedFrames) / seconds;
+    rates.speed = rates.framesPerSecond / 60.0;
+    rates.cpuUtilisation = (to.cpuSeconds - from.cpuSeconds) / seconds;
+
+    return rates;
+}
+
+double Metrics::ProcessCpuTime() {
+#ifdef _WIN32
+    FILETIME creation, exit, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        return 0;
+
+    // In 100 ns units
+    const auto toSeconds = [](const FILETIME &time) {
+        return ((static_cast<uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime) * 1e-7;
+    };
+    return toSeconds(kernel) + toSeconds(user);
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+static void writeHeader(std::ostream &out, const char *name, const char *type, const char *help) {
+    out << "# HELP " << name << " " << help << "\n"
+        << "# TYPE " << name << " " << type << "\n";
+}
+
+static void writeCounter(std::ostream &out, const char *name, const char *help, uint64_t value) {
+    writeHeader(out, name, "counter", help);
+    out << name << " " << value << "\n";
+}
+
+static void writeGauge(std::ostream &out, const char *name, const char *help, double value) {
+    writeHeader(out, name, "gauge", help);
+    out << name << " " << value << "\n";
+}
+
+static void writeSummary(std::ostream &out, const char *name, const char *help, const Histogram &histogram) {
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999, 1.0};
+
+    // Recorded in nanoseconds, exposed in seconds
+    writeHeader(out, name, "summary", help);
+    for (double q : QUANTILES)
+        out << name << "{quantile=\"" << q << "\"} " << histogram.Quantile(q) * 1e-9 << "\n";
+    out << name << "_sum " << histogram.sum() * 1e-9 << "\n"
+        << name << "_count " << histogram.count() << "\n";
+}
+
+void Metrics::WritePrometheus(std::ostream &out, const Rates &rates) const {
+    const Sample now = sample();
+
+    writeCounter(out, "chip8_instructions_total", "Instructions executed.", now.instructions);
+    writeCounter(out, "chip8_frames_total", "Emulated 60 Hz frames.", now.frames);
+    writeCounter(out, "chip8_presented_frames_total", "Frames displayed.", now.presentedFrames);
+    writeCounter(out, "chip8_timer_resyncs_total", "Times the emulation fell behind the wall clock and skipped ahead.", timerResyncs.value());
+    writeCounter(out, "chip8_audio_underruns_total", "Beeps whose samples ran out before they were stopped.", audioUnderruns.value());
+
+    writeHeader(out, "process_cpu_seconds_total", "counter", "User and system CPU time of the process.");
+    out << "process_cpu_seconds_total " << now.cpuSeconds << "\n";
+
+    writeGauge(out, "chip8_emulated_seconds", "Emulated time.", now.frames / 60.0);
+    writeGauge(out, "chip8_wall_seconds", "Wall time since the start.", std::chrono::duration<double>(now.time - m_start).count());
+    writeGauge(out, "chip8_instructions_per_second", "Instructions executed per second over the last interval.", rates.instructionsPerSecond);
+    writeGauge(out, "chip8_frames_per_second", "Emulated frames per second over the last interval.", rates.framesPerSecond);
+    writeGauge(out, "chip8_presented_frames_per_second", "Displayed frames per second over the last interval.", rates.presentedFramesPerSecond);
+    writeGauge(out, "chip8_emulation_speed_ratio", "Emulated time over wall time in the last interval.", rates.speed);
+    writeGauge(out, "chip8_cpu_utilisation_ratio", "CPU time of the process over wall time in the last interval, 1 per busy core.", rates.cpuUtilisation);
+
+    writeSummary(out, "chip8_frame_time_seconds", "Time to emulate one frame.", frameTime);
+    writeSummary(out, "chip8_timer_drift_seconds", "Lateness of each frame against the 60 Hz schedule.", timerDrift);
+    writeSummary(out, "chip8_upload_time_seconds", "Texture upload time of a displayed frame.", uploadTime);
+    writeSummary(out, "chip8_draw_time_seconds", "Draw call time of a displayed frame.", drawTime);
+}
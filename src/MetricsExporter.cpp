@@ -0,0 +1,156 @@
+#include "MetricsExporter.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// A client closing early must not kill the process with SIGPIPE
+#ifdef MSG_NOSIGNAL
+static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static const int SEND_FLAGS = 0;
+#endif
+#endif
+
+static const char SOCKET_PREFIX[] = "unix:";
+
+MetricsExporter::MetricsExporter(const Metrics &metrics, const std::string &path, std::chrono::milliseconds interval)
+    : m_metrics(metrics), m_path(path), m_interval(interval), m_last(metrics.sample()) {
+    if (m_path.compare(0, sizeof(SOCKET_PREFIX) - 1, SOCKET_PREFIX) == 0) {
+        m_socket = true;
+        m_path = m_path.substr(sizeof(SOCKET_PREFIX) - 1);
+
+#ifdef _WIN32
+        throw std::runtime_error("Not be able to serve the metrics on a Unix socket on this platform!");
+#else
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (m_path.empty() || m_path.size() >= sizeof(address.sun_path)) {
+            throw std::invalid_argument("Not be able to use " + m_path + " as a socket path!");
+        }
+        m_path.copy(address.sun_path, m_path.size());
+
+        // A socket left by a previous run would make bind fail, anything else is not ours to remove
+        struct stat existing;
+        if (lstat(m_path.c_str(), &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw std::runtime_error("Not be able to listen on " + m_path + ", it exists and is not a socket!");
+            }
+            unlink(m_path.c_str());
+        }
+
+        m_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (m_listener < 0 || bind(m_listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(m_listener, 4) != 0) {
+            if (m_listener >= 0)
+                close(m_listener);
+            throw std::runtime_error("Not be able to listen on " + m_path + "!");
+        }
+#endif
+    }
+
+    m_thread = std::thread(&MetricsExporter::Run, this);
+}
+
+MetricsExporter::~MetricsExporter() {
+    m_running = false;
+
+    if (m_thread.joinable())
+        m_thread.join();
+
+#ifndef _WIN32
+    if (m_listener >= 0) {
+        close(m_listener);
+        unlink(m_path.c_str());
+    }
+#endif
+}
+
+void MetricsExporter::Run() {
+    using Clock = Metrics::Clock;
+
+    Clock::time_point next = Clock::now() + m_interval;
+
+    while (m_running.load(std::memory_order_relaxed)) {
+        const Clock::time_point now = Clock::now();
+        if (now >= next) {
+            next += m_interval;
+            Update();
+
+            if (!m_socket)
+                WriteFile();
+            continue;
+        }
+
+        // Wake up often enough to stop quickly
+        const auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(next - now) + std::chrono::milliseconds(1);
+        const std::chrono::milliseconds timeout = std::min(remaining, std::chrono::milliseconds(100));
+
+        if (m_socket)
+            Serve(static_cast<int>(timeout.count()));
+        else
+            std::this_thread::sleep_for(timeout);
+    }
+}
+
+void MetricsExporter::Update() {
+    const Metrics::Sample now = m_metrics.sample();
+    m_rates = Metrics::Rate(m_last, now);
+    m_last = now;
+}
+
+void MetricsExporter::WriteFile() const {
+    // Scrapers never see a partial file
+    const std::string temporary = m_path + ".tmp";
+
+    {
+        std::ofstream file(temporary, std::ios::trunc);
+        if (!file)
+            return;
+
+        m_metrics.WritePrometheus(file, m_rates);
+    }
+
+    // rename replaces the file atomically on POSIX, but fails on Windows when it exists
+#ifdef _WIN32
+    std::remove(m_path.c_str());
+#endif
+    std::rename(temporary.c_str(), m_path.c_str());
+}
+
+void MetricsExporter::Serve(int timeout) {
+#ifndef _WIN32
+    pollfd listener = {m_listener, POLLIN, 0};
+    if (poll(&listener, 1, timeout) <= 0)
+        return;
+
+    const int client = accept(m_listener, nullptr, nullptr);
+    if (client < 0)
+        return;
+
+    std::ostringstream text;
+    m_metrics.WritePrometheus(text, m_rates);
+
+    const std::string body = text.str();
+    size_t sent = 0;
+    while (sent < body.size()) {
+        const ssize_t written = send(client, body.data() + sent, body.size() - sent, SEND_FLAGS);
+        if (written <= 0)
+            break;
+        sent += written;
+    }
+
+    close(client);
+#else
+    (void)timeout;
+#endif
+}
@@ -0,0 +1,94 @@
+#include "Pacer.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+constexpr Pacer::Clock::duration Pacer::FRAME_DURATION;
+
+// Beyond this lag we stop trying to catch up and resynchronise on the wall clock
+static constexpr int MAX_FRAMES_BEHIND = 5;
+
+void Pacer::SetMode(Mode mode, double speed) {
+    if (mode == Mode::FastForward && !(speed > 0)) {
+        throw std::invalid_argument("The fast-forward speed must be positive!");
+    }
+
+    m_mode = mode;
+    m_speed = mode == Mode::FastForward ? speed : 1.0;
+    m_frameDuration = std::chrono::duration_cast<Clock::duration>(FRAME_DURATION / m_speed);
+}
+
+Pacer::Mode Pacer::ParseMode(const std::string &name) {
+    if (name == "realtime")
+        return Mode::RealTime;
+    if (name == "fast-forward")
+        return Mode::FastForward;
+    if (name == "unlimited")
+        return Mode::Unlimited;
+
+    throw std::invalid_argument("Unknown pacing: " + name + " (expected realtime, fast-forward or unlimited).");
+}
+
+const char *Pacer::ModeName(Mode mode) {
+    switch (mode) {
+        case Mode::RealTime:    return "realtime";
+        case Mode::FastForward: return "fast-forward";
+        case Mode::Unlimited:   return "unlimited";
+        default:                return "?";
+    }
+}
+
+void Pacer::Start() {
+    const Clock::time_point now = Clock::now();
+
+    m_next = now;
+    m_lastPresent = now - FRAME_DURATION;
+    m_start.store(now.time_since_epoch().count(), std::memory_order_relaxed);
+    m_frames.store(0, std::memory_order_relaxed);
+}
+
+void Pacer::Wait() {
+    m_frames.fetch_add(1, std::memory_order_relaxed);
+
+    if (m_mode == Mode::Unlimited)
+        return;
+
+    m_next += m_frameDuration;
+
+    const Clock::time_point now = Clock::now();
+    if (now - m_next > MAX_FRAMES_BEHIND * m_frameDuration) {
+        m_next = now;
+
+        if (m_metrics)
+            m_metrics->timerResyncs.Add();
+    }
+
+    std::this_thread::sleep_until(m_next);
+
+    // How late the next frame starts against the schedule
+    if (m_metrics)
+        m_metrics->timerDrift.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::max(Clock::now() - m_next, Clock::duration::zero())).count());
+}
+
+bool Pacer::Present() {
+    if (m_mode == Mode::RealTime || !m_frameskip)
+        return true;
+
+    // Faster than real time, one frame per 60 Hz refresh is enough
+    const Clock::time_point now = Clock::now();
+    if (now - m_lastPresent < FRAME_DURATION)
+        return false;
+
+    m_lastPresent = now;
+    return true;
+}
+
+double Pacer::achievedSpeed() const {
+    const Clock::time_point start{Clock::duration(m_start.load(std::memory_order_relaxed))};
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    if (seconds <= 0)
+        return 0;
+
+    return m_frames.load(std::memory_order_relaxed) / 60.0 / seconds;
+}
@@ -0,0 +1,189 @@
+#include "RamSearch.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHIP8_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+static int popCount(uint64_t word) {
+#ifdef _MSC_VER
+    return static_cast<int>(__popcnt64(word));
+#else
+    return __builtin_popcountll(word);
+#endif
+}
+
+static int lowestBit(uint64_t word) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+/**
+ * @brief Bit N set when byte N of the 64-byte blocks matches
+ */
+template <RamSearch::Comparison C>
+static uint64_t compareBlock(const uint8_t *current, const uint8_t *previous, uint8_t value) {
+    using Comparison = RamSearch::Comparison;
+
+    uint64_t mask = 0;
+
+#ifdef CHIP8_SSE2
+    const __m128i wanted = _mm_set1_epi8(static_cast<char>(value));
+
+    for (int i = 0; i < 4; ++i) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current + i * 16));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous + i * 16));
+
+        // SSE2 only compares signed bytes, unsigned order goes through min and max
+        __m128i match;
+        if (C == Comparison::Equal || C == Comparison::Changed)
+            match = _mm_cmpeq_epi8(a, b);
+        else if (C == Comparison::Increased)
+            match = _mm_andnot_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(_mm_max_epu8(a, b), a));
+        else if (C == Comparison::Decreased)
+            match = _mm_andnot_si128(_mm_cmpeq_epi8(a, b), _mm_cmpeq_epi8(_mm_min_epu8(a, b), a));
+        else
+            match = _mm_cmpeq_epi8(a, wanted);
+
+        uint64_t bits = static_cast<uint64_t>(_mm_movemask_epi8(match));
+        if (C == Comparison::Changed)
+            bits ^= 0xFFFF;
+
+        mask |= bits << (i * 16);
+    }
+#else
+    for (int i = 0; i < 64; ++i) {
+        bool match;
+        if (C == Comparison::Equal)
+            match = current[i] == previous[i];
+        else if (C == Comparison::Changed)
+            match = current[i] != previous[i];
+        else if (C == Comparison::Increased)
+            match = current[i] > previous[i];
+        else if (C == Comparison::Decreased)
+            match = current[i] < previous[i];
+        else
+            match = current[i] == value;
+
+        mask |= static_cast<uint64_t>(match) << i;
+    }
+#endif
+
+    return mask;
+}
+
+RamSearch::RamSearch(size_t instances)
+    : m_instances(std::max<size_t>(instances, 1)), m_previous(m_instances * MEMORY_SIZE), m_current(m_instances * MEMORY_SIZE) {
+    m_candidates.fill(~0ULL);
+}
+
+void RamSearch::Capture(size_t instance, const Chip8 &chip8) {
+    if (instance >= m_instances)
+        throw std::out_of_range("Not be able to capture instance " + std::to_string(instance) + "!");
+
+    chip8.Peek(0, &m_current[instance * MEMORY_SIZE], MEMORY_SIZE);
+}
+
+void RamSearch::Reset() {
+    m_candidates.fill(~0ULL);
+    m_previous.swap(m_current);
+}
+
+template <RamSearch::Comparison C>
+void RamSearch::Compare(size_t first, size_t last, uint8_t value, Bitmap &matches) const {
+    for (size_t instance = first; instance < last; ++instance) {
+        const uint8_t *current = &m_current[instance * MEMORY_SIZE];
+        const uint8_t *previous = &m_previous[instance * MEMORY_SIZE];
+
+        // Blocks without a candidate left are not compared
+        for (int word = 0; word < WORDS; ++word) {
+            if (matches[word])
+                matches[word] &= compareBlock<C>(current + word * 64, previous + word * 64, value);
+        }
+    }
+}
+
+void RamSearch::Filter(Comparison comparison, uint8_t value, ThreadPool *pool) {
+    const auto compare = [&](size_t first, size_t last, Bitmap &matches) {
+        switch (comparison) {
+            case Comparison::Equal: Compare<Comparison::Equal>(first, last, value, matches); break;
+            case Comparison::Changed: Compare<Comparison::Changed>(first, last, value, matches); break;
+            case Comparison::Increased: Compare<Comparison::Increased>(first, last, value, matches); break;
+            case Comparison::Decreased: Compare<Comparison::Decreased>(first, last, value, matches); break;
+            case Comparison::EqualTo: Compare<Comparison::EqualTo>(first, last, value, matches); break;
+        }
+    };
+
+    if (!pool || m_instances < 2) {
+        compare(0, m_instances, m_candidates);
+    } else {
+        // Each worker narrows its own copy of the candidates, then they are intersected
+        const size_t batch = std::max<size_t>(m_instances / (pool->size() * 4), 1);
+
+        std::mutex mutex;
+        Bitmap result = m_candidates;
+
+        for (size_t first = 0; first < m_instances; first += batch) {
+            pool->Submit([&, first]() {
+                Bitmap matches = m_candidates;
+                compare(first, std::min(first + batch, m_instances), matches);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                for (int word = 0; word < WORDS; ++word)
+                    result[word] &= matches[word];
+            });
+        }
+        pool->Wait();
+
+        m_candidates = result;
+    }
+
+    m_previous.swap(m_current);
+}
+
+RamSearch::Comparison RamSearch::ParseComparison(const std::string &name) {
+    if (name == "equal")
+        return Comparison::Equal;
+    if (name == "changed")
+        return Comparison::Changed;
+    if (name == "increased")
+        return Comparison::Increased;
+    if (name == "decreased")
+        return Comparison::Decreased;
+    if (name == "equal-to")
+        return Comparison::EqualTo;
+
+    throw std::invalid_argument("Unknown comparison: " + name + " (expected equal, changed, increased, decreased or equal-to).");
+}
+
+size_t RamSearch::count() const {
+    size_t count = 0;
+    for (uint64_t word : m_candidates)
+        count += popCount(word);
+    return count;
+}
+
+std::vector<uint16_t> RamSearch::addresses() const {
+    std::vector<uint16_t> addresses;
+    addresses.reserve(count());
+
+    for (int word = 0; word < WORDS; ++word) {
+        for (uint64_t bits = m_candidates[word]; bits; bits &= bits - 1)
+            addresses.push_back(static_cast<uint16_t>(word * 64 + lowestBit(bits)));
+    }
+
+    return addresses;
+}
@@ -2,6 +2,8 @@
 
 #include "Vertex.hpp"
 
+#include <cctype>
+#include <chrono>
 #include <cstring>
 
 static GLchar texture_vert_shader[] = {
@@ -12,7 +14,48 @@ static GLchar texture_frag_shader[] = {
     #include "Texture.frag.h"
 };
 
+const uint8_t *Renderer::Glyph(char c) {
+    static const uint8_t DIGITS[10][5] = {
+        {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+        {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7},
+    };
+
+    static const uint8_t LETTERS[26][5] = {
+        {2, 5, 7, 5, 5}, {6, 5, 6, 5, 6}, {3, 4, 4, 4, 3}, {6, 5, 5, 5, 6}, {7, 4, 6, 4, 7}, // A-E
+        {7, 4, 6, 4, 4}, {3, 4, 5, 5, 3}, {5, 5, 7, 5, 5}, {7, 2, 2, 2, 7}, {1, 1, 1, 5, 2}, // F-J
+        {5, 5, 6, 5, 5}, {4, 4, 4, 4, 7}, {5, 7, 7, 5, 5}, {6, 5, 5, 5, 5}, {2, 5, 5, 5, 2}, // K-O
+        {6, 5, 6, 4, 4}, {2, 5, 5, 6, 3}, {6, 5, 6, 5, 5}, {3, 4, 2, 1, 6}, {7, 2, 2, 2, 2}, // P-T
+        {5, 5, 5, 5, 7}, {5, 5, 5, 5, 2}, {5, 5, 7, 7, 5}, {5, 5, 2, 5, 5}, {5, 5, 2, 2, 2}, // U-Y
+        {7, 1, 2, 4, 7},                                                                     // Z
+    };
+
+    static const uint8_t DOT[5] = {0, 0, 0, 0, 2};
+    static const uint8_t COLON[5] = {0, 2, 0, 2, 0};
+    static const uint8_t SLASH[5] = {1, 1, 2, 4, 4};
+    static const uint8_t DASH[5] = {0, 0, 7, 0, 0};
+    static const uint8_t PERCENT[5] = {5, 1, 2, 4, 5};
+
+    if (c >= '0' && c <= '9')
+        return DIGITS[c - '0'];
+
+    c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    if (c >= 'A' && c <= 'Z')
+        return LETTERS[c - 'A'];
+
+    switch (c) {
+        case '.': return DOT;
+        case ':': return COLON;
+        case '/': return SLASH;
+        case '-': return DASH;
+        case '%': return PERCENT;
+        default:  return nullptr;
+    }
+}
+
 Renderer::Renderer() {
+    Clear();
+    memset(m_overlay, 0, sizeof(m_overlay));
+
     /* Load shaders */
 
     m_program.LoadShader(GL_VERTEX_SHADER, texture_vert_shader);
@@ -27,8 +70,27 @@ Renderer::Renderer() {
         glGenTextures(1, &m_texture);
         glBindTexture(GL_TEXTURE_2D, m_texture);
 
-        // Create a texture
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, GFX_COLS, GFX_ROWS, 0, GL_RED, GL_UNSIGNED_BYTE, gfx);
+        // Create an integer texture of the packed rows, a texel holds 8 pixels
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, GFX_COLS / 8, GFX_ROWS * PLANES, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_packed);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glUniform1i(glGetUniformLocation(shader, "uPlanes"), PLANES);
+        m_paletteLocation = glGetUniformLocation(shader, "uPalette");
+    }
+
+    // Overlay texture
+    {
+        glGenTextures(1, &m_overlayTexture);
+        glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, OVERLAY_COLS, OVERLAY_ROWS, 0, GL_RED, GL_UNSIGNED_BYTE, m_overlay);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -36,6 +98,10 @@ Renderer::Renderer() {
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
         glBindTexture(GL_TEXTURE_2D, 0);
+
+        glUniform1i(glGetUniformLocation(shader, "uOverlaySampler"), 1);
+        m_overlayLocation = glGetUniformLocation(shader, "uOverlay");
+        glUniform1i(m_overlayLocation, 0);
     }
 
     // VAO, VBO and IBO for a fullscreen quad
@@ -73,13 +139,80 @@ Renderer::Renderer() {
     }
 
     glUseProgram(0);
+
+    SetPalette(0x000000, 0xFFFFFF);
 }
 
 Renderer::~Renderer() {
     glDeleteTextures(1, &m_texture);
+    glDeleteTextures(1, &m_overlayTexture);
+}
+
+void Renderer::SetOverlay(const std::string &text) {
+    memset(m_overlay, 0, sizeof(m_overlay));
+    m_overlayVisible = !text.empty();
+
+    // Cells of 4x6 texels, the glyph and a blank column and row
+    int col = 1, row = 1;
+    for (char c : text) {
+        if (c == '\n') {
+            col = 1;
+            row += 6;
+            continue;
+        }
+
+        const uint8_t *rows = Glyph(c);
+        if (rows && col + 3 <= OVERLAY_COLS && row + 5 <= OVERLAY_ROWS) {
+            for (int y = 0; y < 5; ++y) {
+                for (int x = 0; x < 3; ++x)
+                    m_overlay[(row + y) * OVERLAY_COLS + col + x] = (rows[y] >> (2 - x)) & 1;
+            }
+        }
+
+        col += 4;
+    }
+
+    glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, OVERLAY_COLS, OVERLAY_ROWS, GL_RED, GL_UNSIGNED_BYTE, m_overlay);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void Renderer::Update(const Framebuffer &frame) {
+    using Clock = std::chrono::steady_clock;
+
+    frame.Pack(m_packed);
+
+    // The CPU time of the call, the driver may defer the actual work
+    const Clock::time_point start = Clock::now();
+
+    glBindTexture(GL_TEXTURE_2D, m_texture);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GFX_COLS / 8, GFX_ROWS * PLANES, GL_RED_INTEGER, GL_UNSIGNED_BYTE, m_packed);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (m_metrics)
+        m_metrics->uploadTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+void Renderer::SetPalette(uint32_t background, uint32_t foreground) {
+    // Every combination of the bitplanes, the pixels of a single plane use the first two
+    const uint32_t colours[4] = {background, foreground, foreground, foreground};
+
+    GLfloat palette[4 * 4];
+    for (int i = 0; i < 4; ++i) {
+        palette[i * 4 + 0] = ((colours[i] >> 16) & 0xFF) / 255.f;
+        palette[i * 4 + 1] = ((colours[i] >> 8) & 0xFF) / 255.f;
+        palette[i * 4 + 2] = (colours[i] & 0xFF) / 255.f;
+        palette[i * 4 + 3] = 1.f;
+    }
+
+    glUseProgram(m_program.GetProgram());
+    glUniform4fv(m_paletteLocation, 4, palette);
+    glUseProgram(0);
 }
 
 void Renderer::Display() const {
+    using Clock = std::chrono::steady_clock;
+
     GLuint shader = m_program.GetProgram();
     glUseProgram(shader);
 
@@ -89,28 +222,35 @@ void Renderer::Display() const {
         glClear(GL_COLOR_BUFFER_BIT);
     }
 
-    // Update texture
-    {
-        glBindTexture(GL_TEXTURE_2D, m_texture);
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GFX_COLS, GFX_ROWS, GL_RED, GL_UNSIGNED_BYTE, gfx);
-        glBindTexture(GL_TEXTURE_2D, 0);
-    }
+    // The CPU time of the calls, the driver may defer the actual work
+    const Clock::time_point start = Clock::now();
 
     // Draw quad
     {
         glActiveTexture(GL_TEXTURE0);
         glBindTexture(GL_TEXTURE_2D, m_texture);
 
+        glActiveTexture(GL_TEXTURE1);
+        glBindTexture(GL_TEXTURE_2D, m_overlayTexture);
+        glUniform1i(m_overlayLocation, m_overlayVisible);
+
         glBindVertexArray(m_vao);
         glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
         glBindVertexArray(0);
         
         glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+
+    if (m_metrics) {
+        m_metrics->drawTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        m_metrics->presentedFrames.Add();
     }
 
     glUseProgram(0);
 }
 
 void Renderer::Clear() {
-    memset(gfx, 0, sizeof(uint8_t) * GFX_ROWS * GFX_COLS);
+    memset(m_packed, 0, sizeof(m_packed));
 }
\ No newline at end of file
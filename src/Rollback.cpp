@@ -0,0 +1,221 @@
+#include "Rollback.hpp"
+#include "Hash.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+/*
+ * Datagram, little-endian:
+ *   0  magic "C8RB"
+ *   4  first frame of the keys            (u32)
+ *   8  number of frames of keys           (u16)
+ *  10  remote keys received, as an ack    (u32)
+ *  14  confirmed frame of the hash        (u32)
+ *  18  hash of the state before the frame (u64)
+ *  26  keys of each frame                 (u16 each)
+ */
+static const uint8_t MAGIC[4] = {'C', '8', 'R', 'B'};
+static const size_t HEADER_SIZE = 26;
+
+static void put16(uint8_t *p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+static void put32(uint8_t *p, uint32_t v) {
+    put16(p, static_cast<uint16_t>(v));
+    put16(p + 2, static_cast<uint16_t>(v >> 16));
+}
+
+static void put64(uint8_t *p, uint64_t v) {
+    put32(p, static_cast<uint32_t>(v));
+    put32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+static uint16_t get16(const uint8_t *p) { return static_cast<uint16_t>(p[0] | p[1] << 8); }
+static uint32_t get32(const uint8_t *p) { return get16(p) | static_cast<uint32_t>(get16(p + 2)) << 16; }
+static uint64_t get64(const uint8_t *p) { return get32(p) | static_cast<uint64_t>(get32(p + 4)) << 32; }
+
+// The first delay frames are emulated without local keys
+Rollback::Rollback(Chip8 &chip8, UdpLink &link, int cycles, uint32_t delay)
+    : m_chip8(chip8), m_link(link), m_cycles(cycles), m_delay(delay), m_localKnown(delay), m_rollbackFrom(0) {
+    if (delay > MAX_DELAY)
+        throw std::invalid_argument("The input delay must be at most " + std::to_string(MAX_DELAY) + " frames.");
+
+    m_packet.reserve(UdpLink::MAX_PACKET);
+}
+
+uint64_t Rollback::Hash(const Chip8State &state) {
+    // Field by field, the padding of the state is not initialized
+    uint8_t registers[16 + 2 * 3 + 2 + 32 + 1 + 4 + 1 + 2];
+    uint8_t *p = registers;
+    std::copy(state.V, state.V + 16, p);
+    put16(p + 16, state.I);
+    put16(p + 18, state.pc);
+    put16(p + 20, state.sp);
+    p[22] = state.delayTimer;
+    p[23] = state.soundTimer;
+    for (int i = 0; i < 16; ++i)
+        put16(p + 24 + 2 * i, state.stack[i]);
+    p[56] = state.drawFlag;
+    put32(p + 57, state.random);
+    p[61] = static_cast<uint8_t>(state.fault);
+    put16(p + 62, state.carriedCycles);
+
+    uint8_t screen[GFX_PACKED_SIZE];
+    state.gfx.Pack(screen);
+
+    uint64_t hash = Fnv1a(registers, sizeof(registers));
+    hash = Fnv1a(state.memory, sizeof(state.memory), hash);
+    return Fnv1a(screen, sizeof(screen), hash);
+}
+
+void Rollback::EmulateFrame(uint32_t frame) {
+    m_chip8.SaveState(m_states[frame % STATES]);
+
+    // Remote keys not received yet are predicted to be held
+    uint16_t remote = 0;
+    if (frame < m_remoteKnown)
+        remote = m_remote[frame % HISTORY];
+    else if (m_remoteKnown > 0)
+        remote = m_remote[(m_remoteKnown - 1) % HISTORY];
+    m_used[frame % HISTORY] = remote;
+
+    m_chip8.SetKeys(m_local[frame % HISTORY] | remote);
+    m_chip8.Run(m_cycles);
+    m_chip8.Tick();
+}
+
+void Rollback::Receive() {
+    m_rollbackFrom = m_frame;
+
+    while (m_link.Receive(m_packet)) {
+        if (m_packet.size() < HEADER_SIZE || !std::equal(MAGIC, MAGIC + 4, m_packet.begin()))
+            continue;
+
+        const uint8_t *p = m_packet.data();
+        const uint32_t first = get32(p + 4);
+        const uint32_t count = get16(p + 8);
+        if (m_packet.size() < HEADER_SIZE + 2 * count)
+            continue;
+
+        // Datagrams may arrive out of order, only the newest acknowledgement and hash matter
+        m_peerKnown = std::max(m_peerKnown, std::min(get32(p + 10), m_localKnown));
+
+        const uint32_t checkFrame = get32(p + 14);
+        if (!m_peerCheck || checkFrame > m_peerCheckFrame) {
+            m_peerCheck = true;
+            m_peerCheckFrame = checkFrame;
+            m_peerCheckHash = get64(p + 18);
+        }
+
+        // A gap is resent by the next datagrams, the peer resends everything not acknowledged
+        if (first > m_remoteKnown)
+            continue;
+
+        for (uint32_t frame = m_remoteKnown; frame < first + count; ++frame) {
+            const uint16_t keys = get16(p + HEADER_SIZE + 2 * (frame - first));
+            m_remote[frame % HISTORY] = keys;
+
+            if (frame < m_frame && keys != m_used[frame % HISTORY])
+                m_rollbackFrom = std::min(m_rollbackFrom, frame);
+        }
+        m_remoteKnown = std::max(m_remoteKnown, first + count);
+    }
+}
+
+void Rollback::Resimulate() {
+    if (m_rollbackFrom >= m_frame)
+        return;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Frames before m_remoteKnown get the received keys, the next a new prediction
+    m_chip8.LoadState(m_states[m_rollbackFrom % STATES]);
+    for (uint32_t frame = m_rollbackFrom; frame < m_frame; ++frame)
+        EmulateFrame(frame);
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    m_rollbackTime.Record(static_cast<uint64_t>(elapsed.count()));
+
+    const uint32_t depth = m_frame - m_rollbackFrom;
+    ++m_rollbacks;
+    m_resimulatedFrames += depth;
+    m_maxDepth = std::max(m_maxDepth, depth);
+    m_rollbackFrom = m_frame;
+}
+
+uint64_t Rollback::HashAt(uint32_t frame) {
+    if (frame == m_frame) {
+        m_chip8.SaveState(m_scratch);
+        return Hash(m_scratch);
+    }
+    return Hash(m_states[frame % STATES]);
+}
+
+void Rollback::Verify() {
+    // The newest state no later input can change
+    const uint32_t confirmed = confirmedFrame();
+    if (confirmed != m_checkFrame) {
+        m_checkFrame = confirmed;
+        m_checkHash = HashAt(confirmed);
+    }
+
+    // The peer's hash can be checked once the frame is confirmed here too, while its state is kept
+    if (!m_peerCheck || m_desynced || m_peerCheckFrame > confirmed || m_peerCheckFrame + MAX_ROLLBACK < m_frame)
+        return;
+
+    m_peerCheck = false;
+    m_desynced = HashAt(m_peerCheckFrame) != m_peerCheckHash;
+    m_verifiedFrame = m_desynced ? m_peerCheckFrame : std::max(m_verifiedFrame, m_peerCheckFrame);
+}
+
+void Rollback::Send() {
+    // Every local key the peer has not acknowledged
+    const uint32_t first = std::max(m_peerKnown, m_localKnown > HISTORY ? m_localKnown - HISTORY : 0);
+    const uint32_t count = m_localKnown - first;
+
+    uint8_t packet[HEADER_SIZE + 2 * HISTORY];
+    std::copy(MAGIC, MAGIC + 4, packet);
+    put32(packet + 4, first);
+    put16(packet + 8, static_cast<uint16_t>(count));
+    put32(packet + 10, m_remoteKnown);
+    put32(packet + 14, m_checkFrame);
+    put64(packet + 18, m_checkHash);
+    for (uint32_t i = 0; i < count; ++i)
+        put16(packet + HEADER_SIZE + 2 * i, m_local[(first + i) % HISTORY]);
+
+    m_link.Send(packet, HEADER_SIZE + 2 * count);
+}
+
+void Rollback::Poll() {
+    Receive();
+    Resimulate();
+    Verify();
+    Send();
+}
+
+bool Rollback::Advance(uint16_t keys) {
+    Receive();
+    Resimulate();
+
+    // Too far ahead of the peer to roll back, wait for its keys
+    if (m_frame >= m_remoteKnown + MAX_ROLLBACK) {
+        ++m_stalls;
+        Verify();
+        Send();
+        return false;
+    }
+
+    m_local[m_localKnown % HISTORY] = keys;
+    ++m_localKnown;
+
+    EmulateFrame(m_frame);
+    ++m_frame;
+
+    Verify();
+    Send();
+    return true;
+}
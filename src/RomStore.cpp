@@ -0,0 +1,209 @@
+#include "RomStore.hpp"
+
+#include "Const.hpp"
+#include "Hash.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+static void checkSize(const std::string &path, size_t size) {
+    if (size == 0) {
+        throw std::runtime_error("The game file " + path + " is empty!");
+    }
+
+    if (size > MAX_GAME_SIZE) {
+        throw std::length_error("The game file " + path + " is too large (" + std::to_string(size) + " bytes, at most " +
+                                std::to_string(MAX_GAME_SIZE) + ")!");
+    }
+}
+
+RomImage::RomImage(const std::string &path) : m_name(fs::path(path).filename().string()) {
+#ifndef _WIN32
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Not be able to read game file " + path + "!");
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("Not be able to read game file " + path + "!");
+    }
+
+    try {
+        checkSize(path, static_cast<size_t>(info.st_size));
+    } catch (...) {
+        close(fd);
+        throw;
+    }
+
+    m_size = static_cast<size_t>(info.st_size);
+    m_mapping = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (m_mapping == MAP_FAILED) {
+        m_mapping = nullptr;
+        throw std::runtime_error("Not be able to map game file " + path + "!");
+    }
+
+    m_data = static_cast<const uint8_t *>(m_mapping);
+#else
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Not be able to read game file " + path + "!");
+    }
+
+    m_copy.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    checkSize(path, m_copy.size());
+
+    m_size = m_copy.size();
+    m_data = m_copy.data();
+#endif
+
+    m_hash = Fnv1a(m_data, m_size);
+}
+
+RomImage::~RomImage() {
+#ifndef _WIN32
+    if (m_mapping)
+        munmap(m_mapping, m_size);
+#endif
+}
+
+std::shared_ptr<const RomImage> RomStore::Open(const std::string &path) {
+    std::error_code error;
+    fs::path key = fs::canonical(path, error);
+    if (error)
+        key = path;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto image = m_images.find(key.string());
+    if (image != m_images.end())
+        return image->second;
+
+    std::shared_ptr<const RomImage> opened = std::make_shared<RomImage>(path);
+    m_images.emplace(key.string(), opened);
+    return opened;
+}
+
+static int hexDigit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+static uint64_t parseHash(const std::string &hash, const std::string &where) {
+    if (hash.size() > 16) {
+        throw std::runtime_error(where + ": hash must have at most 16 hex digits, not " + hash);
+    }
+
+    uint64_t value = 0;
+    for (char c : hash) {
+        const int digit = hexDigit(c);
+        if (digit < 0) {
+            throw std::runtime_error(where + ": hash must have at most 16 hex digits, not " + hash);
+        }
+        value = value << 4 | static_cast<uint64_t>(digit);
+    }
+    return value;
+}
+
+static int parseCycles(const std::string &value, const std::string &where) {
+    // The whole value must be a number, "9x" is an error rather than 9
+    size_t end = 0;
+    int cycles = 0;
+    try {
+        cycles = std::stoi(value, &end);
+    } catch (const std::exception &) {
+        end = 0;
+    }
+
+    if (end == 0 || end != value.size() || cycles <= 0) {
+        throw std::runtime_error(where + ": cycles must be a positive integer, not " + value);
+    }
+    return cycles;
+}
+
+void RomStore::LoadDatabase(const std::string &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Not be able to read " + path + "!");
+    }
+
+    std::map<uint64_t, RomInfo> entries;
+
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        std::istringstream in(line.substr(0, line.find('#')));
+        const std::string where = path + ":" + std::to_string(number);
+
+        std::string hash;
+        if (!(in >> hash))
+            continue;
+        const uint64_t romHash = parseHash(hash, where);
+
+        RomInfo info;
+        if (!(in >> info.name)) {
+            throw std::runtime_error(where + ": missing ROM name");
+        }
+
+        std::string field;
+        while (in >> field) {
+            const size_t equal = field.find('=');
+            const std::string key = field.substr(0, equal);
+            const std::string value = equal == std::string::npos ? "" : field.substr(equal + 1);
+
+            if (key == "cycles") {
+                info.cycles = parseCycles(value, where);
+            } else if (key == "keymap") {
+                if (value.size() != 16) {
+                    throw std::runtime_error(where + ": keymap must have 16 hex digits");
+                }
+                for (int i = 0; i < 16; ++i) {
+                    const int digit = hexDigit(value[i]);
+                    if (digit < 0) {
+                        throw std::runtime_error(where + ": keymap must have 16 hex digits");
+                    }
+                    info.keymap[i] = static_cast<uint8_t>(digit);
+                }
+            } else if (key == "quirks") {
+                std::istringstream names(value);
+                std::string name;
+                while (std::getline(names, name, ','))
+                    info.quirks.push_back(name);
+            } else {
+                throw std::runtime_error(where + ": unknown field " + key);
+            }
+        }
+
+        entries[romHash] = info;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &entry : entries)
+        m_database[entry.first] = entry.second;
+}
+
+const RomInfo *RomStore::Lookup(uint64_t hash) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto info = m_database.find(hash);
+    return info != m_database.end() ? &info->second : nullptr;
+}
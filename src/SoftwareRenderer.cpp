@@ -0,0 +1,167 @@
+#include "SoftwareRenderer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define CHIP8_SSE2
+#endif
+
+static uint32_t toRGBA(uint32_t rgb) {
+    const uint8_t bytes[4] = {
+        static_cast<uint8_t>(rgb >> 16), // R
+        static_cast<uint8_t>(rgb >> 8),  // G
+        static_cast<uint8_t>(rgb),       // B
+        0xFF                             // A
+    };
+
+    uint32_t rgba;
+    memcpy(&rgba, bytes, sizeof(rgba));
+    return rgba;
+}
+
+SoftwareRenderer::SoftwareRenderer(int pixelSize, uint32_t background, uint32_t foreground)
+    : m_pixelSize(pixelSize), m_palette{toRGBA(background), toRGBA(foreground)} {
+    if (pixelSize < 1)
+        throw std::invalid_argument("The pixel size must be at least 1.");
+
+    m_pixels.resize(static_cast<size_t>(width()) * height(), m_palette[0]);
+}
+
+void SoftwareRenderer::Render(const Framebuffer &frame) {
+    const int w = width();
+
+    for (int y = 0; y < GFX_ROWS; ++y) {
+        uint32_t *row = &m_pixels[static_cast<size_t>(y) * m_pixelSize * w];
+
+        // Expand the source row horizontally
+        uint32_t *out = row;
+        for (int x = 0; x < GFX_COLS; ++x) {
+            const uint32_t colour = m_palette[frame[y * GFX_COLS + x] & 1];
+
+            int i = 0;
+#ifdef CHIP8_SSE2
+            const __m128i wide = _mm_set1_epi32(static_cast<int>(colour));
+            for (; i + 4 <= m_pixelSize; i += 4)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), wide);
+#endif
+            for (; i < m_pixelSize; ++i)
+                out[i] = colour;
+
+            out += m_pixelSize;
+        }
+
+        // Then duplicate it vertically
+        for (int i = 1; i < m_pixelSize; ++i)
+            memcpy(row + static_cast<size_t>(i) * w, row, sizeof(uint32_t) * w);
+    }
+}
+
+void SoftwareRenderer::WritePPM(const std::string &path) const {
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Not be able to write " + path + "!");
+    }
+
+    file << "P6\n" << width() << " " << height() << "\n255\n";
+
+    std::vector<uint8_t> rgb(m_pixels.size() * 3);
+    for (size_t i = 0; i < m_pixels.size(); ++i)
+        memcpy(&rgb[i * 3], &m_pixels[i], 3);
+
+    file.write(reinterpret_cast<const char *>(rgb.data()), rgb.size());
+}
+
+/* PNG encoding, with uncompressed deflate blocks so we do not depend on zlib */
+
+static uint32_t crc32(const uint8_t *data, size_t size, uint32_t crc = 0) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putU32(std::vector<uint8_t> &out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+static void writeChunk(std::ofstream &file, const char *type, const std::vector<uint8_t> &data) {
+    std::vector<uint8_t> chunk;
+    putU32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    putU32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+    file.write(reinterpret_cast<const char *>(chunk.data()), chunk.size());
+}
+
+void SoftwareRenderer::WritePNG(const std::string &path) const {
+    std::ofstream file(path, std::ios::out | std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Not be able to write " + path + "!");
+    }
+
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    file.write(reinterpret_cast<const char *>(signature), sizeof(signature));
+
+    // Header: 8-bit RGBA
+    std::vector<uint8_t> header;
+    putU32(header, width());
+    putU32(header, height());
+    header.insert(header.end(), {8, 6, 0, 0, 0});
+    writeChunk(file, "IHDR", header);
+
+    // Scanlines, each prefixed with filter type 0
+    const size_t stride = sizeof(uint32_t) * width();
+    std::vector<uint8_t> raw;
+    raw.reserve((stride + 1) * height());
+    for (int y = 0; y < height(); ++y) {
+        const uint8_t *row = reinterpret_cast<const uint8_t *>(&m_pixels[static_cast<size_t>(y) * width()]);
+        raw.push_back(0);
+        raw.insert(raw.end(), row, row + stride);
+    }
+
+    // Zlib stream made of stored blocks
+    std::vector<uint8_t> data = {0x78, 0x01};
+    uint32_t a = 1, b = 0;
+    for (size_t offset = 0; offset < raw.size();) {
+        const size_t size = std::min<size_t>(raw.size() - offset, 0xFFFF);
+        const bool last = offset + size == raw.size();
+
+        data.push_back(last ? 1 : 0);
+        data.push_back(size & 0xFF);
+        data.push_back(size >> 8);
+        data.push_back(~size & 0xFF);
+        data.push_back((~size >> 8) & 0xFF);
+
+        for (size_t i = offset; i < offset + size; ++i) {
+            a = (a + raw[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        data.insert(data.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    }
+    putU32(data, (b << 16) | a);
+    writeChunk(file, "IDAT", data);
+
+    writeChunk(file, "IEND", {});
+}
@@ -0,0 +1,35 @@
+#include "StartupTrace.hpp"
+
+#include <cstdio>
+
+StartupTrace::StartupTrace(std::ostream &out) : m_out(out), m_origin(Clock::now()) {}
+
+StartupTrace::Span::Span(StartupTrace *trace, const char *name) : m_trace(trace), m_name(name), m_start(Clock::now()) {}
+
+StartupTrace::Span::~Span() {
+    if (m_trace)
+        m_trace->Record(m_name, m_start, Clock::now());
+}
+
+static double milliseconds(StartupTrace::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void StartupTrace::Record(const char *name, Clock::time_point start, Clock::time_point end) {
+    char line[128];
+    snprintf(line, sizeof(line), "Startup : %8.2f ms -> %8.2f ms  %-20s %8.2f ms",
+             milliseconds(start - m_origin), milliseconds(end - m_origin), name, milliseconds(end - start));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_out << line << std::endl;
+}
+
+void StartupTrace::Mark(const char *name) {
+    const Clock::time_point now = Clock::now();
+
+    char line[128];
+    snprintf(line, sizeof(line), "Startup : %8.2f ms                 %s", milliseconds(now - m_origin), name);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_out << line << std::endl;
+}
@@ -0,0 +1,182 @@
+#include "StateExporter.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+/**
+ * @brief Process id of the live exporter of an existing segment, 0 if the segment is stale
+ */
+static pid_t ownerOf(const std::string &name) {
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+
+    // A segment too small for a header, or without the magic, was never finished by its exporter
+    pid_t owner = 0;
+    struct stat info;
+    if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedStateHeader)) {
+        void *base = mmap(nullptr, sizeof(SharedStateHeader), PROT_READ, MAP_SHARED, fd, 0);
+        if (base != MAP_FAILED) {
+            const SharedStateHeader *header = static_cast<const SharedStateHeader *>(base);
+            if (header->magic == SHARED_STATE_MAGIC && header->version == SHARED_STATE_VERSION)
+                owner = static_cast<pid_t>(header->owner);
+            munmap(base, sizeof(SharedStateHeader));
+        }
+    }
+    close(fd);
+
+    // EPERM: the process exists but belongs to another user
+    if (owner > 0 && kill(owner, 0) != 0 && errno != EPERM)
+        owner = 0;
+    return owner;
+}
+#endif
+
+StateExporter::StateExporter(const std::string &name, uint32_t instances, uint16_t memoryAddress, uint16_t memorySize)
+    : m_name(name) {
+    if (instances == 0 || memoryAddress > 0xFFF || memorySize > 0x1000 - memoryAddress) {
+        throw std::invalid_argument("Not be able to export " + std::to_string(memorySize) + " bytes of memory from " +
+                                    std::to_string(memoryAddress) + "!");
+    }
+
+    const uint32_t slotSize = SharedSlotSize(memorySize);
+    m_size = SHARED_STATE_SLOTS_OFFSET + static_cast<size_t>(slotSize) * instances;
+
+#ifdef _WIN32
+    m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(m_size >> 32),
+                                   static_cast<DWORD>(m_size), ("Local\\" + m_name).c_str());
+
+    // The mapping lives as long as a handle is open, so an existing one is still used by an exporter or a reader
+    const bool existed = m_mapping && GetLastError() == ERROR_ALREADY_EXISTS;
+    if (m_mapping && !existed)
+        m_base = static_cast<uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, m_size));
+
+    if (!m_base) {
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        if (existed)
+            throw std::runtime_error("Not be able to create the shared memory " + m_name + ", another process uses it!");
+        throw std::runtime_error("Not be able to create the shared memory " + m_name + "!");
+    }
+#else
+    // POSIX names start with a slash
+    if (m_name.empty() || m_name[0] != '/')
+        m_name = "/" + m_name;
+
+    // Never truncate an existing segment, the processes mapping it would get SIGBUS
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0 && errno == EEXIST) {
+        const pid_t owner = ownerOf(m_name);
+        if (owner != 0) {
+            throw std::runtime_error("Not be able to create the shared memory " + m_name + ", process " +
+                                     std::to_string(owner) + " exports it!");
+        }
+
+        // Left by a process that died: readers still attached keep the old segment
+        shm_unlink(m_name.c_str());
+        fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd < 0)
+        throw std::runtime_error("Not be able to create the shared memory " + m_name + "!");
+
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(m_size)) == 0)
+        base = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (base == MAP_FAILED) {
+        shm_unlink(m_name.c_str());
+        throw std::runtime_error("Not be able to map the shared memory " + m_name + "!");
+    }
+    m_base = static_cast<uint8_t *>(base);
+#endif
+
+    // The segment comes zeroed, slots start with an even sequence and no frame
+    m_header = reinterpret_cast<SharedStateHeader *>(m_base);
+    m_header->instances = instances;
+    m_header->slotSize = slotSize;
+    m_header->memoryAddress = memoryAddress;
+    m_header->memorySize = memorySize;
+    m_header->version = SHARED_STATE_VERSION;
+#ifdef _WIN32
+    m_header->owner = static_cast<uint32_t>(GetCurrentProcessId());
+#else
+    m_header->owner = static_cast<uint32_t>(getpid());
+#endif
+
+    // Readers check the magic last
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = SHARED_STATE_MAGIC;
+}
+
+StateExporter::~StateExporter() {
+#ifdef _WIN32
+    UnmapViewOfFile(m_base);
+    CloseHandle(m_mapping);
+#else
+    munmap(m_base, m_size);
+    shm_unlink(m_name.c_str());
+#endif
+}
+
+SharedSlot &StateExporter::Slot(uint32_t index) const {
+    return *reinterpret_cast<SharedSlot *>(m_base + SHARED_STATE_SLOTS_OFFSET + static_cast<size_t>(index) * m_header->slotSize);
+}
+
+void StateExporter::Publish(uint32_t index, const Chip8 &chip8, uint64_t frame) {
+    if (index >= m_header->instances)
+        throw std::out_of_range("Not be able to publish instance " + std::to_string(index) + "!");
+
+    SharedSlot &slot = Slot(index);
+
+    // Only the registers are saved, not the memory nor the screen
+    Chip8State registers;
+    chip8.SaveRegisters(registers);
+
+    // Odd while written, readers retry meanwhile
+    const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    SharedInstanceState &state = slot.state;
+    state.frame = frame;
+    memcpy(state.V, registers.V, sizeof(state.V));
+    state.I = registers.I;
+    state.pc = registers.pc;
+    state.opcode = static_cast<uint16_t>(chip8.Peek(registers.pc) << 8 | chip8.Peek(registers.pc + 1));
+    state.sp = registers.sp;
+    memcpy(state.stack, registers.stack, sizeof(state.stack));
+    state.keys = chip8.keys();
+    state.delayTimer = registers.delayTimer;
+    state.soundTimer = registers.soundTimer;
+    state.fault = static_cast<uint8_t>(registers.fault);
+    chip8.screen().Pack(state.screen);
+    chip8.Peek(m_header->memoryAddress, reinterpret_cast<uint8_t *>(&slot + 1), m_header->memorySize);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+std::pair<uint16_t, uint16_t> StateExporter::ParseRange(const std::string &range) {
+    const size_t comma = range.find(',');
+    if (comma == std::string::npos)
+        throw std::invalid_argument("The memory range must be given as ADDRESS,SIZE in hexadecimal (e.g. 200,E00).");
+
+    const unsigned long address = std::stoul(range.substr(0, comma), nullptr, 16);
+    const unsigned long size = std::stoul(range.substr(comma + 1), nullptr, 16);
+    if (address > 0xFFF || size > 0x1000 - address)
+        throw std::invalid_argument("The memory range " + range + " does not fit in the 4K of memory.");
+
+    return {static_cast<uint16_t>(address), static_cast<uint16_t>(size)};
+}
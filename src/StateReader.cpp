@@ -0,0 +1,115 @@
+#include "StateReader.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+StateReader::StateReader(const std::string &name) : m_name(name) {
+#ifdef _WIN32
+    m_mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, ("Local\\" + m_name).c_str());
+    if (m_mapping)
+        m_base = static_cast<const uint8_t *>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+
+    MEMORY_BASIC_INFORMATION info;
+    if (m_base && VirtualQuery(m_base, &info, sizeof(info)))
+        m_size = info.RegionSize;
+
+    if (!m_base) {
+        if (m_mapping)
+            CloseHandle(m_mapping);
+        throw std::runtime_error("Not be able to open the shared memory " + m_name + "!");
+    }
+#else
+    if (m_name.empty() || m_name[0] != '/')
+        m_name = "/" + m_name;
+
+    const int fd = shm_open(m_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw std::runtime_error("Not be able to open the shared memory " + m_name + "!");
+
+    struct stat status;
+    void *base = MAP_FAILED;
+    if (fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) >= sizeof(SharedStateHeader)) {
+        m_size = static_cast<size_t>(status.st_size);
+        base = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+
+    if (base == MAP_FAILED)
+        throw std::runtime_error("Not be able to map the shared memory " + m_name + "!");
+    m_base = static_cast<const uint8_t *>(base);
+#endif
+
+    m_header = reinterpret_cast<const SharedStateHeader *>(m_base);
+
+    // The magic is written last by the exporter
+    const bool ready = m_header->magic == SHARED_STATE_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (!ready || m_header->version != SHARED_STATE_VERSION ||
+        m_size < SHARED_STATE_SLOTS_OFFSET + static_cast<size_t>(m_header->slotSize) * m_header->instances) {
+        Detach();
+        throw std::runtime_error("Not be able to read the shared memory " + m_name + ", its layout is not version " +
+                                 std::to_string(SHARED_STATE_VERSION) + "!");
+    }
+}
+
+StateReader::~StateReader() {
+    Detach();
+}
+
+void StateReader::Detach() {
+#ifdef _WIN32
+    UnmapViewOfFile(m_base);
+    CloseHandle(m_mapping);
+#else
+    munmap(const_cast<uint8_t *>(m_base), m_size);
+#endif
+}
+
+const SharedSlot &StateReader::Slot(uint32_t index) const {
+    return *reinterpret_cast<const SharedSlot *>(m_base + SHARED_STATE_SLOTS_OFFSET +
+                                                 static_cast<size_t>(index) * m_header->slotSize);
+}
+
+uint32_t StateReader::sequence(uint32_t index) const {
+    return Slot(index).sequence.load(std::memory_order_acquire);
+}
+
+bool StateReader::Read(uint32_t index, Snapshot &snapshot, int maxRetries) const {
+    if (index >= m_header->instances)
+        throw std::out_of_range("Not be able to read instance " + std::to_string(index) + "!");
+
+    const SharedSlot &slot = Slot(index);
+    snapshot.memory.resize(m_header->memorySize);
+
+    for (int attempt = 0; attempt <= maxRetries; ++attempt) {
+        const uint32_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before & 1) {
+            // The writer is in the middle of the slot, it never holds it for long
+            std::this_thread::yield();
+            continue;
+        }
+
+        memcpy(&snapshot.state, &slot.state, sizeof(snapshot.state));
+        memcpy(snapshot.memory.data(), &slot + 1, snapshot.memory.size());
+
+        // The copies must complete before the sequence is checked again
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before) {
+            snapshot.sequence = before;
+            return true;
+        }
+    }
+
+    return false;
+}
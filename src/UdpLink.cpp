@@ -0,0 +1,156 @@
+#include "UdpLink.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#define poll WSAPoll
+
+static void closeSocket(UdpLink::Socket socket) { closesocket(socket); }
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static void closeSocket(UdpLink::Socket socket) { close(socket); }
+#endif
+
+static const UdpLink::Socket NO_SOCKET = static_cast<UdpLink::Socket>(-1);
+
+static sockaddr_in loopback(uint16_t port) {
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(port);
+    return address;
+}
+
+UdpLink::UdpLink(uint16_t port, uint16_t peerPort) : m_socket(NO_SOCKET), m_peerPort(peerPort) {
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0) {
+        throw std::runtime_error("Not be able to initialize the sockets!");
+    }
+#endif
+
+    m_socket = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in address = loopback(port);
+    if (m_socket == NO_SOCKET || bind(m_socket, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0) {
+        if (m_socket != NO_SOCKET)
+            closeSocket(m_socket);
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        throw std::runtime_error("Not be able to bind the UDP port " + std::to_string(port) + "!");
+    }
+
+    // Receive never blocks, Wait does
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(m_socket, FIONBIO, &nonBlocking);
+#else
+    fcntl(m_socket, F_SETFL, fcntl(m_socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+}
+
+UdpLink::~UdpLink() {
+    closeSocket(m_socket);
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void UdpLink::SetConditions(const Conditions &conditions) {
+    if (conditions.latency < 0 || conditions.jitter < 0 || conditions.loss < 0 || conditions.loss > 1)
+        throw std::invalid_argument("The latency and the jitter must be positive, and the loss between 0 and 1.");
+
+    m_conditions = conditions;
+    m_random = conditions.seed ? conditions.seed : 1;
+}
+
+double UdpLink::NextRandom() {
+    // xorshift32, as the core
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return m_random / 4294967296.0;
+}
+
+void UdpLink::SendNow(const uint8_t *data, size_t size) {
+    const sockaddr_in peer = loopback(m_peerPort);
+
+    // A peer not started yet or gone is a lost datagram, as on a real network
+    sendto(m_socket, reinterpret_cast<const char *>(data), static_cast<int>(size), 0,
+           reinterpret_cast<const sockaddr *>(&peer), sizeof(peer));
+    ++m_sent;
+}
+
+void UdpLink::Send(const uint8_t *data, size_t size) {
+    Flush();
+
+    if (m_conditions.loss > 0 && NextRandom() < m_conditions.loss) {
+        ++m_dropped;
+        return;
+    }
+
+    const double delay = m_conditions.latency + (m_conditions.jitter > 0 ? NextRandom() * m_conditions.jitter : 0);
+    if (delay <= 0) {
+        SendNow(data, size);
+        return;
+    }
+
+    const Clock::duration hold = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(delay));
+    m_pending.push_back({Clock::now() + hold, std::vector<uint8_t>(data, data + size)});
+}
+
+void UdpLink::Flush() {
+    const Clock::time_point now = Clock::now();
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->due <= now) {
+            SendNow(it->data.data(), it->data.size());
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+bool UdpLink::Receive(std::vector<uint8_t> &packet) {
+    Flush();
+
+    packet.resize(MAX_PACKET);
+    const auto size = recv(m_socket, reinterpret_cast<char *>(packet.data()), static_cast<int>(packet.size()), 0);
+    if (size <= 0) {
+        packet.clear();
+        return false;
+    }
+
+    packet.resize(static_cast<size_t>(size));
+    ++m_received;
+    return true;
+}
+
+void UdpLink::Wait(int timeout) {
+    // Wake up in time to send the next held datagram
+    if (!m_pending.empty()) {
+        const Clock::time_point due = std::min_element(m_pending.begin(), m_pending.end(), [](const Pending &a, const Pending &b) {
+                                          return a.due < b.due;
+                                      })->due;
+        const auto until = std::chrono::duration_cast<std::chrono::milliseconds>(due - Clock::now()).count();
+        timeout = static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(timeout, until + 1)));
+    }
+
+    pollfd socket = {m_socket, POLLIN, 0};
+    poll(&socket, 1, timeout);
+
+    Flush();
+}
@@ -0,0 +1,69 @@
+#include "VideoReader.hpp"
+
+#include "VideoRecorder.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+static bool getVarint(std::ifstream &file, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int byte = file.get();
+        if (byte == EOF)
+            return false;
+
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+VideoReader::VideoReader(const std::string &path) : m_file(path, std::ios::in | std::ios::binary) {
+    if (!m_file) {
+        throw std::runtime_error("Not be able to read video file " + path + "!");
+    }
+
+    char magic[sizeof(VideoRecorder::MAGIC)];
+    m_file.read(magic, sizeof(magic));
+    if (!m_file || memcmp(magic, VideoRecorder::MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error(path + " is not a Chip8 video!");
+    }
+
+    if (m_file.get() != VideoRecorder::VERSION) {
+        throw std::runtime_error(path + " has an unsupported video version!");
+    }
+}
+
+bool VideoReader::Next(Framebuffer &frame, uint64_t &number) {
+    uint64_t delta, size;
+    if (!getVarint(m_file, delta) || !getVarint(m_file, size))
+        return false;
+
+    int offset = 0;
+    for (uint64_t read = 0; read < size;) {
+        const int control = m_file.get();
+        if (control == EOF)
+            throw std::runtime_error("Truncated video record!");
+        ++read;
+
+        const int run = (control & 0x7F) + 1;
+        if (offset + run > GFX_PACKED_SIZE)
+            throw std::runtime_error("Corrupted video record!");
+
+        if (!(control & 0x80)) {
+            for (int i = 0; i < run; ++i)
+                m_packed[offset + i] ^= static_cast<uint8_t>(m_file.get());
+            read += run;
+        }
+        offset += run;
+    }
+
+    if (!m_file)
+        throw std::runtime_error("Truncated video record!");
+
+    m_number += delta;
+    number = m_number;
+    frame.Unpack(m_packed);
+    return true;
+}
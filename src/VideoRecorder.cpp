@@ -0,0 +1,109 @@
+#include "VideoRecorder.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+static void putVarint(std::vector<uint8_t> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+VideoRecorder::VideoRecorder(const std::string &path) : m_file(path, std::ios::out | std::ios::binary) {
+    if (!m_file) {
+        throw std::runtime_error("Not be able to write video file " + path + "!");
+    }
+
+    m_file.write(MAGIC, sizeof(MAGIC));
+    m_file.put(static_cast<char>(VERSION));
+
+    m_thread = std::thread(&VideoRecorder::Run, this);
+}
+
+VideoRecorder::~VideoRecorder() {
+    m_running = false;
+    m_wakeUp.notify_one();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+void VideoRecorder::Push(const Framebuffer &frame, uint64_t number) {
+    while (!m_queue.Push({number, frame})) {
+        if (!m_lossless) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        m_wakeUp.notify_one();
+        std::this_thread::yield();
+    }
+
+    m_wakeUp.notify_one();
+}
+
+void VideoRecorder::Run() {
+    Item item;
+
+    for (;;) {
+        while (m_queue.Pop(item))
+            Encode(item);
+
+        if (!m_running.load())
+            break;
+
+        // The producer does not take the lock, so a notification can be missed: bound the wait
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeUp.wait_for(lock, std::chrono::milliseconds(10));
+    }
+
+    // Frames pushed before the recorder was stopped
+    while (m_queue.Pop(item))
+        Encode(item);
+
+    m_file.flush();
+}
+
+void VideoRecorder::Encode(const Item &item) {
+    uint8_t packed[GFX_PACKED_SIZE];
+    item.frame.Pack(packed);
+
+    uint8_t delta[GFX_PACKED_SIZE];
+    for (int i = 0; i < GFX_PACKED_SIZE; ++i)
+        delta[i] = packed[i] ^ m_previous[i];
+
+    // Run-length code the delta: runs of zeros, and literal runs of anything else
+    std::vector<uint8_t> payload;
+    for (int i = 0; i < GFX_PACKED_SIZE;) {
+        int run = 0;
+        while (i + run < GFX_PACKED_SIZE && delta[i + run] == 0 && run < 0x80)
+            ++run;
+
+        if (run > 0) {
+            payload.push_back(0x80 | (run - 1));
+            i += run;
+            continue;
+        }
+
+        while (i + run < GFX_PACKED_SIZE && delta[i + run] != 0 && run < 0x80)
+            ++run;
+
+        payload.push_back(run - 1);
+        payload.insert(payload.end(), delta + i, delta + i + run);
+        i += run;
+    }
+
+    std::vector<uint8_t> record;
+    putVarint(record, item.number - m_previousNumber);
+    putVarint(record, payload.size());
+    record.insert(record.end(), payload.begin(), payload.end());
+
+    m_file.write(reinterpret_cast<const char *>(record.data()), record.size());
+
+    memcpy(m_previous, packed, sizeof(packed));
+    m_previousNumber = item.number;
+}
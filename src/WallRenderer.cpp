@@ -0,0 +1,320 @@
+#include "WallRenderer.hpp"
+
+#include "Renderer.hpp"
+#include "Vertex.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+static GLchar wall_vert_shader[] = {
+    #include "Wall.vert.h"
+};
+
+static GLchar wall_frag_shader[] = {
+    #include "Wall.frag.h"
+};
+
+WallRenderer::WallRenderer(int tiles)
+    : m_tiles(tiles),
+      m_layers(static_cast<size_t>(std::max(tiles, 0)) * LAYER_SIZE),
+      m_dirty(std::max(tiles, 0), 1),
+      m_dirtyCount(tiles),
+      m_status(std::max(tiles, 0), RUNNING) {
+    if (tiles < 1 || tiles > MAX_TILES)
+        throw std::out_of_range("The wall shows from 1 to " + std::to_string(MAX_TILES) + " instances!");
+
+    /* Load shaders */
+
+    m_program.LoadShader(GL_VERTEX_SHADER, wall_vert_shader);
+    m_program.LoadShader(GL_FRAGMENT_SHADER, wall_frag_shader);
+    m_program.Create();
+
+    GLuint shader = m_program.GetProgram();
+    glUseProgram(shader);
+
+    // Texture array, a layer per tile, a texel holds 8 pixels
+    {
+        glGenTextures(1, &m_texture);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+        // Undefined until the first Upload, which writes every layer
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_R8UI, GFX_COLS / 8, LAYER_ROWS, tiles);
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        glUniform1i(glGetUniformLocation(shader, "uTiles"), 0);
+        m_gridLocation = glGetUniformLocation(shader, "uGrid");
+        m_paletteLocation = glGetUniformLocation(shader, "uPalette");
+    }
+
+    // Pixel buffer, written by the CPU through a mapping kept for the lifetime of the renderer
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = static_cast<GLsizeiptr>(RING) * tiles * LAYER_SIZE;
+
+        glGenBuffers(1, &m_pixelBuffer);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+        glBufferStorage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        m_mapped = static_cast<uint8_t *>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        if (!m_mapped)
+            throw std::runtime_error("Not be able to map the pixel buffer of the wall!");
+    }
+
+    // VAO, VBO and IBO of a unit quad, placed in its cell of the grid by the vertex shader
+    {
+        const Vertex vertices[4] = {
+            Vertex(glm::vec2(0.0f, 0.0f), glm::vec2(0.0f, 0.0f)), // Top-left
+            Vertex(glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 0.0f)), // Top-right
+            Vertex(glm::vec2(1.0f, 1.0f), glm::vec2(1.0f, 1.0f)), // Bottom-right
+            Vertex(glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 1.0f)), // Bottom-left
+        };
+
+        const GLuint elements[6] = {
+            0, 1, 2, // first triangle
+            2, 3, 0  // second triangle
+        };
+
+        glGenVertexArrays(1, &m_vao);
+        glBindVertexArray(m_vao);
+
+        glGenBuffers(1, &m_vbo);
+        glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * 4, &vertices[0], GL_STATIC_DRAW);
+
+        glGenBuffers(1, &m_ibo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_ibo);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * 6, &elements[0], GL_STATIC_DRAW);
+
+        Vertex::SetAttribute(shader);
+
+        // Status of each tile, one value per instance of the quad
+        glGenBuffers(1, &m_statusBuffer);
+        glBindBuffer(GL_ARRAY_BUFFER, m_statusBuffer);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(uint32_t) * tiles, m_status.data(), GL_DYNAMIC_DRAW);
+
+        const GLint statusLocation = glGetAttribLocation(shader, "aStatus");
+        glEnableVertexAttribArray(statusLocation);
+        glVertexAttribIPointer(statusLocation, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr);
+        glVertexAttribDivisor(statusLocation, 1);
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    glUseProgram(0);
+
+    SetPalette(0x000000, 0xFFFFFF);
+}
+
+WallRenderer::~WallRenderer() {
+    for (GLsync fence : m_fences) {
+        if (fence)
+            glDeleteSync(fence);
+    }
+
+    // Deleting the pixel buffer unmaps it
+    const GLuint buffers[4] = {m_pixelBuffer, m_vbo, m_ibo, m_statusBuffer};
+    glDeleteBuffers(4, buffers);
+    glDeleteVertexArrays(1, &m_vao);
+    glDeleteTextures(1, &m_texture);
+}
+
+void WallRenderer::SetScreen(int tile, const uint8_t packed[GFX_PACKED_SIZE]) {
+    uint8_t *layer = Layer(tile);
+    if (memcmp(layer, packed, GFX_PACKED_SIZE) == 0)
+        return;
+
+    memcpy(layer, packed, GFX_PACKED_SIZE);
+    if (!m_dirty[tile]) {
+        m_dirty[tile] = 1;
+        ++m_dirtyCount;
+    }
+}
+
+void WallRenderer::SetLabel(int tile, const std::string &text) {
+    // Glyphs in cells of 4x6 pixels, from (1, 1), with the bits packed like the screen
+    uint8_t label[GFX_COLS / 8 * LABEL_ROWS] = {};
+    const int chars = std::min(static_cast<int>(text.size()), LABEL_CHARS);
+    for (int i = 0; i < chars; ++i) {
+        const uint8_t *rows = Renderer::Glyph(text[i]);
+        if (!rows)
+            continue;
+
+        for (int y = 0; y < 5; ++y) {
+            for (int x = 0; x < 3; ++x) {
+                const int col = 1 + i * 4 + x;
+                if (col < GFX_COLS && ((rows[y] >> (2 - x)) & 1))
+                    label[(1 + y) * (GFX_COLS / 8) + col / 8] |= 0x80 >> (col % 8);
+            }
+        }
+    }
+
+    uint8_t *layer = Layer(tile) + GFX_PACKED_SIZE;
+    if (memcmp(layer, label, sizeof(label)) == 0)
+        return;
+
+    memcpy(layer, label, sizeof(label));
+    if (!m_dirty[tile]) {
+        m_dirty[tile] = 1;
+        ++m_dirtyCount;
+    }
+}
+
+void WallRenderer::SetStatus(int tile, uint32_t status) {
+    if (m_status[tile] != status) {
+        m_status[tile] = status;
+        m_statusDirty = true;
+    }
+}
+
+void WallRenderer::SetPalette(uint32_t background, uint32_t foreground) {
+    const uint32_t colours[2] = {background, foreground};
+
+    GLfloat palette[2 * 4];
+    for (int i = 0; i < 2; ++i) {
+        palette[i * 4 + 0] = ((colours[i] >> 16) & 0xFF) / 255.f;
+        palette[i * 4 + 1] = ((colours[i] >> 8) & 0xFF) / 255.f;
+        palette[i * 4 + 2] = (colours[i] & 0xFF) / 255.f;
+        palette[i * 4 + 3] = 1.f;
+    }
+
+    glUseProgram(m_program.GetProgram());
+    glUniform4fv(m_paletteLocation, 2, palette);
+    glUseProgram(0);
+}
+
+bool WallRenderer::Upload() {
+    using Clock = std::chrono::steady_clock;
+
+    if (m_dirtyCount == 0 && !m_statusDirty)
+        return false;
+
+    const Clock::time_point start = Clock::now();
+
+    if (m_statusDirty) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_statusBuffer);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(uint32_t) * m_tiles, m_status.data());
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        m_statusDirty = false;
+    }
+
+    if (m_dirtyCount > 0) {
+        // The region was last used RING uploads ago, its copy is almost always done by now
+        GLsync &fence = m_fences[m_region];
+        if (fence) {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        const size_t regionOffset = static_cast<size_t>(m_region) * m_tiles * LAYER_SIZE;
+        uint8_t *region = m_mapped + regionOffset;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+        // The changed tiles are staged one after the other, each run of consecutive tiles is a single copy
+        int staged = 0;
+        for (int tile = 0; tile < m_tiles;) {
+            if (!m_dirty[tile]) {
+                ++tile;
+                continue;
+            }
+
+            const int first = tile;
+            const size_t offset = regionOffset + static_cast<size_t>(staged) * LAYER_SIZE;
+            while (tile < m_tiles && m_dirty[tile]) {
+                memcpy(region + static_cast<size_t>(staged) * LAYER_SIZE, Layer(tile), LAYER_SIZE);
+                m_dirty[tile] = 0;
+                ++staged;
+                ++tile;
+            }
+
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, first, GFX_COLS / 8, LAYER_ROWS, tile - first, GL_RED_INTEGER,
+                            GL_UNSIGNED_BYTE, reinterpret_cast<const void *>(offset));
+        }
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        m_region = (m_region + 1) % RING;
+        m_dirtyCount = 0;
+    }
+
+    if (m_metrics)
+        m_metrics->uploadTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+
+    return true;
+}
+
+void WallRenderer::Display(int width, int height) const {
+    using Clock = std::chrono::steady_clock;
+
+    // Tiles are the screen and a border of one pixel around it
+    const float tileWidth = GFX_COLS + 2;
+    const float tileHeight = GFX_ROWS + 2;
+
+    // Number of columns giving the largest tiles
+    int columns = 1;
+    float scale = 0.f;
+    for (int c = 1; c <= m_tiles; ++c) {
+        const int rows = (m_tiles + c - 1) / c;
+        const float s = std::min(width / (c * tileWidth), height / (rows * tileHeight));
+        if (s > scale) {
+            scale = s;
+            columns = c;
+        }
+    }
+    const int rows = (m_tiles + columns - 1) / columns;
+
+    GLuint shader = m_program.GetProgram();
+    glUseProgram(shader);
+
+    {
+        // Clear the screen
+        glViewport(0, 0, width, height);
+        glClearColor(0.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+    }
+
+    // The CPU time of the calls, the driver may defer the actual work
+    const Clock::time_point start = Clock::now();
+
+    // Draw every tile at once, centred
+    {
+        const int gridWidth = static_cast<int>(columns * tileWidth * scale);
+        const int gridHeight = static_cast<int>(rows * tileHeight * scale);
+        glViewport((width - gridWidth) / 2, (height - gridHeight) / 2, gridWidth, gridHeight);
+        glUniform2i(m_gridLocation, columns, rows);
+
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, m_texture);
+
+        glBindVertexArray(m_vao);
+        glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, m_tiles);
+        glBindVertexArray(0);
+
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+        glViewport(0, 0, width, height);
+    }
+
+    if (m_metrics) {
+        m_metrics->drawTime.Record(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        m_metrics->presentedFrames.Add();
+    }
+
+    glUseProgram(0);
+}
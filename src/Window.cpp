@@ -7,15 +7,21 @@
 
 Window::Window() : m_window(nullptr) {}
 
-Window::Window(int width, int height, const char *title) : Window() {
+Window::Window(int width, int height, const char *title, StartupTrace *trace) : Window() {
   // Initialize the library
-  if (!glfwInit())
-    throw std::runtime_error("We cannot initialize GLFW!");
+  {
+    StartupTrace::Span span(trace, "glfwInit");
+    if (!glfwInit())
+      throw std::runtime_error("We cannot initialize GLFW!");
+  }
 
   // Create a windowed mode window and its OpenGL context
-  m_window = glfwCreateWindow(width, height, title, NULL, NULL);
-  if (!m_window) {
-    throw std::runtime_error("We cannot create GLFW Window!");
+  {
+    StartupTrace::Span span(trace, "window creation");
+    m_window = glfwCreateWindow(width, height, title, NULL, NULL);
+    if (!m_window) {
+      throw std::runtime_error("We cannot create GLFW Window!");
+    }
   }
 
   // Make the window's context current
@@ -24,12 +30,16 @@ Window::Window(int width, int height, const char *title) : Window() {
   /* Initialize OpenGL */
 
   {
+    StartupTrace::Span span(trace, "glewInit");
     GLenum error = glewInit();
 
     if (error != GLEW_OK) {
       throw std::runtime_error("We cannot initialize GLEW!");
     }
+  }
 
+  {
+    StartupTrace::Span span(trace, "driver strings");
     std::cout << "  Version : " << glGetString(GL_VERSION) << std::endl;
     std::cout << "   Vendor : " << glGetString(GL_VENDOR) << std::endl;
     std::cout << " Renderer : " << glGetString(GL_RENDERER) << std::endl;
@@ -47,9 +57,18 @@ Window::~Window() {
 void Window::OnKey(GLFWwindow *window, int key, int scancode, int action, int mods) {
   Context *context = static_cast<Context *>(glfwGetWindowUserPointer(window));
 
+  if (action == GLFW_PRESS && key == GLFW_KEY_ESCAPE)
+    glfwSetWindowShouldClose(window, 1);
+
+  // Nothing else to do without an emulator, e.g. on the monitoring wall
+  if (!context)
+    return;
+
   if (action == GLFW_PRESS) {
-    if (key == GLFW_KEY_ESCAPE) {
-      glfwSetWindowShouldClose(window, 1);
+    if (key == GLFW_KEY_F12) {
+      context->requestScreenshot();
+    } else if (key == GLFW_KEY_F3) {
+      context->toggleOverlay();
     }
 
     context->keyDown(key);
@@ -58,14 +77,24 @@ void Window::OnKey(GLFWwindow *window, int key, int scancode, int action, int mo
   }
 }
 
+void Window::Wake() {
+  glfwPostEmptyEvent();
+}
+
 void Window::mainLoop() {
   while (!glfwWindowShouldClose(m_window)) {
-    m_drawFrameFunc();
-
-    // Swap front and back buffers
-    glfwSwapBuffers(m_window);
-
-    // Poll for and process events
-    glfwPollEvents();
+    // The back buffer is undefined after a resize, draw it again even without a new frame
+    int width, height;
+    glfwGetFramebufferSize(m_window, &width, &height);
+    const bool resized = width != m_width || height != m_height;
+    m_width = width;
+    m_height = height;
+
+    // Swap front and back buffers, only when something new was drawn
+    if (m_drawFrameFunc(resized))
+      glfwSwapBuffers(m_window);
+
+    // Sleep until an event, a wake up or the timeout
+    glfwWaitEventsTimeout(m_waitTimeout);
   }
 }
\ No newline at end of file
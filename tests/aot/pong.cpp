@@ -0,0 +1,555 @@
+// Translated by chip8-aot from pong.ch8, do not edit
+//
+// 117 instructions in 47 blocks, 0 computed jumps, 0 self-modifying writes
+
+#include "Aot.hpp"
+#include "Const.hpp"
+
+namespace {
+
+const uint8_t IMAGE[] = {
+    0x6A, 0x02, 0x6B, 0x0C, 0x6C, 0x3F, 0x6D, 0x0C, 0xA2, 0xEA, 0xDA, 0xB6,
+    0xDC, 0xD6, 0x6E, 0x00, 0x22, 0xD4, 0x66, 0x03, 0x68, 0x02, 0x60, 0x60,
+    0xF0, 0x15, 0xF0, 0x07, 0x30, 0x00, 0x12, 0x1A, 0xC7, 0x17, 0x77, 0x08,
+    0x69, 0xFF, 0xA2, 0xF0, 0xD6, 0x71, 0xA2, 0xEA, 0xDA, 0xB6, 0xDC, 0xD6,
+    0x60, 0x01, 0xE0, 0xA1, 0x7B, 0xFE, 0x60, 0x04, 0xE0, 0xA1, 0x7B, 0x02,
+    0x60, 0x1F, 0x8B, 0x02, 0xDA, 0xB6, 0x8D, 0x70, 0xC0, 0x0A, 0x7D, 0xFE,
+    0x40, 0x00, 0x7D, 0x02, 0x60, 0x00, 0x60, 0x1F, 0x8D, 0x02, 0xDC, 0xD6,
+    0xA2, 0xF0, 0xD6, 0x71, 0x86, 0x84, 0x87, 0x94, 0x60, 0x3F, 0x86, 0x02,
+    0x61, 0x1F, 0x87, 0x12, 0x46, 0x02, 0x12, 0x78, 0x46, 0x3F, 0x12, 0x82,
+    0x47, 0x1F, 0x69, 0xFF, 0x47, 0x00, 0x69, 0x01, 0xD6, 0x71, 0x12, 0x2A,
+    0x68, 0x02, 0x63, 0x01, 0x80, 0x70, 0x80, 0xB5, 0x12, 0x8A, 0x68, 0xFE,
+    0x63, 0x0A, 0x80, 0x70, 0x80, 0xD5, 0x3F, 0x01, 0x12, 0xA2, 0x61, 0x02,
+    0x80, 0x15, 0x3F, 0x01, 0x12, 0xBA, 0x80, 0x15, 0x3F, 0x01, 0x12, 0xC8,
+    0x80, 0x15, 0x3F, 0x01, 0x12, 0xC2, 0x60, 0x20, 0xF0, 0x18, 0x22, 0xD4,
+    0x8E, 0x34, 0x22, 0xD4, 0x66, 0x3E, 0x33, 0x01, 0x66, 0x03, 0x68, 0xFE,
+    0x33, 0x01, 0x68, 0x02, 0x12, 0x16, 0x79, 0xFF, 0x49, 0xFE, 0x69, 0xFF,
+    0x12, 0xC8, 0x79, 0x01, 0x49, 0x02, 0x69, 0x01, 0x60, 0x04, 0xF0, 0x18,
+    0x76, 0x01, 0x46, 0x40, 0x76, 0xFE, 0x12, 0x6C, 0xA2, 0xF2, 0xFE, 0x33,
+    0xF2, 0x65, 0xF1, 0x29, 0x64, 0x14, 0x65, 0x00, 0xD4, 0x55, 0x74, 0x15,
+    0xF2, 0x29, 0xD4, 0x55, 0x00, 0xEE, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+    0x80, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+const uint8_t CODE[512] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03
+};
+
+int run(Chip8 &chip8, int budget) {
+    AotMachine m(chip8);
+    AotRegisters r = m.Load();
+    int executed = 0;
+
+dispatch:
+    // Entering in the middle of a block, the code of pc may have been overwritten since
+    if (m.modified(static_cast<uint16_t>(3 << ((r.pc >> 8) & 0xF))))
+        goto leave;
+
+    switch (r.pc) {
+    case 0x200: // 0x6A02  LD VA, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x200; goto leave; }
+        r.V[0xA] = 0x02;
+        if (++executed == budget) { r.pc = 0x202; goto leave; }
+    case 0x202: // 0x6B0C  LD VB, 0x0C
+        r.V[0xB] = 0x0C;
+        if (++executed == budget) { r.pc = 0x204; goto leave; }
+    case 0x204: // 0x6C3F  LD VC, 0x3F
+        r.V[0xC] = 0x3F;
+        if (++executed == budget) { r.pc = 0x206; goto leave; }
+    case 0x206: // 0x6D0C  LD VD, 0x0C
+        r.V[0xD] = 0x0C;
+        if (++executed == budget) { r.pc = 0x208; goto leave; }
+    case 0x208: // 0xA2EA  LD I, 0x2EA
+        r.I = 0x2EA;
+        if (++executed == budget) { r.pc = 0x20A; goto leave; }
+    case 0x20A: // 0xDAB6  DRW VA, VB, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xA], r.V[0xB], 6);
+        if (++executed == budget) { r.pc = 0x20C; goto leave; }
+    case 0x20C: // 0xDCD6  DRW VC, VD, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xC], r.V[0xD], 6);
+        if (++executed == budget) { r.pc = 0x20E; goto leave; }
+    case 0x20E: // 0x6E00  LD VE, 0x00
+        r.V[0xE] = 0x00;
+        if (++executed == budget) { r.pc = 0x210; goto leave; }
+    case 0x210: // 0x22D4  CALL 0x2D4
+        if (r.sp == 16) {
+            r.pc = 0x210;
+            m.Fault(Fault::StackOverflow);
+            goto leave;
+        }
+        m.stack()[r.sp++] = 0x212;
+        if (++executed == budget) { r.pc = 0x2D4; goto leave; }
+        goto L2D4;
+    case 0x212: // 0x6603  LD V6, 0x03
+        if (m.modified(0x0004)) { r.pc = 0x212; goto leave; }
+        r.V[0x6] = 0x03;
+        if (++executed == budget) { r.pc = 0x214; goto leave; }
+    case 0x214: // 0x6802  LD V8, 0x02
+        r.V[0x8] = 0x02;
+        if (++executed == budget) { r.pc = 0x216; goto leave; }
+    case 0x216: L216: // 0x6060  LD V0, 0x60
+        if (m.modified(0x0004)) { r.pc = 0x216; goto leave; }
+        r.V[0x0] = 0x60;
+        if (++executed == budget) { r.pc = 0x218; goto leave; }
+    case 0x218: // 0xF015  LD DT, V0
+        r.delayTimer = r.V[0x0];
+        if (++executed == budget) { r.pc = 0x21A; goto leave; }
+    case 0x21A: L21A: // 0xF007  LD V0, DT
+        if (m.modified(0x0004)) { r.pc = 0x21A; goto leave; }
+        r.V[0x0] = r.delayTimer;
+        if (++executed == budget) { r.pc = 0x21C; goto leave; }
+    case 0x21C: // 0x3000  SE V0, 0x00
+        if (r.V[0x0] == 0x00) {
+            if (++executed == budget) { r.pc = 0x220; goto leave; }
+            goto L220;
+        }
+        if (++executed == budget) { r.pc = 0x21E; goto leave; }
+    case 0x21E: // 0x121A  JP 0x21A
+        if (m.modified(0x0004)) { r.pc = 0x21E; goto leave; }
+        if (++executed == budget) { r.pc = 0x21A; goto leave; }
+        goto L21A;
+    case 0x220: L220: // 0xC717  RND V7, 0x17
+        if (m.modified(0x0004)) { r.pc = 0x220; goto leave; }
+        r.V[0x7] = m.Random() & 0x17;
+        if (++executed == budget) { r.pc = 0x222; goto leave; }
+    case 0x222: // 0x7708  ADD V7, 0x08
+        r.V[0x7] += 0x08;
+        if (++executed == budget) { r.pc = 0x224; goto leave; }
+    case 0x224: // 0x69FF  LD V9, 0xFF
+        r.V[0x9] = 0xFF;
+        if (++executed == budget) { r.pc = 0x226; goto leave; }
+    case 0x226: // 0xA2F0  LD I, 0x2F0
+        r.I = 0x2F0;
+        if (++executed == budget) { r.pc = 0x228; goto leave; }
+    case 0x228: // 0xD671  DRW V6, V7, 1
+        r.V[0xF] = m.Draw(r.I, r.V[0x6], r.V[0x7], 1);
+        if (++executed == budget) { r.pc = 0x22A; goto leave; }
+    case 0x22A: L22A: // 0xA2EA  LD I, 0x2EA
+        if (m.modified(0x0004)) { r.pc = 0x22A; goto leave; }
+        r.I = 0x2EA;
+        if (++executed == budget) { r.pc = 0x22C; goto leave; }
+    case 0x22C: // 0xDAB6  DRW VA, VB, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xA], r.V[0xB], 6);
+        if (++executed == budget) { r.pc = 0x22E; goto leave; }
+    case 0x22E: // 0xDCD6  DRW VC, VD, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xC], r.V[0xD], 6);
+        if (++executed == budget) { r.pc = 0x230; goto leave; }
+    case 0x230: // 0x6001  LD V0, 0x01
+        r.V[0x0] = 0x01;
+        if (++executed == budget) { r.pc = 0x232; goto leave; }
+    case 0x232: // 0xE0A1  SKNP V0
+        if (!((r.keys >> (r.V[0x0] & 0xF)) & 1)) {
+            if (++executed == budget) { r.pc = 0x236; goto leave; }
+            goto L236;
+        }
+        if (++executed == budget) { r.pc = 0x234; goto leave; }
+    case 0x234: // 0x7BFE  ADD VB, 0xFE
+        if (m.modified(0x0004)) { r.pc = 0x234; goto leave; }
+        r.V[0xB] += 0xFE;
+        if (++executed == budget) { r.pc = 0x236; goto leave; }
+    case 0x236: L236: // 0x6004  LD V0, 0x04
+        if (m.modified(0x0004)) { r.pc = 0x236; goto leave; }
+        r.V[0x0] = 0x04;
+        if (++executed == budget) { r.pc = 0x238; goto leave; }
+    case 0x238: // 0xE0A1  SKNP V0
+        if (!((r.keys >> (r.V[0x0] & 0xF)) & 1)) {
+            if (++executed == budget) { r.pc = 0x23C; goto leave; }
+            goto L23C;
+        }
+        if (++executed == budget) { r.pc = 0x23A; goto leave; }
+    case 0x23A: // 0x7B02  ADD VB, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x23A; goto leave; }
+        r.V[0xB] += 0x02;
+        if (++executed == budget) { r.pc = 0x23C; goto leave; }
+    case 0x23C: L23C: // 0x601F  LD V0, 0x1F
+        if (m.modified(0x0004)) { r.pc = 0x23C; goto leave; }
+        r.V[0x0] = 0x1F;
+        if (++executed == budget) { r.pc = 0x23E; goto leave; }
+    case 0x23E: // 0x8B02  AND VB, V0
+        r.V[0xB] &= r.V[0x0];
+        if (++executed == budget) { r.pc = 0x240; goto leave; }
+    case 0x240: // 0xDAB6  DRW VA, VB, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xA], r.V[0xB], 6);
+        if (++executed == budget) { r.pc = 0x242; goto leave; }
+    case 0x242: // 0x8D70  LD VD, V7
+        r.V[0xD] = r.V[0x7];
+        if (++executed == budget) { r.pc = 0x244; goto leave; }
+    case 0x244: // 0xC00A  RND V0, 0x0A
+        r.V[0x0] = m.Random() & 0x0A;
+        if (++executed == budget) { r.pc = 0x246; goto leave; }
+    case 0x246: // 0x7DFE  ADD VD, 0xFE
+        r.V[0xD] += 0xFE;
+        if (++executed == budget) { r.pc = 0x248; goto leave; }
+    case 0x248: // 0x4000  SNE V0, 0x00
+        if (r.V[0x0] != 0x00) {
+            if (++executed == budget) { r.pc = 0x24C; goto leave; }
+            goto L24C;
+        }
+        if (++executed == budget) { r.pc = 0x24A; goto leave; }
+    case 0x24A: // 0x7D02  ADD VD, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x24A; goto leave; }
+        r.V[0xD] += 0x02;
+        if (++executed == budget) { r.pc = 0x24C; goto leave; }
+    case 0x24C: L24C: // 0x6000  LD V0, 0x00
+        if (m.modified(0x0004)) { r.pc = 0x24C; goto leave; }
+        r.V[0x0] = 0x00;
+        if (++executed == budget) { r.pc = 0x24E; goto leave; }
+    case 0x24E: // 0x601F  LD V0, 0x1F
+        r.V[0x0] = 0x1F;
+        if (++executed == budget) { r.pc = 0x250; goto leave; }
+    case 0x250: // 0x8D02  AND VD, V0
+        r.V[0xD] &= r.V[0x0];
+        if (++executed == budget) { r.pc = 0x252; goto leave; }
+    case 0x252: // 0xDCD6  DRW VC, VD, 6
+        r.V[0xF] = m.Draw(r.I, r.V[0xC], r.V[0xD], 6);
+        if (++executed == budget) { r.pc = 0x254; goto leave; }
+    case 0x254: // 0xA2F0  LD I, 0x2F0
+        r.I = 0x2F0;
+        if (++executed == budget) { r.pc = 0x256; goto leave; }
+    case 0x256: // 0xD671  DRW V6, V7, 1
+        r.V[0xF] = m.Draw(r.I, r.V[0x6], r.V[0x7], 1);
+        if (++executed == budget) { r.pc = 0x258; goto leave; }
+    case 0x258: // 0x8684  ADD V6, V8
+        r.V[0xF] = ((int)r.V[0x6] + (int)r.V[0x8]) > 0xFF ? 1 : 0;
+        r.V[0x6] += r.V[0x8];
+        if (++executed == budget) { r.pc = 0x25A; goto leave; }
+    case 0x25A: // 0x8794  ADD V7, V9
+        r.V[0xF] = ((int)r.V[0x7] + (int)r.V[0x9]) > 0xFF ? 1 : 0;
+        r.V[0x7] += r.V[0x9];
+        if (++executed == budget) { r.pc = 0x25C; goto leave; }
+    case 0x25C: // 0x603F  LD V0, 0x3F
+        r.V[0x0] = 0x3F;
+        if (++executed == budget) { r.pc = 0x25E; goto leave; }
+    case 0x25E: // 0x8602  AND V6, V0
+        r.V[0x6] &= r.V[0x0];
+        if (++executed == budget) { r.pc = 0x260; goto leave; }
+    case 0x260: // 0x611F  LD V1, 0x1F
+        r.V[0x1] = 0x1F;
+        if (++executed == budget) { r.pc = 0x262; goto leave; }
+    case 0x262: // 0x8712  AND V7, V1
+        r.V[0x7] &= r.V[0x1];
+        if (++executed == budget) { r.pc = 0x264; goto leave; }
+    case 0x264: // 0x4602  SNE V6, 0x02
+        if (r.V[0x6] != 0x02) {
+            if (++executed == budget) { r.pc = 0x268; goto leave; }
+            goto L268;
+        }
+        if (++executed == budget) { r.pc = 0x266; goto leave; }
+    case 0x266: // 0x1278  JP 0x278
+        if (m.modified(0x0004)) { r.pc = 0x266; goto leave; }
+        if (++executed == budget) { r.pc = 0x278; goto leave; }
+        goto L278;
+    case 0x268: L268: // 0x463F  SNE V6, 0x3F
+        if (m.modified(0x0004)) { r.pc = 0x268; goto leave; }
+        if (r.V[0x6] != 0x3F) {
+            if (++executed == budget) { r.pc = 0x26C; goto leave; }
+            goto L26C;
+        }
+        if (++executed == budget) { r.pc = 0x26A; goto leave; }
+    case 0x26A: // 0x1282  JP 0x282
+        if (m.modified(0x0004)) { r.pc = 0x26A; goto leave; }
+        if (++executed == budget) { r.pc = 0x282; goto leave; }
+        goto L282;
+    case 0x26C: L26C: // 0x471F  SNE V7, 0x1F
+        if (m.modified(0x0004)) { r.pc = 0x26C; goto leave; }
+        if (r.V[0x7] != 0x1F) {
+            if (++executed == budget) { r.pc = 0x270; goto leave; }
+            goto L270;
+        }
+        if (++executed == budget) { r.pc = 0x26E; goto leave; }
+    case 0x26E: // 0x69FF  LD V9, 0xFF
+        if (m.modified(0x0004)) { r.pc = 0x26E; goto leave; }
+        r.V[0x9] = 0xFF;
+        if (++executed == budget) { r.pc = 0x270; goto leave; }
+    case 0x270: L270: // 0x4700  SNE V7, 0x00
+        if (m.modified(0x0004)) { r.pc = 0x270; goto leave; }
+        if (r.V[0x7] != 0x00) {
+            if (++executed == budget) { r.pc = 0x274; goto leave; }
+            goto L274;
+        }
+        if (++executed == budget) { r.pc = 0x272; goto leave; }
+    case 0x272: // 0x6901  LD V9, 0x01
+        if (m.modified(0x0004)) { r.pc = 0x272; goto leave; }
+        r.V[0x9] = 0x01;
+        if (++executed == budget) { r.pc = 0x274; goto leave; }
+    case 0x274: L274: // 0xD671  DRW V6, V7, 1
+        if (m.modified(0x0004)) { r.pc = 0x274; goto leave; }
+        r.V[0xF] = m.Draw(r.I, r.V[0x6], r.V[0x7], 1);
+        if (++executed == budget) { r.pc = 0x276; goto leave; }
+    case 0x276: // 0x122A  JP 0x22A
+        if (++executed == budget) { r.pc = 0x22A; goto leave; }
+        goto L22A;
+    case 0x278: L278: // 0x6802  LD V8, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x278; goto leave; }
+        r.V[0x8] = 0x02;
+        if (++executed == budget) { r.pc = 0x27A; goto leave; }
+    case 0x27A: // 0x6301  LD V3, 0x01
+        r.V[0x3] = 0x01;
+        if (++executed == budget) { r.pc = 0x27C; goto leave; }
+    case 0x27C: // 0x8070  LD V0, V7
+        r.V[0x0] = r.V[0x7];
+        if (++executed == budget) { r.pc = 0x27E; goto leave; }
+    case 0x27E: // 0x80B5  SUB V0, VB
+        r.V[0xF] = (r.V[0x0] > r.V[0xB]) ? 1 : 0;
+        r.V[0x0] -= r.V[0xB];
+        if (++executed == budget) { r.pc = 0x280; goto leave; }
+    case 0x280: // 0x128A  JP 0x28A
+        if (++executed == budget) { r.pc = 0x28A; goto leave; }
+        goto L28A;
+    case 0x282: L282: // 0x68FE  LD V8, 0xFE
+        if (m.modified(0x0004)) { r.pc = 0x282; goto leave; }
+        r.V[0x8] = 0xFE;
+        if (++executed == budget) { r.pc = 0x284; goto leave; }
+    case 0x284: // 0x630A  LD V3, 0x0A
+        r.V[0x3] = 0x0A;
+        if (++executed == budget) { r.pc = 0x286; goto leave; }
+    case 0x286: // 0x8070  LD V0, V7
+        r.V[0x0] = r.V[0x7];
+        if (++executed == budget) { r.pc = 0x288; goto leave; }
+    case 0x288: // 0x80D5  SUB V0, VD
+        r.V[0xF] = (r.V[0x0] > r.V[0xD]) ? 1 : 0;
+        r.V[0x0] -= r.V[0xD];
+        if (++executed == budget) { r.pc = 0x28A; goto leave; }
+    case 0x28A: L28A: // 0x3F01  SE VF, 0x01
+        if (m.modified(0x0004)) { r.pc = 0x28A; goto leave; }
+        if (r.V[0xF] == 0x01) {
+            if (++executed == budget) { r.pc = 0x28E; goto leave; }
+            goto L28E;
+        }
+        if (++executed == budget) { r.pc = 0x28C; goto leave; }
+    case 0x28C: // 0x12A2  JP 0x2A2
+        if (m.modified(0x0004)) { r.pc = 0x28C; goto leave; }
+        if (++executed == budget) { r.pc = 0x2A2; goto leave; }
+        goto L2A2;
+    case 0x28E: L28E: // 0x6102  LD V1, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x28E; goto leave; }
+        r.V[0x1] = 0x02;
+        if (++executed == budget) { r.pc = 0x290; goto leave; }
+    case 0x290: // 0x8015  SUB V0, V1
+        r.V[0xF] = (r.V[0x0] > r.V[0x1]) ? 1 : 0;
+        r.V[0x0] -= r.V[0x1];
+        if (++executed == budget) { r.pc = 0x292; goto leave; }
+    case 0x292: // 0x3F01  SE VF, 0x01
+        if (r.V[0xF] == 0x01) {
+            if (++executed == budget) { r.pc = 0x296; goto leave; }
+            goto L296;
+        }
+        if (++executed == budget) { r.pc = 0x294; goto leave; }
+    case 0x294: // 0x12BA  JP 0x2BA
+        if (m.modified(0x0004)) { r.pc = 0x294; goto leave; }
+        if (++executed == budget) { r.pc = 0x2BA; goto leave; }
+        goto L2BA;
+    case 0x296: L296: // 0x8015  SUB V0, V1
+        if (m.modified(0x0004)) { r.pc = 0x296; goto leave; }
+        r.V[0xF] = (r.V[0x0] > r.V[0x1]) ? 1 : 0;
+        r.V[0x0] -= r.V[0x1];
+        if (++executed == budget) { r.pc = 0x298; goto leave; }
+    case 0x298: // 0x3F01  SE VF, 0x01
+        if (r.V[0xF] == 0x01) {
+            if (++executed == budget) { r.pc = 0x29C; goto leave; }
+            goto L29C;
+        }
+        if (++executed == budget) { r.pc = 0x29A; goto leave; }
+    case 0x29A: // 0x12C8  JP 0x2C8
+        if (m.modified(0x0004)) { r.pc = 0x29A; goto leave; }
+        if (++executed == budget) { r.pc = 0x2C8; goto leave; }
+        goto L2C8;
+    case 0x29C: L29C: // 0x8015  SUB V0, V1
+        if (m.modified(0x0004)) { r.pc = 0x29C; goto leave; }
+        r.V[0xF] = (r.V[0x0] > r.V[0x1]) ? 1 : 0;
+        r.V[0x0] -= r.V[0x1];
+        if (++executed == budget) { r.pc = 0x29E; goto leave; }
+    case 0x29E: // 0x3F01  SE VF, 0x01
+        if (r.V[0xF] == 0x01) {
+            if (++executed == budget) { r.pc = 0x2A2; goto leave; }
+            goto L2A2;
+        }
+        if (++executed == budget) { r.pc = 0x2A0; goto leave; }
+    case 0x2A0: // 0x12C2  JP 0x2C2
+        if (m.modified(0x0004)) { r.pc = 0x2A0; goto leave; }
+        if (++executed == budget) { r.pc = 0x2C2; goto leave; }
+        goto L2C2;
+    case 0x2A2: L2A2: // 0x6020  LD V0, 0x20
+        if (m.modified(0x0004)) { r.pc = 0x2A2; goto leave; }
+        r.V[0x0] = 0x20;
+        if (++executed == budget) { r.pc = 0x2A4; goto leave; }
+    case 0x2A4: // 0xF018  LD ST, V0
+        r.soundTimer = r.V[0x0];
+        if (++executed == budget) { r.pc = 0x2A6; goto leave; }
+    case 0x2A6: // 0x22D4  CALL 0x2D4
+        if (r.sp == 16) {
+            r.pc = 0x2A6;
+            m.Fault(Fault::StackOverflow);
+            goto leave;
+        }
+        m.stack()[r.sp++] = 0x2A8;
+        if (++executed == budget) { r.pc = 0x2D4; goto leave; }
+        goto L2D4;
+    case 0x2A8: // 0x8E34  ADD VE, V3
+        if (m.modified(0x0004)) { r.pc = 0x2A8; goto leave; }
+        r.V[0xF] = ((int)r.V[0xE] + (int)r.V[0x3]) > 0xFF ? 1 : 0;
+        r.V[0xE] += r.V[0x3];
+        if (++executed == budget) { r.pc = 0x2AA; goto leave; }
+    case 0x2AA: // 0x22D4  CALL 0x2D4
+        if (r.sp == 16) {
+            r.pc = 0x2AA;
+            m.Fault(Fault::StackOverflow);
+            goto leave;
+        }
+        m.stack()[r.sp++] = 0x2AC;
+        if (++executed == budget) { r.pc = 0x2D4; goto leave; }
+        goto L2D4;
+    case 0x2AC: // 0x663E  LD V6, 0x3E
+        if (m.modified(0x0004)) { r.pc = 0x2AC; goto leave; }
+        r.V[0x6] = 0x3E;
+        if (++executed == budget) { r.pc = 0x2AE; goto leave; }
+    case 0x2AE: // 0x3301  SE V3, 0x01
+        if (r.V[0x3] == 0x01) {
+            if (++executed == budget) { r.pc = 0x2B2; goto leave; }
+            goto L2B2;
+        }
+        if (++executed == budget) { r.pc = 0x2B0; goto leave; }
+    case 0x2B0: // 0x6603  LD V6, 0x03
+        if (m.modified(0x0004)) { r.pc = 0x2B0; goto leave; }
+        r.V[0x6] = 0x03;
+        if (++executed == budget) { r.pc = 0x2B2; goto leave; }
+    case 0x2B2: L2B2: // 0x68FE  LD V8, 0xFE
+        if (m.modified(0x0004)) { r.pc = 0x2B2; goto leave; }
+        r.V[0x8] = 0xFE;
+        if (++executed == budget) { r.pc = 0x2B4; goto leave; }
+    case 0x2B4: // 0x3301  SE V3, 0x01
+        if (r.V[0x3] == 0x01) {
+            if (++executed == budget) { r.pc = 0x2B8; goto leave; }
+            goto L2B8;
+        }
+        if (++executed == budget) { r.pc = 0x2B6; goto leave; }
+    case 0x2B6: // 0x6802  LD V8, 0x02
+        if (m.modified(0x0004)) { r.pc = 0x2B6; goto leave; }
+        r.V[0x8] = 0x02;
+        if (++executed == budget) { r.pc = 0x2B8; goto leave; }
+    case 0x2B8: L2B8: // 0x1216  JP 0x216
+        if (m.modified(0x0004)) { r.pc = 0x2B8; goto leave; }
+        if (++executed == budget) { r.pc = 0x216; goto leave; }
+        goto L216;
+    case 0x2BA: L2BA: // 0x79FF  ADD V9, 0xFF
+        if (m.modified(0x0004)) { r.pc = 0x2BA; goto leave; }
+        r.V[0x9] += 0xFF;
+        if (++executed == budget) { r.pc = 0x2BC; goto leave; }
+    case 0x2BC: // 0x49FE  SNE V9, 0xFE
+        if (r.V[0x9] != 0xFE) {
+            if (++executed == budget) { r.pc = 0x2C0; goto leave; }
+            goto L2C0;
+        }
+        if (++executed == budget) { r.pc = 0x2BE; goto leave; }
+    case 0x2BE: // 0x69FF  LD V9, 0xFF
+        if (m.modified(0x0004)) { r.pc = 0x2BE; goto leave; }
+        r.V[0x9] = 0xFF;
+        if (++executed == budget) { r.pc = 0x2C0; goto leave; }
+    case 0x2C0: L2C0: // 0x12C8  JP 0x2C8
+        if (m.modified(0x0004)) { r.pc = 0x2C0; goto leave; }
+        if (++executed == budget) { r.pc = 0x2C8; goto leave; }
+        goto L2C8;
+    case 0x2C2: L2C2: // 0x7901  ADD V9, 0x01
+        if (m.modified(0x0004)) { r.pc = 0x2C2; goto leave; }
+        r.V[0x9] += 0x01;
+        if (++executed == budget) { r.pc = 0x2C4; goto leave; }
+    case 0x2C4: // 0x4902  SNE V9, 0x02
+        if (r.V[0x9] != 0x02) {
+            if (++executed == budget) { r.pc = 0x2C8; goto leave; }
+            goto L2C8;
+        }
+        if (++executed == budget) { r.pc = 0x2C6; goto leave; }
+    case 0x2C6: // 0x6901  LD V9, 0x01
+        if (m.modified(0x0004)) { r.pc = 0x2C6; goto leave; }
+        r.V[0x9] = 0x01;
+        if (++executed == budget) { r.pc = 0x2C8; goto leave; }
+    case 0x2C8: L2C8: // 0x6004  LD V0, 0x04
+        if (m.modified(0x0004)) { r.pc = 0x2C8; goto leave; }
+        r.V[0x0] = 0x04;
+        if (++executed == budget) { r.pc = 0x2CA; goto leave; }
+    case 0x2CA: // 0xF018  LD ST, V0
+        r.soundTimer = r.V[0x0];
+        if (++executed == budget) { r.pc = 0x2CC; goto leave; }
+    case 0x2CC: // 0x7601  ADD V6, 0x01
+        r.V[0x6] += 0x01;
+        if (++executed == budget) { r.pc = 0x2CE; goto leave; }
+    case 0x2CE: // 0x4640  SNE V6, 0x40
+        if (r.V[0x6] != 0x40) {
+            if (++executed == budget) { r.pc = 0x2D2; goto leave; }
+            goto L2D2;
+        }
+        if (++executed == budget) { r.pc = 0x2D0; goto leave; }
+    case 0x2D0: // 0x76FE  ADD V6, 0xFE
+        if (m.modified(0x0004)) { r.pc = 0x2D0; goto leave; }
+        r.V[0x6] += 0xFE;
+        if (++executed == budget) { r.pc = 0x2D2; goto leave; }
+    case 0x2D2: L2D2: // 0x126C  JP 0x26C
+        if (m.modified(0x0004)) { r.pc = 0x2D2; goto leave; }
+        if (++executed == budget) { r.pc = 0x26C; goto leave; }
+        goto L26C;
+    case 0x2D4: L2D4: // 0xA2F2  LD I, 0x2F2
+        if (m.modified(0x0004)) { r.pc = 0x2D4; goto leave; }
+        r.I = 0x2F2;
+        if (++executed == budget) { r.pc = 0x2D6; goto leave; }
+    case 0x2D6: // 0xFE33  LD B, VE
+        m.Write(r.I, (r.V[0xE] % 1000) / 100);
+        m.Write(r.I + 1, (r.V[0xE] % 100) / 10);
+        m.Write(r.I + 2, r.V[0xE] % 10);
+        if (m.modified(0x0004)) { ++executed; r.pc = 0x2D8; goto leave; }
+        if (++executed == budget) { r.pc = 0x2D8; goto leave; }
+    case 0x2D8: // 0xF265  LD V2, [I]
+        r.V[0x0] = m.Read(r.I + 0);
+        r.V[0x1] = m.Read(r.I + 1);
+        r.V[0x2] = m.Read(r.I + 2);
+        r.I += 3;
+        if (++executed == budget) { r.pc = 0x2DA; goto leave; }
+    case 0x2DA: // 0xF129  LD F, V1
+        r.I = FONTSET_BYTES_PER_CHAR * r.V[0x1];
+        if (++executed == budget) { r.pc = 0x2DC; goto leave; }
+    case 0x2DC: // 0x6414  LD V4, 0x14
+        r.V[0x4] = 0x14;
+        if (++executed == budget) { r.pc = 0x2DE; goto leave; }
+    case 0x2DE: // 0x6500  LD V5, 0x00
+        r.V[0x5] = 0x00;
+        if (++executed == budget) { r.pc = 0x2E0; goto leave; }
+    case 0x2E0: // 0xD455  DRW V4, V5, 5
+        r.V[0xF] = m.Draw(r.I, r.V[0x4], r.V[0x5], 5);
+        if (++executed == budget) { r.pc = 0x2E2; goto leave; }
+    case 0x2E2: // 0x7415  ADD V4, 0x15
+        r.V[0x4] += 0x15;
+        if (++executed == budget) { r.pc = 0x2E4; goto leave; }
+    case 0x2E4: // 0xF229  LD F, V2
+        r.I = FONTSET_BYTES_PER_CHAR * r.V[0x2];
+        if (++executed == budget) { r.pc = 0x2E6; goto leave; }
+    case 0x2E6: // 0xD455  DRW V4, V5, 5
+        r.V[0xF] = m.Draw(r.I, r.V[0x4], r.V[0x5], 5);
+        if (++executed == budget) { r.pc = 0x2E8; goto leave; }
+    case 0x2E8: // 0x00EE  RET
+        if (r.sp == 0) {
+            r.pc = 0x2E8;
+            m.Fault(Fault::StackUnderflow);
+            goto leave;
+        }
+        r.pc = m.stack()[--r.sp];
+        if (++executed == budget) goto leave;
+        goto dispatch;
+    default:
+        break;
+    }
+
+leave:
+    m.Store(r);
+    return executed;
+}
+
+} // namespace
+
+extern const AotProgram pong_aot;
+const AotProgram pong_aot = {"pong.ch8", IMAGE, sizeof(IMAGE), CODE, run};
+
+[[maybe_unused]] static const bool REGISTERED = AotRegister(&pong_aot);
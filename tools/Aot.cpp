@@ -0,0 +1,92 @@
+#include <cctype>
+#include <iostream>
+#include <exception>
+#include <fstream>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "AotTranslator.hpp"
+#include "RomStore.hpp"
+
+/**
+ * Translates a ROM into a C++ translation unit to link with the core, see Aot.hpp.
+ *
+ * The translated ROMs in tests/aot are built into chip8-aot-bench, which compares their
+ * throughput and final state with the interpreter.
+ */
+
+/**
+ * @brief C++ identifier from the name of a game, e.g. "pong.ch8" gives "pong_aot"
+ */
+static std::string symbolOf(const std::string &name) {
+    std::string symbol;
+    for (char c : name.substr(0, name.find('.'))) {
+        symbol += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::tolower(static_cast<unsigned char>(c))) : '_';
+    }
+    if (symbol.empty() || std::isdigit(static_cast<unsigned char>(symbol[0])))
+        symbol = "rom_" + symbol;
+    return symbol + "_aot";
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-aot", "Translate a Chip8 game into C++ ahead of time");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("o,output", "Output file, defaults to the standard output", cxxopts::value<std::string>(), "FILE")
+      ("s,symbol", "Name of the AotProgram, defaults to the game name followed by _aot", cxxopts::value<std::string>(), "NAME");
+  ;
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  const RomImage game(result["game"].as<std::string>());
+  const std::string symbol = result.count("symbol") ? result["symbol"].as<std::string>() : symbolOf(game.name());
+
+  // Translate the memory image the core would run, font included
+  Chip8 chip8;
+  chip8.Initialize();
+  chip8.LoadGame(game.data(), game.size());
+
+  Chip8State state;
+  chip8.SaveState(state);
+
+  std::ofstream file;
+  if (result.count("output")) {
+    file.open(result["output"].as<std::string>());
+    if (!file) {
+      throw std::runtime_error("Not be able to write " + result["output"].as<std::string>() + "!");
+    }
+  }
+  std::ostream &out = result.count("output") ? file : std::cout;
+
+  const AotTranslator::Stats stats = AotTranslator::Translate(out, symbol, game.name(), state.memory, game.size());
+
+  // The summary would end up in the code on the standard output
+  if (result.count("output")) {
+    std::cout << game.name() << ": " << stats.instructions << " instructions in " << stats.blocks << " blocks";
+    if (stats.computedJumps)
+      std::cout << ", " << stats.computedJumps << " computed jumps left to the interpreter";
+    if (stats.selfModifyingWrites)
+      std::cout << ", " << stats.selfModifyingWrites << " self-modifying writes";
+    std::cout << std::endl;
+  }
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
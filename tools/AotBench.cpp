@@ -0,0 +1,122 @@
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <exception>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Aot.hpp"
+
+/**
+ * Runs every ROM translated into tests/aot with the switch and the cached backends, and with its
+ * translated code, on the same input stream, then compares the throughput and the final states.
+ *
+ * The input presses a key every few frames so the games leave their title screens and take
+ * branches depending on the keys.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+struct Engine {
+    const char *name;
+    Chip8::Backend backend;
+    bool translated;
+};
+
+static const Engine ENGINES[] = {
+    {"switch", Chip8::Backend::Switch, false},
+    {"cached", Chip8::Backend::Cached, false},
+    {"aot", Chip8::Backend::Switch, true},
+};
+
+/**
+ * @brief Keypad state at a frame, a key pressed 5 frames out of 20, the next key every time
+ */
+static uint16_t keysAt(int frame) {
+    return (frame % 20) < 5 ? static_cast<uint16_t>(1 << ((frame / 20) % 16)) : 0;
+}
+
+static bool equal(const Chip8State &a, const Chip8State &b) {
+    return memcmp(a.memory, b.memory, sizeof(a.memory)) == 0 && memcmp(a.V, b.V, sizeof(a.V)) == 0 &&
+           a.I == b.I && a.pc == b.pc && a.delayTimer == b.delayTimer && a.soundTimer == b.soundTimer &&
+           memcmp(a.stack, b.stack, sizeof(a.stack)) == 0 && a.sp == b.sp &&
+           memcmp(a.gfx.pixels, b.gfx.pixels, sizeof(a.gfx.pixels)) == 0 && a.drawFlag == b.drawFlag &&
+           a.random == b.random && a.fault == b.fault;
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-aot-bench", "Compare the translated ROMs with the interpreter");
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("f,frames", "Frames to run", cxxopts::value<int>()->default_value("20000"), "FRAMES")
+      ("c,cycles", "Instructions per frame", cxxopts::value<int>()->default_value("1000"), "CYCLES")
+      ("s,seed", "Seed of the random number generator", cxxopts::value<uint32_t>()->default_value("1"), "SEED");
+  ;
+  // clang-format on
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>()) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  const int frames = result["frames"].as<int>();
+  const int cycles = result["cycles"].as<int>();
+  const uint32_t seed = result["seed"].as<uint32_t>();
+
+  if (AotPrograms().empty()) {
+    std::cout << "No translated game, add the output of chip8-aot to tests/aot" << std::endl;
+    return 1;
+  }
+
+  bool identical = true;
+
+  for (const AotProgram *program : AotPrograms()) {
+    Chip8State states[3];
+    double rates[3];
+
+    for (int e = 0; e < 3; ++e) {
+      const Engine &engine = ENGINES[e];
+
+      Chip8 chip8;
+      chip8.SetBackend(engine.backend);
+      chip8.Initialize();
+      chip8.SetSeed(seed);
+      chip8.LoadGame(program->image, program->size);
+      if (engine.translated)
+        chip8.SetProgram(program);
+
+      const Clock::time_point start = Clock::now();
+      for (int frame = 0; frame < frames && chip8.fault() == Fault::None; ++frame) {
+        chip8.SetKeys(keysAt(frame));
+        chip8.Run(cycles);
+        chip8.Tick();
+      }
+      const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+      chip8.SaveState(states[e]);
+      rates[e] = static_cast<double>(frames) * cycles / seconds;
+    }
+
+    const bool same = equal(states[0], states[1]) && equal(states[0], states[2]);
+    identical = identical && same;
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-16s switch %8.1f M/s  cached %8.1f M/s  aot %8.1f M/s  x%.2f / x%.2f  %s",
+             program->name, rates[0] / 1e6, rates[1] / 1e6, rates[2] / 1e6, rates[2] / rates[0], rates[2] / rates[1],
+             same ? "identical" : "STATES DIFFER");
+    std::cout << line << std::endl;
+  }
+
+  return identical ? 0 : 1;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
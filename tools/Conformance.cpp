@@ -0,0 +1,362 @@
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Emulator.hpp"
+#include "ThreadPool.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * Runs every ROM of a directory headless, under the inputs and seed recorded in its golden manifest,
+ * and compares the machine state at chosen frames with the golden one.
+ *
+ * Manifest format, one directive per line, « # » starts a comment:
+ *   seed N                         Seed of the random number generator
+ *   cycles N                       Instructions per frame
+ *   input FRAME MASK               Keypad mask (hex) applied from FRAME on
+ *   check FRAME HASH REGS SCREEN   Expected state after FRAME: hash of registers and screen,
+ *                                  registers and packed screen in hex
+ */
+
+static const int REGISTERS_SIZE = 16 + 2 + 2 + 1 + 1 + 1;
+
+struct Check {
+    uint64_t frame;
+    uint64_t hash;
+    std::vector<uint8_t> registers;
+    std::vector<uint8_t> screen;
+};
+
+struct Manifest {
+    uint32_t seed = 1;
+    int cycles = 9;
+    std::map<uint64_t, uint16_t> inputs;
+    std::vector<Check> checks;
+};
+
+/* Hex helpers */
+
+static std::string toHex(const std::vector<uint8_t> &bytes) {
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex;
+    for (uint8_t byte : bytes) {
+        hex += digits[byte >> 4];
+        hex += digits[byte & 0xF];
+    }
+    return hex;
+}
+
+static std::vector<uint8_t> fromHex(const std::string &hex) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        bytes.push_back(static_cast<uint8_t>(std::stoul(hex.substr(i, 2), nullptr, 16)));
+    return bytes;
+}
+
+/* Manifest */
+
+static Manifest readManifest(const fs::path &path) {
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("Not be able to read " + path.string() + "!");
+    }
+
+    Manifest manifest;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream in(line.substr(0, line.find('#')));
+
+        std::string directive;
+        if (!(in >> directive))
+            continue;
+
+        if (directive == "seed") {
+            in >> manifest.seed;
+        } else if (directive == "cycles") {
+            in >> manifest.cycles;
+        } else if (directive == "input") {
+            uint64_t frame;
+            in >> frame >> std::hex >> manifest.inputs[frame];
+        } else if (directive == "check") {
+            Check check;
+            std::string registers, screen;
+            in >> check.frame >> std::hex >> check.hash >> registers >> screen;
+            if (!in.fail() && check.frame < 1) {
+                throw std::runtime_error(path.string() + ": check frames start at 1: " + line);
+            }
+            check.registers = fromHex(registers);
+            check.screen = fromHex(screen);
+            manifest.checks.push_back(check);
+        } else {
+            throw std::runtime_error(path.string() + ": unknown directive " + directive);
+        }
+
+        if (in.fail()) {
+            throw std::runtime_error(path.string() + ": malformed line: " + line);
+        }
+    }
+
+    std::sort(manifest.checks.begin(), manifest.checks.end(),
+              [](const Check &a, const Check &b) { return a.frame < b.frame; });
+
+    for (size_t i = 1; i < manifest.checks.size(); ++i) {
+        if (manifest.checks[i].frame == manifest.checks[i - 1].frame) {
+            throw std::runtime_error(path.string() + ": frame " + std::to_string(manifest.checks[i].frame) + " is checked twice");
+        }
+    }
+
+    return manifest;
+}
+
+static void writeManifest(const fs::path &path, const Manifest &manifest) {
+    std::ofstream file(path);
+    if (!file) {
+        throw std::runtime_error("Not be able to write " + path.string() + "!");
+    }
+
+    file << "# chip8-conformance golden manifest\n";
+    file << "seed " << manifest.seed << "\n";
+    file << "cycles " << manifest.cycles << "\n";
+
+    for (const auto &input : manifest.inputs)
+        file << "input " << input.first << " " << std::hex << input.second << std::dec << "\n";
+
+    for (const Check &check : manifest.checks) {
+        file << "check " << check.frame << " " << std::hex << check.hash << std::dec << " "
+             << toHex(check.registers) << " " << toHex(check.screen) << "\n";
+    }
+}
+
+/* Run */
+
+static uint64_t fnv1a(const std::vector<uint8_t> &bytes, uint64_t hash = 0xcbf29ce484222325ull) {
+    for (uint8_t byte : bytes) {
+        hash ^= byte;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static Check capture(const Chip8 &chip8, uint64_t frame) {
+    Chip8State state;
+    chip8.SaveState(state);
+
+    Check check;
+    check.frame = frame;
+
+    check.registers.assign(state.V, state.V + 16);
+    check.registers.push_back(state.I >> 8);
+    check.registers.push_back(state.I & 0xFF);
+    check.registers.push_back(state.pc >> 8);
+    check.registers.push_back(state.pc & 0xFF);
+    check.registers.push_back(static_cast<uint8_t>(state.sp));
+    check.registers.push_back(state.delayTimer);
+    check.registers.push_back(state.soundTimer);
+
+    check.screen.resize(GFX_PACKED_SIZE);
+    state.gfx.Pack(check.screen.data());
+
+    check.hash = fnv1a(check.screen, fnv1a(check.registers));
+    return check;
+}
+
+static std::vector<Check> run(const fs::path &rom, const Manifest &manifest, const std::vector<uint64_t> &frames) {
+    Chip8 chip8;
+    chip8.SetSeed(manifest.seed);
+    chip8.Initialize();
+    chip8.LoadGame(rom.string());
+
+    Emulator emulator(chip8);
+    emulator.SetCyclesPerFrame(manifest.cycles);
+
+    std::vector<Check> checks;
+    auto next = frames.begin();
+
+    for (uint64_t frame = 1; next != frames.end(); ++frame) {
+        auto input = manifest.inputs.find(frame);
+        if (input != manifest.inputs.end())
+            chip8.SetKeys(input->second);
+
+        emulator.RunFrame();
+
+        if (frame == *next) {
+            checks.push_back(capture(chip8, frame));
+            ++next;
+        }
+    }
+
+    return checks;
+}
+
+/* Report */
+
+static void diffRegisters(std::ostream &out, const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual) {
+    static const char *names[] = {"V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7", "V8", "V9", "VA", "VB", "VC",
+                                  "VD", "VE", "VF", "I",  "I",  "PC", "PC", "SP", "DT", "ST"};
+
+    for (int i = 0; i < REGISTERS_SIZE; ++i) {
+        if (i >= static_cast<int>(expected.size()) || expected[i] != actual[i]) {
+            out << "    " << names[i] << " byte " << i << ": expected "
+                << (i < static_cast<int>(expected.size()) ? std::to_string(expected[i]) : "?")
+                << ", got " << static_cast<int>(actual[i]) << "\n";
+        }
+    }
+}
+
+static void diffScreen(std::ostream &out, const std::vector<uint8_t> &expected, const std::vector<uint8_t> &actual) {
+    out << "    screen ('#' both, '+' only actual, '-' only expected):\n";
+    out << "    +" << std::string(GFX_COLS, '-') << "+\n";
+
+    for (int y = 0; y < GFX_ROWS; ++y) {
+        out << "    |";
+        for (int x = 0; x < GFX_COLS; ++x) {
+            const int i = y * GFX_COLS + x;
+            const bool e = i / 8 < static_cast<int>(expected.size()) && ((expected[i / 8] >> (7 - i % 8)) & 1);
+            const bool a = (actual[i / 8] >> (7 - i % 8)) & 1;
+            out << (e && a ? '#' : a ? '+' : e ? '-' : ' ');
+        }
+        out << "|\n";
+    }
+
+    out << "    +" << std::string(GFX_COLS, '-') << "+\n";
+}
+
+struct Result {
+    bool passed = true;
+    std::string report;
+};
+
+static Result checkRom(const fs::path &rom, const fs::path &golden, bool update, const std::vector<uint64_t> &defaultFrames) {
+    Result result;
+    std::ostringstream out;
+
+    try {
+        Manifest manifest;
+        if (fs::exists(golden)) {
+            manifest = readManifest(golden);
+        } else if (!update) {
+            throw std::runtime_error("no golden manifest " + golden.string());
+        }
+
+        std::vector<uint64_t> frames;
+        for (const Check &check : manifest.checks)
+            frames.push_back(check.frame);
+        if (frames.empty())
+            frames = defaultFrames;
+        std::sort(frames.begin(), frames.end());
+        frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+
+        const std::vector<Check> actual = run(rom, manifest, frames);
+
+        if (update) {
+            manifest.checks = actual;
+            writeManifest(golden, manifest);
+            out << "[UPDATE] " << rom.filename().string() << " (" << actual.size() << " checks)\n";
+        } else {
+            for (size_t i = 0; i < actual.size(); ++i) {
+                const Check &expected = manifest.checks[i];
+                if (expected.hash == actual[i].hash && expected.registers == actual[i].registers && expected.screen == actual[i].screen)
+                    continue;
+
+                if (result.passed)
+                    out << "[ FAIL ] " << rom.filename().string() << "\n";
+                result.passed = false;
+
+                out << "  frame " << actual[i].frame << ": expected hash " << std::hex << expected.hash << ", got "
+                    << actual[i].hash << std::dec << "\n";
+
+                diffRegisters(out, expected.registers, actual[i].registers);
+                if (expected.screen != actual[i].screen)
+                    diffScreen(out, expected.screen, actual[i].screen);
+            }
+
+            if (result.passed)
+                out << "[  OK  ] " << rom.filename().string() << " (" << actual.size() << " checks)\n";
+        }
+    } catch (const std::exception &e) {
+        result.passed = false;
+        out << "[ FAIL ] " << rom.filename().string() << ": " << e.what() << "\n";
+    }
+
+    result.report = out.str();
+    return result;
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-conformance", "Compare Chip8 runs with golden frames");
+  options.positional_help("ROMS").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("r,roms", "Directory of ROMs (*.ch8)", cxxopts::value<std::string>(), "ROMS")
+      ("g,golden", "Directory of golden manifests (ROM name + .golden), defaults to ROMS", cxxopts::value<std::string>(), "DIR")
+      ("u,update", "Record the current results as golden")
+      ("frames", "Frames checked when a manifest has no check yet", cxxopts::value<std::vector<uint64_t>>()->default_value("60,300,600"), "N,N")
+      ("j,jobs", "Number of ROMs checked in parallel, 0 for one per core", cxxopts::value<unsigned>()->default_value("0"), "N");
+  ;
+  // clang-format on
+
+  options.parse_positional({"roms"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("roms")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  const fs::path roms = result["roms"].as<std::string>();
+  const fs::path golden = result.count("golden") ? fs::path(result["golden"].as<std::string>()) : roms;
+  const bool update = result["update"].as<bool>();
+  const std::vector<uint64_t> frames = result["frames"].as<std::vector<uint64_t>>();
+  for (uint64_t frame : frames) {
+    if (frame < 1)
+      throw std::invalid_argument("Unknown frame: 0 (expected frames from 1 on).");
+  }
+
+  std::vector<fs::path> paths;
+  for (const fs::directory_entry &entry : fs::directory_iterator(roms)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".ch8")
+      paths.push_back(entry.path());
+  }
+  std::sort(paths.begin(), paths.end());
+
+  std::vector<Result> results(paths.size());
+  {
+    ThreadPool pool(result["jobs"].as<unsigned>());
+    for (size_t i = 0; i < paths.size(); ++i) {
+      pool.Submit([&, i]() {
+        results[i] = checkRom(paths[i], golden / (paths[i].stem().string() + ".golden"), update, frames);
+      });
+    }
+    pool.Wait();
+  }
+
+  size_t failed = 0;
+  for (const Result &r : results) {
+    std::cout << r.report;
+    failed += r.passed ? 0 : 1;
+  }
+
+  std::cout << paths.size() - failed << "/" << paths.size() << " ROMs passed." << std::endl;
+
+  return failed == 0 ? 0 : 1;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
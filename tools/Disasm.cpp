@@ -0,0 +1,255 @@
+#include <cstdio>
+#include <iostream>
+#include <exception>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Analysis.hpp"
+#include "RomStore.hpp"
+
+/**
+ * Disassembles a ROM after a static analysis of its control flow.
+ *
+ * Output formats:
+ *   listing  Code by basic block, data as bytes, then the findings
+ *   dot      Control-flow graph for Graphviz
+ *   json     Blocks, edges, data ranges and findings
+ */
+
+static std::string hex(unsigned value, int digits) {
+    char text[16];
+    snprintf(text, sizeof(text), "0x%0*X", digits, value);
+    return text;
+}
+
+static uint16_t opcodeAt(const uint8_t memory[4096], uint16_t address) {
+    return memory[address & 0xFFF] << 8 | memory[(address + 1) & 0xFFF];
+}
+
+static std::string label(uint16_t address) {
+    char text[8];
+    snprintf(text, sizeof(text), "L%03X", address);
+    return text;
+}
+
+static std::string describe(const Analysis::Finding &finding) {
+    std::ostringstream out;
+    out << Analysis::FindingName(finding.kind) << " at " << hex(finding.address, 3);
+
+    switch (finding.kind) {
+        case Analysis::FindingKind::SelfModifyingWrite:
+            out << ": writes " << finding.size << " bytes at " << hex(finding.target, 3);
+            break;
+        case Analysis::FindingKind::ComputedJump:
+            out << ": V0 + " << hex(finding.target, 3) << ", targets not followed";
+            break;
+        case Analysis::FindingKind::UnreachableCode:
+            out << ": " << finding.size << " bytes";
+            break;
+        default:
+            break;
+    }
+    return out.str();
+}
+
+/* Formats */
+
+static void writeListing(std::ostream &out, const std::string &name, const uint8_t memory[4096], size_t size, const Analysis &analysis) {
+    out << "; " << name << ", " << size << " bytes, " << analysis.code().size() << " instructions in "
+        << analysis.blocks().size() << " blocks\n";
+
+    const size_t end = 0x200 + size;
+    size_t address = 0x200;
+    while (address < end) {
+        const uint8_t flags = analysis.flags(address);
+
+        if (flags & Analysis::CODE) {
+            if (flags & Analysis::BLOCK_START)
+                out << "\n" << label(address) << ":\n";
+
+            const uint16_t opcode = opcodeAt(memory, address);
+            char line[64];
+            snprintf(line, sizeof(line), "  %03zX  %04X  ", address, opcode);
+            out << line << Disassemble(opcode) << "\n";
+            address += 2;
+            continue;
+        }
+
+        // Run of data bytes of the same kind, 8 per line
+        const uint8_t kind = flags & (Analysis::DATA | Analysis::WRITTEN);
+        char line[64];
+        snprintf(line, sizeof(line), "  %03zX        DB", address);
+        out << "\n" << line;
+
+        size_t count = 0;
+        while (address < end && count < 8 && !(analysis.flags(address) & Analysis::CODE) &&
+               (analysis.flags(address) & (Analysis::DATA | Analysis::WRITTEN)) == kind) {
+            out << (count ? ", " : " ") << hex(memory[address], 2);
+            ++address;
+            ++count;
+        }
+
+        out << std::string(6 * (8 - count), ' ') << "  ; "
+            << (kind == (Analysis::DATA | Analysis::WRITTEN) ? "read, written"
+                : kind & Analysis::WRITTEN                     ? "written"
+                : kind & Analysis::DATA                        ? "read"
+                                                               : "unreached");
+    }
+    out << "\n";
+
+    if (analysis.findings().empty())
+        return;
+
+    out << "\n; findings\n";
+    for (const Analysis::Finding &finding : analysis.findings())
+        out << ";   " << describe(finding) << "\n";
+}
+
+static void writeDot(std::ostream &out, const std::string &name, const uint8_t memory[4096], const Analysis &analysis) {
+    out << "digraph \"" << name << "\" {\n";
+    out << "  node [shape=box, fontname=\"monospace\"];\n";
+
+    for (const Analysis::Block &block : analysis.blocks()) {
+        out << "  " << label(block.start) << " [label=\"";
+        for (uint16_t address = block.start; address != block.end; address = (address + 2) & 0xFFF)
+            out << hex(address, 3) << "  " << Disassemble(opcodeAt(memory, address)) << "\\l";
+        out << "\"];\n";
+    }
+
+    for (const Analysis::Block &block : analysis.blocks()) {
+        for (const Analysis::Edge &edge : block.successors) {
+            out << "  " << label(block.start) << " -> " << label(edge.target) << " [label=\""
+                << Analysis::EdgeName(edge.kind) << "\"";
+            if (edge.kind == Analysis::EdgeKind::Call)
+                out << ", style=dashed";
+            out << "];\n";
+        }
+    }
+
+    out << "}\n";
+}
+
+static void writeJson(std::ostream &out, const std::string &name, const uint8_t memory[4096], size_t size, const Analysis &analysis) {
+    out << "{\n  \"rom\": \"" << name << "\",\n  \"size\": " << size << ",\n  \"entry\": \"0x200\",\n";
+
+    out << "  \"blocks\": [";
+    for (size_t b = 0; b < analysis.blocks().size(); ++b) {
+        const Analysis::Block &block = analysis.blocks()[b];
+        out << (b ? "," : "") << "\n    {\"start\": \"" << hex(block.start, 3) << "\", \"end\": \"" << hex(block.end, 3)
+            << "\", \"instructions\": [";
+
+        bool first = true;
+        for (uint16_t address = block.start; address != block.end; address = (address + 2) & 0xFFF) {
+            const uint16_t opcode = opcodeAt(memory, address);
+            out << (first ? "" : ", ") << "{\"address\": \"" << hex(address, 3) << "\", \"opcode\": \"" << hex(opcode, 4)
+                << "\", \"asm\": \"" << Disassemble(opcode) << "\"}";
+            first = false;
+        }
+
+        out << "], \"successors\": [";
+        for (size_t e = 0; e < block.successors.size(); ++e) {
+            out << (e ? ", " : "") << "{\"target\": \"" << hex(block.successors[e].target, 3) << "\", \"kind\": \""
+                << Analysis::EdgeName(block.successors[e].kind) << "\"}";
+        }
+        out << "]}";
+    }
+    out << "\n  ],\n";
+
+    // Contiguous ranges of bytes read or written through I
+    out << "  \"data\": [";
+    bool first = true;
+    for (size_t address = 0; address < 4096;) {
+        const uint8_t kind = analysis.flags(address) & (Analysis::DATA | Analysis::WRITTEN);
+        size_t end = address + 1;
+        while (end < 4096 && (analysis.flags(end) & (Analysis::DATA | Analysis::WRITTEN)) == kind)
+            ++end;
+
+        if (kind) {
+            out << (first ? "" : ",") << "\n    {\"start\": \"" << hex(address, 3) << "\", \"size\": " << end - address
+                << ", \"read\": " << (kind & Analysis::DATA ? "true" : "false")
+                << ", \"written\": " << (kind & Analysis::WRITTEN ? "true" : "false") << "}";
+            first = false;
+        }
+        address = end;
+    }
+    out << "\n  ],\n";
+
+    out << "  \"findings\": [";
+    for (size_t f = 0; f < analysis.findings().size(); ++f) {
+        const Analysis::Finding &finding = analysis.findings()[f];
+        out << (f ? "," : "") << "\n    {\"kind\": \"" << Analysis::FindingName(finding.kind) << "\", \"address\": \""
+            << hex(finding.address, 3) << "\", \"target\": \"" << hex(finding.target, 3) << "\", \"size\": " << finding.size
+            << ", \"message\": \"" << describe(finding) << "\"}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-disasm", "Disassemble a Chip8 game and recover its control flow");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("f,format", "Output format: listing, dot or json", cxxopts::value<std::string>()->default_value("listing"), "FORMAT")
+      ("o,output", "Output file, defaults to the standard output", cxxopts::value<std::string>(), "FILE");
+  ;
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  const std::string gamePath = result["game"].as<std::string>();
+  const std::string format = result["format"].as<std::string>();
+
+  if (format != "listing" && format != "dot" && format != "json")
+    throw std::invalid_argument("Unknown format: " + format + " (expected listing, dot or json).");
+
+  const RomImage game(gamePath);
+
+  // Analyse the memory image the core would run, font included
+  Chip8 chip8;
+  chip8.Initialize();
+  chip8.LoadGame(game.data(), game.size());
+
+  Chip8State state;
+  chip8.SaveState(state);
+
+  const Analysis analysis = Analysis::Analyze(state.memory, game.size());
+
+  std::ofstream file;
+  if (result.count("output")) {
+    file.open(result["output"].as<std::string>());
+    if (!file) {
+      throw std::runtime_error("Not be able to write " + result["output"].as<std::string>() + "!");
+    }
+  }
+  std::ostream &out = result.count("output") ? file : std::cout;
+
+  const std::string &name = game.name();
+
+  if (format == "dot")
+    writeDot(out, name, state.memory, analysis);
+  else if (format == "json")
+    writeJson(out, name, state.memory, game.size(), analysis);
+  else
+    writeListing(out, name, state.memory, game.size(), analysis);
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
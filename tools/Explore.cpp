@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <exception>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Hash.hpp"
+#include "InstancePool.hpp"
+#include "StateExporter.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Branches from one state of a game into many alternatives and runs them in parallel.
+ *
+ * The game runs alone for a while, then is forked once per alternative: each fork holds a different
+ * key for the rest of the run and has its own random seed. The forks share the memory pages and
+ * the screen of the parent until they write them, and run on the thread pool. The forks come from
+ * an InstancePool, so their registers are packed in one block and their pages in the same arena.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Run frames of cycles instructions, or machine cycles with the VIP timing, and return the instructions executed
+ */
+static uint64_t runFrames(Chip8 &chip8, int frames, int cycles, Chip8::Timing timing, StateExporter *exporter = nullptr,
+                          uint32_t slot = 0) {
+    uint64_t executed = 0;
+    for (int frame = 0; frame < frames; ++frame) {
+        if (timing == Chip8::Timing::Vip) {
+            executed += chip8.RunCycles(cycles);
+        } else {
+            for (int cycle = 0; cycle < cycles; ++cycle)
+                chip8.Step();
+            executed += cycles;
+        }
+        chip8.Tick();
+
+        if (exporter)
+            exporter->Publish(slot, chip8, frame + 1);
+    }
+    return executed;
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-explore", "Fork a Chip8 game into alternatives and run them in parallel");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("backend", "Execution engine: switch or cached", cxxopts::value<std::string>()->default_value("cached"), "NAME")
+      ("c,cycles", "Instructions executed per 60 Hz frame, or machine cycles with --timing vip where it defaults to 3668", cxxopts::value<int>()->default_value("9"), "N")
+      ("timing", "Length of a frame: instructions, or vip for the machine cycles of the COSMAC VIP", cxxopts::value<std::string>()->default_value("instructions"), "NAME")
+      ("prefix", "Frames run before forking", cxxopts::value<int>()->default_value("120"), "N")
+      ("forks", "Number of alternatives", cxxopts::value<int>()->default_value("4096"), "N")
+      ("frames", "Frames run by each alternative", cxxopts::value<int>()->default_value("60"), "N")
+      ("seed", "Seed of the random number generator", cxxopts::value<uint32_t>()->default_value("1"), "N")
+      ("j,jobs", "Number of worker threads, 0 for one per core", cxxopts::value<unsigned>()->default_value("0"), "N")
+      ("shm", "Export every alternative after each frame to the shared memory NAME (watch it with chip8-watch)", cxxopts::value<std::string>(), "NAME");
+  ;
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  // Every alternative gets exactly the same budget per frame
+  const Chip8::Timing timing = Chip8::ParseTiming(result["timing"].as<std::string>());
+  const int cycles = timing == Chip8::Timing::Vip && !result.count("cycles") ? Chip8::VIP_CYCLES_PER_FRAME : result["cycles"].as<int>();
+  const int forks = std::max(result["forks"].as<int>(), 1);
+  const int frames = result["frames"].as<int>();
+  const uint32_t seed = result["seed"].as<uint32_t>();
+
+  Chip8 parent;
+  parent.SetBackend(Chip8::ParseBackend(result["backend"].as<std::string>()));
+  parent.SetAudioEnabled(false);
+  parent.SetSeed(seed);
+  parent.Initialize();
+  parent.LoadGame(result["game"].as<std::string>());
+
+  runFrames(parent, result["prefix"].as<int>(), cycles, timing);
+
+  /* Fork */
+
+  // The forks, and the pages they write, are allocated from the pool arena
+  InstancePool instances(forks);
+  std::vector<Chip8 *> children(forks);
+
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < forks; ++i) {
+    children[i] = &instances.Acquire();
+    parent.Fork(*children[i]);
+
+    // No key or one of the 16 keys, and a different random sequence
+    children[i]->SetKeys(i % 17 == 16 ? 0 : 1 << (i % 17));
+    children[i]->SetSeed(seed + i + 1);
+  }
+  const double forkTime = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / forks;
+
+  // Cost of the alternative: a full copy of the state for each alternative
+  std::vector<Chip8State> states(std::min(forks, 1024));
+
+  start = Clock::now();
+  for (Chip8State &copy : states)
+    parent.SaveState(copy);
+  const double copyTime = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / states.size();
+
+  Chip8State state;
+
+  /* Run */
+
+  // One slot per alternative, the workers publish their own slots
+  std::unique_ptr<StateExporter> exporter;
+  if (result.count("shm"))
+    exporter = std::make_unique<StateExporter>(result["shm"].as<std::string>(), forks);
+
+  std::atomic<uint64_t> executed{0};
+
+  // A task must not throw on a worker thread, the first error is reported once they are done
+  std::mutex errorMutex;
+  std::string error;
+
+  start = Clock::now();
+  {
+    ThreadPool pool(result["jobs"].as<unsigned>());
+
+    const int batch = std::max(forks / static_cast<int>(pool.size() * 4), 1);
+    for (int first = 0; first < forks; first += batch) {
+      pool.Submit([&, first]() {
+        try {
+          uint64_t instructions = 0;
+          for (int i = first; i < std::min(first + batch, forks); ++i)
+            instructions += runFrames(*children[i], frames, cycles, timing, exporter.get(), i);
+          executed.fetch_add(instructions, std::memory_order_relaxed);
+        } catch (const std::exception &e) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (error.empty())
+            error = e.what();
+        }
+      });
+    }
+    pool.Wait();
+  }
+
+  if (!error.empty())
+    throw std::runtime_error("Not be able to run the forks: " + error);
+  const double runTime = std::chrono::duration<double>(Clock::now() - start).count();
+
+  /* Report */
+
+  std::set<uint64_t> outcomes;
+  int faulted = 0;
+  instances.ForEach([&](Chip8 &child) {
+    child.SaveState(state);
+    outcomes.insert(Fnv1a(state.gfx.pixels, sizeof(state.gfx.pixels), Fnv1a(state.memory, sizeof(state.memory))));
+    faulted += child.fault() != Fault::None;
+  });
+
+  const InstancePool::Stats stats = instances.stats();
+
+  std::cout << forks << " forks after " << result["prefix"].as<int>() << " frames, " << frames << " frames each\n"
+            << "  fork       : " << forkTime << " ns per fork (full state copy: " << copyTime << " ns)\n"
+            << "  run        : " << runTime * 1000 << " ms, "
+            << static_cast<uint64_t>(static_cast<double>(executed.load()) / runTime) << " instructions/s\n";
+  if (timing == Chip8::Timing::Vip) {
+    std::cout << "  emulated   : " << static_cast<double>(forks) * frames * cycles / (runTime * 1e9)
+              << " VIP machine cycles per host ns, " << static_cast<double>(forks) * frames / (runTime * 60)
+              << "x real time in total\n";
+  }
+  std::cout << "  outcomes   : " << outcomes.size() << " distinct memory and screen states\n"
+            << "  faulted    : " << faulted << "\n"
+            << "  pool       : " << stats.resident << "/" << stats.capacity << " instances, " << stats.bytesPerInstance
+            << " bytes per instance, huge pages: " << InstancePool::HugePagesName(stats.hugePages) << std::endl;
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
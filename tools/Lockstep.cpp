@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <exception>
+#include <sstream>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Decode.hpp"
+
+/**
+ * Runs the switch and the cached backends side by side on the same ROM and input stream,
+ * and stops at the first instruction after which their states differ.
+ *
+ * Registers are compared after every instruction, memory and screen every block of instructions
+ * and at the end of every frame.
+ */
+
+static const char *BACKEND_NAMES[] = {"switch", "cached"};
+
+/**
+ * @brief Compare two states, cheap enough to run after every instruction
+ */
+static bool equal(const Chip8State &a, const Chip8State &b, bool full) {
+    if (memcmp(a.V, b.V, sizeof(a.V)) != 0 || memcmp(a.stack, b.stack, sizeof(a.stack)) != 0)
+        return false;
+
+    if (a.I != b.I || a.pc != b.pc || a.sp != b.sp || a.delayTimer != b.delayTimer || a.soundTimer != b.soundTimer ||
+        a.random != b.random || a.drawFlag != b.drawFlag || a.fault != b.fault)
+        return false;
+
+    if (!full)
+        return true;
+
+    return memcmp(a.memory, b.memory, sizeof(a.memory)) == 0 && memcmp(a.gfx.pixels, b.gfx.pixels, sizeof(a.gfx.pixels)) == 0;
+}
+
+/**
+ * @brief List the differences between two states
+ */
+static std::vector<std::string> diff(const Chip8State &a, const Chip8State &b, bool full) {
+    std::vector<std::string> differences;
+
+    auto check = [&](const std::string &name, unsigned va, unsigned vb) {
+        if (va != vb) {
+            std::ostringstream out;
+            out << std::hex << std::uppercase << name << ": 0x" << va << " / 0x" << vb;
+            differences.push_back(out.str());
+        }
+    };
+
+    for (int i = 0; i < 16; ++i) {
+        std::ostringstream name;
+        name << "V" << std::hex << std::uppercase << i;
+        check(name.str(), a.V[i], b.V[i]);
+    }
+
+    check("I", a.I, b.I);
+    check("PC", a.pc, b.pc);
+    check("SP", a.sp, b.sp);
+    check("DT", a.delayTimer, b.delayTimer);
+    check("ST", a.soundTimer, b.soundTimer);
+    check("random", a.random, b.random);
+    check("drawFlag", a.drawFlag, b.drawFlag);
+
+    if (a.fault != b.fault)
+        differences.push_back(std::string("fault: ") + Chip8::FaultName(a.fault) + " / " + Chip8::FaultName(b.fault));
+
+    for (int i = 0; i < 16; ++i)
+        check("stack[" + std::to_string(i) + "]", a.stack[i], b.stack[i]);
+
+    if (!full)
+        return differences;
+
+    for (int i = 0; i < 4096; ++i) {
+        if (a.memory[i] != b.memory[i]) {
+            std::ostringstream name;
+            name << "memory[0x" << std::hex << std::uppercase << std::setw(3) << std::setfill('0') << i << "]";
+            check(name.str(), a.memory[i], b.memory[i]);
+        }
+    }
+
+    int pixels = 0;
+    for (int i = 0; i < GFX_ROWS * GFX_COLS; ++i)
+        pixels += a.gfx[i] != b.gfx[i];
+    if (pixels > 0)
+        differences.push_back("screen: " + std::to_string(pixels) + " pixels differ");
+
+    return differences;
+}
+
+static void dump(std::ostream &out, const char *name, const Chip8State &s) {
+    out << "  " << std::setw(6) << name << std::hex << std::uppercase << std::setfill('0');
+    for (int i = 0; i < 16; ++i)
+        out << " V" << i << "=" << std::setw(2) << static_cast<unsigned>(s.V[i]);
+    out << " I=" << std::setw(3) << s.I << " PC=" << std::setw(3) << s.pc << " SP=" << s.sp
+        << " DT=" << std::setw(2) << static_cast<unsigned>(s.delayTimer)
+        << " ST=" << std::setw(2) << static_cast<unsigned>(s.soundTimer)
+        << std::dec << std::setfill(' ') << "\n";
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-lockstep", "Run the Chip8 backends in lockstep and report the first divergence");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("n,instructions", "Number of instructions to run", cxxopts::value<uint64_t>()->default_value("1000000"), "N")
+      ("c,cycles", "Instructions executed per 60 Hz frame", cxxopts::value<int>()->default_value("9"), "N")
+      ("block", "Compare memory and screen every N instructions", cxxopts::value<uint64_t>()->default_value("64"), "N")
+      ("seed", "Seed of the random number generator and of the input stream", cxxopts::value<uint32_t>()->default_value("1"), "N")
+      ("input-period", "Change the random keypad state every N frames", cxxopts::value<uint64_t>()->default_value("10"), "N");
+  ;
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  const std::string gamePath = result["game"].as<std::string>();
+  const uint64_t instructions = result["instructions"].as<uint64_t>();
+  const int cycles = result["cycles"].as<int>();
+  const uint64_t block = std::max<uint64_t>(result["block"].as<uint64_t>(), 1);
+  const uint32_t seed = result["seed"].as<uint32_t>();
+  const uint64_t inputPeriod = std::max<uint64_t>(result["input-period"].as<uint64_t>(), 1);
+
+  Chip8 engines[2];
+  engines[0].SetBackend(Chip8::Backend::Switch);
+  engines[1].SetBackend(Chip8::Backend::Cached);
+
+  for (Chip8 &engine : engines) {
+    engine.SetSeed(seed);
+    engine.Initialize();
+    engine.LoadGame(gamePath);
+  }
+
+  Chip8State states[2] = {};
+  Chip8State before = {};
+
+  // Input stream, shared by both engines (xorshift32)
+  uint32_t input = seed ? seed : 1;
+
+  const auto start = std::chrono::steady_clock::now();
+
+  uint64_t executed = 0;
+  for (uint64_t frame = 0; executed < instructions; ++frame) {
+    if (frame % inputPeriod == 0) {
+      input ^= input << 13;
+      input ^= input >> 17;
+      input ^= input << 5;
+
+      // Mostly no key, sometimes one key, rarely several
+      const uint16_t keys = (input & 0x3) == 0 ? (1 << ((input >> 8) & 0xF)) : (input & 0x1F) == 1 ? (input >> 16) : 0;
+      for (Chip8 &engine : engines)
+        engine.SetKeys(keys);
+    }
+
+    for (int cycle = 0; cycle <= cycles && executed < instructions; ++cycle) {
+      const bool tick = cycle == cycles;
+      engines[0].SaveRegisters(before);
+
+      if (tick) {
+        for (Chip8 &engine : engines)
+          engine.Tick();
+      } else {
+        for (Chip8 &engine : engines)
+          engine.Step();
+        ++executed;
+      }
+
+      const bool full = tick || executed % block == 0 || executed == instructions;
+      for (int i = 0; i < 2; ++i) {
+        if (full)
+          engines[i].SaveState(states[i]);
+        else
+          engines[i].SaveRegisters(states[i]);
+      }
+
+      if (equal(states[0], states[1], full)) {
+        // Both cores halted the same way, nothing left to compare
+        if (states[0].fault != Fault::None) {
+          std::cout << "Both backends faulted (" << Chip8::FaultName(states[0].fault) << ") after instruction "
+                    << executed << " at PC=0x" << std::hex << std::uppercase << states[0].pc << std::dec << "." << std::endl;
+          return 0;
+        }
+        continue;
+      }
+
+      const std::vector<std::string> differences = diff(states[0], states[1], full);
+
+      const uint16_t opcode = engines[0].Peek(before.pc) << 8 | engines[0].Peek(before.pc + 1);
+
+      std::cout << "Divergence after instruction " << executed << " (frame " << frame << ")";
+      if (tick) {
+        std::cout << " at the timer tick\n";
+      } else {
+        std::cout << " at PC=0x" << std::hex << std::uppercase << before.pc << ": " << std::setw(4)
+                  << std::setfill('0') << opcode << std::setfill(' ') << std::dec << "  " << Disassemble(opcode) << "\n";
+      }
+      if (!full)
+        std::cout << "  (memory and screen last matched " << executed % block << " instructions ago)\n";
+
+      dump(std::cout, "before", before);
+      dump(std::cout, BACKEND_NAMES[0], states[0]);
+      dump(std::cout, BACKEND_NAMES[1], states[1]);
+
+      std::cout << "  differences (" << BACKEND_NAMES[0] << " / " << BACKEND_NAMES[1] << "):\n";
+      for (const std::string &difference : differences)
+        std::cout << "    " << difference << "\n";
+
+      return 1;
+    }
+  }
+
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << executed << " instructions in lockstep, no divergence ("
+            << static_cast<uint64_t>(executed / seconds) << " instructions/s)." << std::endl;
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
@@ -0,0 +1,291 @@
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include "Chip8.hpp"
+#include "Pacer.hpp"
+#include "Rollback.hpp"
+#include "UdpLink.hpp"
+
+/**
+ * Plays one side of a two-player Rollback session over UDP on the loopback, with scripted keys.
+ *
+ * Player P binds PORT + P and sends to the other port, so both sides are started with the same
+ * options but --player. With --local both players run in this process, each on its own thread,
+ * and their final states are compared with a run of the core given every key on time.
+ *
+ * The keys of each player are drawn from its own set, held for a few frames each, so the result
+ * depends on every remote key and a wrong rollback shows up as a different final state.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+// Without any datagram from the peer for this long, the session is abandoned
+static const auto PEER_TIMEOUT = std::chrono::seconds(10);
+
+// Keep answering after the last frame, so the peer gets the acknowledgement of its last keys
+static const auto LINGER = std::chrono::milliseconds(500);
+
+// Frames a scripted choice of keys is held
+static const uint32_t HOLD_FRAMES = 12;
+
+struct Setup {
+  std::string game;
+  int cycles;
+  uint32_t seed;
+  uint32_t delay;
+  uint32_t frames;
+  uint16_t port;
+  Pacer::Mode pacing;
+  UdpLink::Conditions conditions;
+  uint16_t keys[2][16];
+  size_t keyCount[2];
+};
+
+/**
+ * @brief Keys held by a player at a step of its script, one of its set or none
+ */
+static uint16_t scriptedKeys(const Setup &setup, int player, uint32_t step) {
+  // Finalizer of MurmurHash3, every hold period gets an unrelated choice
+  uint32_t x = setup.seed ^ (player + 1) * 0x9E3779B9u ^ (step / HOLD_FRAMES) * 0x85EBCA6Bu;
+  x ^= x >> 16;
+  x *= 0x85EBCA6Bu;
+  x ^= x >> 13;
+  x *= 0xC2B2AE35u;
+  x ^= x >> 16;
+
+  const size_t choice = x % (setup.keyCount[player] + 1);
+  return choice < setup.keyCount[player] ? setup.keys[player][choice] : 0;
+}
+
+static void parseKeys(Setup &setup, int player, const std::string &keys) {
+  setup.keyCount[player] = 0;
+  for (char c : keys) {
+    if (!isxdigit(static_cast<unsigned char>(c)) || setup.keyCount[player] == 16)
+      throw std::invalid_argument("Unknown keys: " + keys + " (expected up to 16 hexadecimal digits).");
+    setup.keys[player][setup.keyCount[player]++] = static_cast<uint16_t>(1 << std::stoi(std::string(1, c), nullptr, 16));
+  }
+}
+
+static void loadGame(const Setup &setup, Chip8 &chip8) {
+  chip8.SetSeed(setup.seed);
+  chip8.Initialize();
+  chip8.LoadGame(setup.game);
+}
+
+static std::string formatHash(uint64_t hash) {
+  char text[17];
+  snprintf(text, sizeof(text), "%016llX", static_cast<unsigned long long>(hash));
+  return text;
+}
+
+/**
+ * @brief Play every frame of one side, then wait for both sides to confirm them, and return the final hash
+ */
+static uint64_t play(const Setup &setup, int player, std::ostream &report) {
+  Chip8 chip8;
+  loadGame(setup, chip8);
+
+  UdpLink link(static_cast<uint16_t>(setup.port + player), static_cast<uint16_t>(setup.port + 1 - player));
+  UdpLink::Conditions conditions = setup.conditions;
+  conditions.seed += player;
+  link.SetConditions(conditions);
+
+  Rollback session(chip8, link, setup.cycles, setup.delay);
+
+  Pacer pacer;
+  pacer.SetMode(setup.pacing);
+  pacer.Start();
+
+  Clock::time_point lastProgress = Clock::now();
+  uint32_t lastConfirmed = 0;
+  uint32_t lastAcknowledged = 0;
+
+  // New keys or acknowledgements show the peer is still there
+  auto checkPeer = [&]() {
+    if (session.confirmedFrame() != lastConfirmed || session.acknowledgedFrame() != lastAcknowledged) {
+      lastConfirmed = session.confirmedFrame();
+      lastAcknowledged = session.acknowledgedFrame();
+      lastProgress = Clock::now();
+    } else if (Clock::now() - lastProgress > PEER_TIMEOUT) {
+      throw std::runtime_error("Not be able to reach the peer on port " + std::to_string(setup.port + 1 - player) + "!");
+    }
+
+    if (session.desynced())
+      throw std::runtime_error("The session desynced at frame " + std::to_string(session.verifiedFrame()) + "!");
+  };
+
+  uint32_t step = 0;
+  while (session.frame() < setup.frames) {
+    if (session.Advance(scriptedKeys(setup, player, step))) {
+      ++step;
+      pacer.Wait();
+    } else {
+      link.Wait(1);
+    }
+    checkPeer();
+  }
+
+  while (session.confirmedFrame() < setup.frames || session.acknowledgedFrame() < setup.frames) {
+    link.Wait(1);
+    session.Poll();
+    checkPeer();
+  }
+
+  const Clock::time_point lingerEnd = Clock::now() + LINGER;
+  while (Clock::now() < lingerEnd) {
+    link.Wait(5);
+    session.Poll();
+  }
+
+  Chip8State state;
+  chip8.SaveState(state);
+  const uint64_t hash = Rollback::Hash(state);
+
+  const Histogram &time = session.rollbackTime();
+  const double perFrame = session.resimulatedFrames() ? static_cast<double>(time.sum()) / session.resimulatedFrames() : 0;
+
+  char line[256];
+  snprintf(line, sizeof(line),
+           "Player %d: %u frames, hash %s, verified up to frame %u\n"
+           "  %llu rollbacks, %llu frames emulated again (max %u), %.1f us per frame, rollback p50 %.1f us p99 %.1f us, %llu stalls\n"
+           "  %llu datagrams sent, %llu dropped, %llu received\n",
+           player, session.frame(), formatHash(hash).c_str(), session.verifiedFrame(),
+           static_cast<unsigned long long>(session.rollbacks()), static_cast<unsigned long long>(session.resimulatedFrames()),
+           session.maxDepth(), perFrame / 1000, time.Quantile(0.5) / 1000.0, time.Quantile(0.99) / 1000.0,
+           static_cast<unsigned long long>(session.stalls()), static_cast<unsigned long long>(link.sent()),
+           static_cast<unsigned long long>(link.dropped()), static_cast<unsigned long long>(link.received()));
+  report << line;
+
+  return hash;
+}
+
+/**
+ * @brief Hash of the final state of a run given every key on time
+ */
+static uint64_t reference(const Setup &setup) {
+  Chip8 chip8;
+  loadGame(setup, chip8);
+
+  for (uint32_t frame = 0; frame < setup.frames; ++frame) {
+    uint16_t keys = 0;
+    if (frame >= setup.delay)
+      keys = scriptedKeys(setup, 0, frame - setup.delay) | scriptedKeys(setup, 1, frame - setup.delay);
+
+    chip8.SetKeys(keys);
+    chip8.Run(setup.cycles);
+    chip8.Tick();
+  }
+
+  Chip8State state;
+  chip8.SaveState(state);
+  return Rollback::Hash(state);
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-netplay", "Play a two-player rollback session over UDP on the loopback");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("p,player", "Side played, 0 or 1", cxxopts::value<int>()->default_value("0"), "N")
+      ("local", "Play both sides in this process and compare with a run without network")
+      ("port", "Port of player 0, player 1 uses the next one", cxxopts::value<uint16_t>()->default_value("7700"), "PORT")
+      ("f,frames", "Frames to play", cxxopts::value<uint32_t>()->default_value("1800"), "N")
+      ("c,cycles", "Instructions executed per 60 Hz frame", cxxopts::value<int>()->default_value("9"), "N")
+      ("seed", "Seed of the random number generator and of the scripted keys", cxxopts::value<uint32_t>()->default_value("1"), "N")
+      ("d,delay", "Frames between reading the local keys and applying them", cxxopts::value<uint32_t>()->default_value("2"), "N")
+      ("keys", "Keys pressed by the script of player 0 and player 1, as hexadecimal digits", cxxopts::value<std::vector<std::string>>()->default_value("14,CD"), "KEYS,KEYS")
+      ("pacing", "Pacing of the frames: realtime or unlimited", cxxopts::value<std::string>()->default_value("realtime"), "MODE");
+
+  options.add_options("Simulated network")
+      ("latency", "One-way delay of every datagram, in milliseconds", cxxopts::value<double>()->default_value("0"), "MS")
+      ("jitter", "Random extra delay up to, in milliseconds", cxxopts::value<double>()->default_value("0"), "MS")
+      ("loss", "Probability of dropping a datagram", cxxopts::value<double>()->default_value("0"), "P");
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help({"", "Simulated network"});
+      return 0;
+  }
+
+  Setup setup;
+  setup.game = result["game"].as<std::string>();
+  setup.cycles = result["cycles"].as<int>();
+  setup.seed = result["seed"].as<uint32_t>();
+  setup.delay = result["delay"].as<uint32_t>();
+  setup.frames = result["frames"].as<uint32_t>();
+  setup.port = result["port"].as<uint16_t>();
+  setup.pacing = Pacer::ParseMode(result["pacing"].as<std::string>());
+  setup.conditions.latency = result["latency"].as<double>();
+  setup.conditions.jitter = result["jitter"].as<double>();
+  setup.conditions.loss = result["loss"].as<double>();
+  setup.conditions.seed = setup.seed;
+
+  const std::vector<std::string> keys = result["keys"].as<std::vector<std::string>>();
+  if (keys.size() != 2)
+    throw std::invalid_argument("Unknown keys: expected the keys of both players, e.g. 14,CD.");
+  parseKeys(setup, 0, keys[0]);
+  parseKeys(setup, 1, keys[1]);
+
+  if (!result["local"].as<bool>()) {
+    const int player = result["player"].as<int>();
+    if (player != 0 && player != 1)
+      throw std::invalid_argument("Unknown player: " + std::to_string(player) + " (expected 0 or 1).");
+
+    play(setup, player, std::cout);
+    return 0;
+  }
+
+  /* Both sides in this process */
+
+  uint64_t hashes[2] = {};
+  std::ostringstream reports[2];
+  std::string errors[2];
+
+  auto side = [&](int player) {
+    try {
+      hashes[player] = play(setup, player, reports[player]);
+    } catch (const std::exception &e) {
+      errors[player] = e.what();
+    }
+  };
+
+  std::thread other(side, 1);
+  side(0);
+  other.join();
+
+  bool identical = true;
+  for (int player = 0; player < 2; ++player) {
+    std::cout << reports[player].str();
+    if (!errors[player].empty()) {
+      std::cout << "Player " << player << ": " << errors[player] << std::endl;
+      identical = false;
+    }
+  }
+
+  const uint64_t expected = reference(setup);
+  identical = identical && hashes[0] == expected && hashes[1] == expected;
+  std::cout << "Reference: hash " << formatHash(expected) << ", " << (identical ? "identical" : "STATES DIFFER") << std::endl;
+
+  return identical ? 0 : 1;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
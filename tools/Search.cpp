@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cxxopts.hpp>
+
+#include "Cheats.hpp"
+#include "Chip8.hpp"
+#include "InstancePool.hpp"
+#include "RamSearch.hpp"
+#include "ThreadPool.hpp"
+
+/**
+ * Finds the memory addresses of a game holding a value, e.g. a score or a life counter, then
+ * tries freezing them.
+ *
+ * The game runs headless in one or many instances, forks of the same start with their own random
+ * seed. Commands come from --commands, separated by semicolons, or from the standard input one per
+ * line:
+ *
+ *   run N              emulate N frames
+ *   press K, release K hold or release key K (hexadecimal) in every instance
+ *   reset              make every address a candidate again
+ *   equal, changed, increased, decreased
+ *                      keep the addresses that compare so with the previous filter, in every instance
+ *   equal-to V         keep the addresses holding V (hexadecimal) in every instance
+ *   count, list [N]    print the number of candidates, or the first N with their value in instance 0
+ *   freeze A V         write V at address A at every frame (hexadecimal), unfreeze A to stop
+ */
+
+static const char HELP[] =
+    "run N | press K | release K | reset | equal | changed | increased | decreased | equal-to V | count | list [N] | "
+    "freeze A V | unfreeze A | quit";
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-search", "Search the memory of a Chip8 game for the bytes holding a value");
+  options.positional_help("GAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("g,game", "Path to a chip8 game", cxxopts::value<std::string>(), "GAME")
+      ("backend", "Execution engine: switch or cached", cxxopts::value<std::string>()->default_value("switch"), "NAME")
+      ("c,cycles", "Instructions executed per 60 Hz frame", cxxopts::value<int>()->default_value("9"), "N")
+      ("instances", "Number of instances searched together", cxxopts::value<int>()->default_value("1"), "N")
+      ("seed", "Seed of the random number generator of the first instance", cxxopts::value<uint32_t>()->default_value("1"), "N")
+      ("j,jobs", "Number of worker threads, 0 for one per core", cxxopts::value<unsigned>()->default_value("0"), "N")
+      ("e,commands", "Commands separated by semicolons, instead of the standard input", cxxopts::value<std::string>(), "COMMANDS");
+  ;
+  // clang-format on
+
+  options.parse_positional({"game"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("game")) {
+      std::cout << options.help() << "\nCommands: " << HELP << std::endl;
+      return 0;
+  }
+
+  const int cycles = result["cycles"].as<int>();
+  const int count = std::max(result["instances"].as<int>(), 1);
+  const uint32_t seed = result["seed"].as<uint32_t>();
+
+  Chip8 parent;
+  parent.SetBackend(Chip8::ParseBackend(result["backend"].as<std::string>()));
+  parent.SetAudioEnabled(false);
+  parent.SetSeed(seed);
+  parent.Initialize();
+  parent.LoadGame(result["game"].as<std::string>());
+
+  // The instances share the pages of the parent until they write them
+  InstancePool pool(count);
+  std::vector<Chip8 *> instances(count);
+  for (int i = 0; i < count; ++i) {
+    instances[i] = &pool.Acquire();
+    parent.Fork(*instances[i]);
+    instances[i]->SetSeed(seed + i);
+  }
+
+  ThreadPool workers(result["jobs"].as<unsigned>());
+  const int batch = std::max(count / static_cast<int>(workers.size() * 4), 1);
+
+  // Run func on every instance, spread over the workers. A task must not throw on a worker thread,
+  // the first error is thrown again once they are done.
+  const auto forEach = [&](auto func) {
+    std::mutex errorMutex;
+    std::string error;
+
+    for (int first = 0; first < count; first += batch) {
+      workers.Submit([&, first]() {
+        try {
+          for (int i = first; i < std::min(first + batch, count); ++i)
+            func(i, *instances[i]);
+        } catch (const std::exception &e) {
+          std::lock_guard<std::mutex> lock(errorMutex);
+          if (error.empty())
+            error = e.what();
+        }
+      });
+    }
+    workers.Wait();
+
+    if (!error.empty())
+      throw std::runtime_error("Not be able to run the instances: " + error);
+  };
+
+  RamSearch search(count);
+  Cheats cheats;
+  uint16_t keys = 0;
+  uint64_t frame = 0;
+
+  forEach([&](int i, Chip8 &chip8) { search.Capture(i, chip8); });
+  search.Reset();
+
+  /* Commands */
+
+  std::istringstream inlineCommands;
+  if (result.count("commands")) {
+    std::string commands = result["commands"].as<std::string>();
+    std::replace(commands.begin(), commands.end(), ';', '\n');
+    inlineCommands.str(commands);
+  }
+  std::istream &input = result.count("commands") ? static_cast<std::istream &>(inlineCommands) : std::cin;
+
+  std::string line;
+  while (std::getline(input, line)) {
+    std::istringstream words(line);
+    std::string command;
+    if (!(words >> command))
+      continue;
+
+    if (command == "quit") {
+      break;
+    } else if (command == "run") {
+      int frames = 0;
+      words >> frames;
+
+      forEach([&](int, Chip8 &chip8) {
+        chip8.SetKeys(keys);
+        for (int f = 0; f < frames; ++f) {
+          cheats.Apply(chip8);
+          for (int cycle = 0; cycle < cycles; ++cycle)
+            chip8.Step();
+          chip8.Tick();
+        }
+      });
+      frame += frames;
+      std::cout << "frame " << frame << std::endl;
+    } else if (command == "press" || command == "release") {
+      unsigned key = 0;
+      words >> std::hex >> key;
+      keys = command == "press" ? keys | (1 << (key & 0xF)) : keys & ~(1 << (key & 0xF));
+    } else if (command == "reset") {
+      forEach([&](int i, Chip8 &chip8) { search.Capture(i, chip8); });
+      search.Reset();
+      std::cout << search.count() << " candidates" << std::endl;
+    } else if (command == "equal" || command == "changed" || command == "increased" || command == "decreased" ||
+               command == "equal-to") {
+      unsigned value = 0;
+      words >> std::hex >> value;
+
+      forEach([&](int i, Chip8 &chip8) { search.Capture(i, chip8); });
+      search.Filter(RamSearch::ParseComparison(command), static_cast<uint8_t>(value), &workers);
+      std::cout << search.count() << " candidates" << std::endl;
+    } else if (command == "count") {
+      std::cout << search.count() << " candidates" << std::endl;
+    } else if (command == "list") {
+      size_t limit = 32;
+      words >> limit;
+
+      const std::vector<uint16_t> addresses = search.addresses();
+      for (size_t i = 0; i < std::min(limit, addresses.size()); ++i)
+        printf("%03X = %02X\n", addresses[i], search.value(0, addresses[i]));
+      if (addresses.size() > limit)
+        std::cout << "... " << addresses.size() - limit << " more" << std::endl;
+      std::cout << std::flush;
+    } else if (command == "freeze" || command == "unfreeze") {
+      unsigned address = 0, value = 0;
+      words >> std::hex >> address >> value;
+
+      if (command == "freeze")
+        cheats.Freeze(static_cast<uint16_t>(address), static_cast<uint8_t>(value));
+      else
+        cheats.Unfreeze(static_cast<uint16_t>(address));
+      std::cout << cheats.cheats().size() << " cheats" << std::endl;
+    } else {
+      std::cout << "Unknown command: " << command << " (" << HELP << ")" << std::endl;
+    }
+  }
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
@@ -0,0 +1,121 @@
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <exception>
+#include <thread>
+
+#include <cxxopts.hpp>
+
+#include "StateReader.hpp"
+
+/**
+ * Watches instances exported with « chip8 --shm » or « chip8-explore --shm », from another process.
+ *
+ * Example consumer of the reader library: it only links chip8-state-reader, not the core, and
+ * prints an instance, or a summary of every instance, whenever a new frame is published.
+ */
+
+static void printInstance(const StateReader &reader, const StateReader::Snapshot &snapshot, bool screen, int memory) {
+  const SharedInstanceState &state = snapshot.state;
+
+  printf("frame %llu  pc %03X (%04X)  I %03X  sp %u  dt %u  st %u  keys %04X  fault %u\n",
+         static_cast<unsigned long long>(state.frame), state.pc, state.opcode, state.I, state.sp, state.delayTimer,
+         state.soundTimer, state.keys, state.fault);
+
+  printf("V");
+  for (int i = 0; i < 16; ++i)
+    printf(" %02X", state.V[i]);
+  printf("\n");
+
+  if (screen) {
+    for (int row = 0; row < GFX_ROWS; ++row) {
+      char line[GFX_COLS + 1];
+      for (int col = 0; col < GFX_COLS; ++col) {
+        const int pixel = row * GFX_COLS + col;
+        line[col] = (state.screen[pixel / 8] >> (7 - pixel % 8)) & 1 ? '#' : '.';
+      }
+      line[GFX_COLS] = '\0';
+      printf("%s\n", line);
+    }
+  }
+
+  const int bytes = std::min<int>(memory, static_cast<int>(snapshot.memory.size()));
+  for (int offset = 0; offset < bytes; offset += 16) {
+    printf("%03X:", reader.memoryAddress() + offset);
+    for (int i = offset; i < std::min(offset + 16, bytes); ++i)
+      printf(" %02X", snapshot.memory[i]);
+    printf("\n");
+  }
+
+  fflush(stdout);
+}
+
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-watch", "Watch Chip8 instances exported in shared memory");
+  options.positional_help("NAME").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("n,name", "Name of the shared memory given to --shm", cxxopts::value<std::string>(), "NAME")
+      ("i,instance", "Instance to print", cxxopts::value<uint32_t>()->default_value("0"), "N")
+      ("all", "Print one line per instance instead")
+      ("screen", "Print the screen of the instance")
+      ("memory", "Bytes of exported memory to print", cxxopts::value<int>()->default_value("0"), "N")
+      ("interval", "Milliseconds between two looks at the segment", cxxopts::value<int>()->default_value("100"), "MS")
+      ("count", "Number of prints before exiting, 0 to watch until interrupted", cxxopts::value<int>()->default_value("0"), "N");
+  ;
+  // clang-format on
+
+  options.parse_positional({"name"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("name")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  StateReader reader(result["name"].as<std::string>());
+
+  std::cout << reader.name() << " : " << reader.instances() << " instances, memory " << std::hex << reader.memoryAddress()
+            << "+" << reader.memorySize() << std::dec << std::endl;
+
+  const uint32_t instance = result["instance"].as<uint32_t>();
+  const bool all = result["all"].as<bool>();
+  const int count = result["count"].as<int>();
+  const std::chrono::milliseconds interval(result["interval"].as<int>());
+
+  StateReader::Snapshot snapshot;
+  uint32_t lastSequence = 0;
+
+  for (int printed = 0; count == 0 || printed < count;) {
+    if (all) {
+      // A summary whenever any instance moved on, each line is consistent on its own
+      for (uint32_t i = 0; i < reader.instances(); ++i) {
+        if (!reader.Read(i, snapshot))
+          continue;
+        printf("%6u  frame %llu  pc %03X  I %03X  fault %u\n", i, static_cast<unsigned long long>(snapshot.state.frame),
+               snapshot.state.pc, snapshot.state.I, snapshot.state.fault);
+      }
+      printf("\n");
+      fflush(stdout);
+      ++printed;
+    } else if (reader.sequence(instance) != lastSequence && reader.Read(instance, snapshot)) {
+      // Only print new publications
+      lastSequence = snapshot.sequence;
+      printInstance(reader, snapshot, result["screen"].as<bool>(), result["memory"].as<int>());
+      ++printed;
+    }
+
+    std::this_thread::sleep_for(interval);
+  }
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
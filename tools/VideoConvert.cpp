@@ -0,0 +1,88 @@
+#include <iostream>
+#include <exception>
+#include <memory>
+#include <fstream>
+
+#include <cxxopts.hpp>
+
+#include "VideoReader.hpp"
+#include "FrameDumper.hpp"
+
+/**
+ * Converts a video recorded with « chip8 --record-video » into an image sequence or raw frames.
+ */
+int main(int argc, char **argv) try {
+  /* Command-line */
+
+  cxxopts::Options options("chip8-video", "Convert a Chip8 video recording");
+  options.positional_help("VIDEO").show_positional_help();
+
+  // clang-format off
+  options.add_options()
+      ("h,help", "Show help")
+      ("v,video", "Path to a recording", cxxopts::value<std::string>(), "VIDEO")
+      ("o,output", "Output directory for images, or output file for raw frames", cxxopts::value<std::string>()->default_value("."), "PATH")
+      ("f,format", "Output format: png, ppm or raw (2048 bytes per frame, one byte per pixel)", cxxopts::value<std::string>()->default_value("png"), "FORMAT")
+      ("pixel-size", "Size of a Chip8 pixel in images", cxxopts::value<int>()->default_value("5"), "N")
+      ("fill", "Repeat frames so there is one output frame per emulated frame");
+  ;
+  // clang-format on
+
+  options.parse_positional({"video"});
+
+  auto result = options.parse(argc, argv);
+
+  if (result["help"].as<bool>() || !result.count("video")) {
+      std::cout << options.help();
+      return 0;
+  }
+
+  VideoReader reader(result["video"].as<std::string>());
+
+  const std::string format = result["format"].as<std::string>();
+  const std::string output = result["output"].as<std::string>();
+  const bool fill = result["fill"].as<bool>();
+
+  std::ofstream raw;
+  std::unique_ptr<FrameDumper> dumper;
+
+  if (format == "raw") {
+    raw.open(output, std::ios::out | std::ios::binary);
+    if (!raw)
+      throw std::runtime_error("Not be able to write " + output + "!");
+  } else {
+    dumper = std::make_unique<FrameDumper>(SoftwareRenderer(result["pixel-size"].as<int>()), output,
+                                           FrameDumper::ParseFormat(format));
+  }
+
+  auto write = [&](const Framebuffer &frame, uint64_t number) {
+    if (dumper)
+      dumper->Dump(frame, number);
+    else
+      raw.write(reinterpret_cast<const char *>(frame.pixels), sizeof(frame.pixels));
+  };
+
+  Framebuffer frame, previous = {};
+  uint64_t number, last = 0, count = 0;
+
+  while (reader.Next(frame, number)) {
+    // Frames between two records are identical to the previous record
+    if (fill && count > 0) {
+      for (uint64_t i = last + 1; i < number; ++i, ++count)
+        write(previous, i);
+    }
+
+    write(frame, number);
+    ++count;
+
+    previous = frame;
+    last = number;
+  }
+
+  std::cout << count << " frames written." << std::endl;
+
+  return 0;
+} catch (const std::exception &e) {
+  std::cout << e.what() << std::endl;
+  return 1;
+}
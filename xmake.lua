@@ -40,6 +40,82 @@ add_requires("cxxopts")     -- Command-line parser
 -- add a dependencies lock file
 set_policy("package.requires_lock", true)
 
+-- coverage-guided fuzzing of the core (clang only)
+option("fuzzer")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Build the core with libFuzzer, AddressSanitizer and UndefinedBehaviorSanitizer")
+option_end()
+
+-- headless core, shared by the emulator and the tools
+target("chip8-core")
+    set_kind("static")
+
+    -- add source file
+    add_files("src/Chip8.cpp",
+              "src/Chip8Cached.cpp",
+              "src/Decode.cpp",
+              "src/Analysis.cpp",
+              "src/Aot.cpp",
+              "src/AotTranslator.cpp",
+              "src/DecodeStore.cpp",
+              "src/RomStore.cpp",
+              "src/Arena.cpp",
+              "src/InstancePool.cpp",
+              "src/Metrics.cpp",
+              "src/MetricsExporter.cpp",
+              "src/StateExporter.cpp",
+              "src/RamSearch.cpp",
+              "src/Cheats.cpp",
+              "src/GdbStub.cpp",
+              "src/UdpLink.cpp",
+              "src/Rollback.cpp",
+              "src/Emulator.cpp",
+              "src/Pacer.cpp",
+              "src/Keypad.cpp",
+              "src/SoftwareRenderer.cpp",
+              "src/FrameDumper.cpp",
+              "src/VideoRecorder.cpp",
+              "src/VideoReader.cpp",
+              "src/ThreadPool.cpp")
+    add_includedirs("include/", {public = true})
+
+    -- generate the version header, the decode store is invalidated when the version changes
+    set_configdir("$(buildir)/config")
+    add_configfiles("include/Version.hpp.in")
+    add_includedirs("$(buildir)/config", {public = true})
+
+    -- the emulation and the video encoder run on their own thread
+    if is_plat("linux") then
+        add_syslinks("pthread", {public = true})
+    end
+
+    -- the state is exported with shm_open, in librt before glibc 2.34
+    if is_plat("linux") then
+        add_syslinks("rt", {public = true})
+    end
+
+    -- the debugger stub listens on a TCP socket, the rollback sessions talk over UDP
+    if is_plat("windows") then
+        add_syslinks("ws2_32", {public = true})
+    end
+
+    -- instrument the core for chip8-fuzz
+    if has_config("fuzzer") then
+        add_cxflags("-fsanitize=fuzzer-no-link,address,undefined", {force = true})
+        add_ldflags("-fsanitize=address,undefined", {public = true, force = true})
+    end
+
+-- reader of the shared memory export, for tools outside of the emulator, without the core
+target("chip8-state-reader")
+    set_kind("static")
+    add_files("src/StateReader.cpp")
+    add_includedirs("include/", {public = true})
+
+    if is_plat("linux") then
+        add_syslinks("pthread", "rt", {public = true})
+    end
+
 -- target
 target("chip8")
     set_kind("binary")
@@ -50,8 +126,95 @@ target("chip8")
     add_files("shaders/*.frag")
 
     -- add source file
-    add_files("src/*.cpp")
-    add_includedirs("include/")
+    add_files("src/Main.cpp",
+              "src/Window.cpp",
+              "src/Context.cpp",
+              "src/Audio.cpp",
+              "src/StartupTrace.cpp",
+              "src/Renderer.cpp",
+              "src/WallRenderer.cpp",
+              "src/Shader.cpp")
+    add_deps("chip8-core", "chip8-state-reader")
 
     -- add dependencies
-    add_packages("glfw", "glew", "glm", "openal-soft", "cxxopts")
\ No newline at end of file
+    add_packages("glfw", "glew", "glm", "openal-soft", "cxxopts")
+
+-- golden-frame conformance harness
+target("chip8-conformance")
+    set_kind("binary")
+    add_files("tools/Conformance.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- differential lockstep checker between backends
+target("chip8-lockstep")
+    set_kind("binary")
+    add_files("tools/Lockstep.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- parallel exploration of forked instances
+target("chip8-explore")
+    set_kind("binary")
+    add_files("tools/Explore.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- static analyser and disassembler
+target("chip8-disasm")
+    set_kind("binary")
+    add_files("tools/Disasm.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- ahead-of-time translator of a ROM into C++
+target("chip8-aot")
+    set_kind("binary")
+    add_files("tools/Aot.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- throughput of the translated ROMs in tests/aot against the interpreter, regenerate them with chip8-aot
+target("chip8-aot-bench")
+    set_kind("binary")
+    add_files("tools/AotBench.cpp", "tests/aot/*.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- two-player rollback session over UDP on the loopback
+target("chip8-netplay")
+    set_kind("binary")
+    add_files("tools/Netplay.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- video recording converter
+target("chip8-video")
+    set_kind("binary")
+    add_files("tools/VideoConvert.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- memory search and cheat finder
+target("chip8-search")
+    set_kind("binary")
+    add_files("tools/Search.cpp")
+    add_deps("chip8-core")
+    add_packages("cxxopts")
+
+-- example consumer of the shared memory export
+target("chip8-watch")
+    set_kind("binary")
+    add_files("tools/StateWatch.cpp")
+    add_deps("chip8-state-reader")
+    add_packages("cxxopts")
+
+-- libFuzzer harness of the core, both backends
+if has_config("fuzzer") then
+    target("chip8-fuzz")
+        set_kind("binary")
+        add_files("tools/Fuzz.cpp")
+        add_deps("chip8-core")
+        add_cxflags("-fsanitize=fuzzer,address,undefined", {force = true})
+        add_ldflags("-fsanitize=fuzzer,address,undefined", {force = true})
+end